@@ -0,0 +1,145 @@
+/*
+ * @file bench_splay.c
+ * @author Valerio Bellizia
+ *
+ * This program compares ds_bst (AVL) and ds_splay on lookups whose keys follow a Zipf distribution.
+ * Usage: bench_splay [elements] [lookups] [exponent]
+ */
+
+#include <ds/bst.h>
+#include <ds/splay.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+static unsigned long long comparisons = 0;
+
+static int counting_cmp(const void* a, const void* b) {
+	comparisons++;
+	int ia = *(const int*)a;
+	int ib = *(const int*)b;
+
+	return (ia > ib) - (ia < ib);
+}
+
+// a xorshift generator, so that the trace is the same everywhere
+static unsigned long long next_random(unsigned long long* state) {
+	*state ^= *state << 13;
+	*state ^= *state >> 7;
+	*state ^= *state << 17;
+
+	return *state;
+}
+
+// it builds a trace where the i-th most popular key is drawn with probability proportional to 1 / i^exponent
+static int* zipf_trace(const int* keys, const size_t elements, const size_t lookups, const double exponent) {
+	double* cdf = (double*) malloc(elements * sizeof(double));
+	int* trace = (int*) malloc(lookups * sizeof(int));
+	if (cdf == NULL || trace == NULL) {
+		free(cdf);
+		free(trace);
+		return NULL;
+	}
+
+	double total = 0;
+	for (size_t i = 0; i < elements; ++i) {
+		total += 1.0 / pow((double)(i + 1), exponent);
+		cdf[i] = total;
+	}
+
+	unsigned long long state = 88172645463325252ULL;
+	for (size_t i = 0; i < lookups; ++i) {
+		double u = (double)(next_random(&state) >> 11) / (double)(1ULL << 53) * total;
+
+		size_t lo = 0;
+		size_t hi = elements - 1;
+		while (lo < hi) {
+			size_t mid = lo + (hi - lo) / 2;
+			if (cdf[mid] < u)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		trace[i] = keys[lo];
+	}
+
+	free(cdf);
+	return trace;
+}
+
+static double elapsed(clock_t start) {
+	return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char** argv) {
+	size_t elements = (argc > 1) ? (size_t) atol(argv[1]) : 1000000;
+	size_t lookups = (argc > 2) ? (size_t) atol(argv[2]) : 10000000;
+	double exponent = (argc > 3) ? atof(argv[3]) : 0.99;
+
+	// the trace is drawn from the keys, there must be at least one, and the averages need at least one lookup
+	if (elements == 0 || lookups == 0) {
+		fprintf(stderr, "usage: bench_splay [elements] [lookups] [exponent], elements and lookups must be at least 1\n");
+		return 1;
+	}
+
+	// popularity ranks are shuffled over the keys, so hot keys are spread across the tree
+	int* keys = (int*) malloc(elements * sizeof(int));
+	if (keys == NULL)
+		return 1;
+	for (size_t i = 0; i < elements; ++i)
+		keys[i] = (int) i;
+
+	unsigned long long state = 2463534242ULL;
+	for (size_t i = elements - 1; i > 0; --i) {
+		size_t j = (size_t)(next_random(&state) % (i + 1));
+		int tmp = keys[i];
+		keys[i] = keys[j];
+		keys[j] = tmp;
+	}
+
+	int* trace = zipf_trace(keys, elements, lookups, exponent);
+	if (trace == NULL) {
+		free(keys);
+		return 1;
+	}
+
+	// the insertion order affects the depth of the keys in both trees, so it must not follow the popularity
+	for (size_t i = elements - 1; i > 0; --i) {
+		size_t j = (size_t)(next_random(&state) % (i + 1));
+		int tmp = keys[i];
+		keys[i] = keys[j];
+		keys[j] = tmp;
+	}
+
+	ds_bst* avl = create_ds_bst(counting_cmp, sizeof(int));
+	ds_splay* splay = create_ds_splay(counting_cmp, sizeof(int));
+	for (size_t i = 0; i < elements; ++i) {
+		ds_bst_insert(avl, &keys[i]);
+		ds_splay_insert(splay, &keys[i]);
+	}
+
+	printf("%zu elements, %zu lookups, zipf exponent %.2f\n", elements, lookups, exponent);
+
+	size_t found = 0;
+	comparisons = 0;
+	clock_t start = clock();
+	for (size_t i = 0; i < lookups; ++i)
+		found += ds_bst_search(avl, &trace[i]);
+	printf("avl:   %.3f s, %.2f comparisons per lookup, %zu found\n", elapsed(start), (double) comparisons / lookups, found);
+
+	found = 0;
+	comparisons = 0;
+	start = clock();
+	for (size_t i = 0; i < lookups; ++i)
+		found += ds_splay_search(splay, &trace[i]);
+	printf("splay: %.3f s, %.2f comparisons per lookup, %zu found\n", elapsed(start), (double) comparisons / lookups, found);
+
+	delete_ds_bst(avl);
+	delete_ds_splay(splay);
+	free(trace);
+	free(keys);
+
+	return 0;
+}
@@ -0,0 +1,1112 @@
+/*
+ * @file art.c
+ * @author Valerio Bellizia
+ */
+
+#include "art.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define ART_HAS_SSE2
+#endif
+
+#define NODE4 0
+#define NODE16 1
+#define NODE48 2
+#define NODE256 3
+
+// the number of prefix bytes stored in a node, longer prefixes are read from a leaf below the node
+#define MAX_PREFIX 10
+
+// leaves are told apart from inner nodes by the lowest bit of the pointer (allocations are at least 2-aligned)
+#define IS_LEAF(PTR) (((uintptr_t)(PTR)) & 1)
+#define TAG_LEAF(LEAF) ((void*)((uintptr_t)(LEAF) | 1))
+#define AS_LEAF(PTR) ((art_leaf*)((uintptr_t)(PTR) & ~(uintptr_t)1))
+
+// a leaf is laid out as [art_leaf | key | padding | value], the value is kept aligned for any type
+#define VALUE_ALIGN 16
+#define LEAF_KEY(LEAF) ((unsigned char*)((LEAF) + 1))
+#define LEAF_VALUE_OFFSET(KEY_LEN) (((sizeof(art_leaf) + (KEY_LEN) + VALUE_ALIGN - 1) / VALUE_ALIGN) * VALUE_ALIGN)
+#define LEAF_VALUE(LEAF) ((char*)(LEAF) + LEAF_VALUE_OFFSET((LEAF)->key_len))
+
+#define MIN(A, B) (((A) < (B)) ? (A) : (B))
+
+// struct definitions
+
+typedef struct art_leaf {
+	size_t key_len;
+} art_leaf;
+
+/*
+ * A node consumes prefix_len bytes of the key (the compressed path), then one more byte to choose
+ * a child. The key ending right after the prefix is stored in leaf, it comes before the children.
+ */
+typedef struct art_node {
+	uint8_t type;
+	uint16_t num_children;
+	uint32_t prefix_len;
+	unsigned char prefix[MAX_PREFIX];
+	art_leaf* leaf;
+} art_node;
+
+// keys are sorted
+typedef struct art_node4 {
+	art_node n;
+	unsigned char keys[4];
+	void* children[4];
+} art_node4;
+
+// keys are sorted, they are compared all at once with SSE2
+typedef struct art_node16 {
+	art_node n;
+	unsigned char keys[16];
+	void* children[16];
+} art_node16;
+
+// index maps a byte to the position of its child plus one, 0 means no child
+typedef struct art_node48 {
+	art_node n;
+	unsigned char index[256];
+	void* children[48];
+} art_node48;
+
+typedef struct art_node256 {
+	art_node n;
+	void* children[256];
+} art_node256;
+
+struct ds_art {
+	void* root;
+	size_t size;
+	size_t value_len;
+};
+
+/*
+ * The iterator walks the tree with a stack of nodes. pos is -1 before the leaf of the node has been
+ * visited, then it is the next position (Node4 and Node16) or the next byte (Node48 and Node256).
+ * A range iterator stops before the first key that is not smaller than end.
+ */
+struct art_frame {
+	art_node* node;
+	int pos;
+};
+
+struct ds_art_iterator {
+	art_leaf* current;
+	size_t depth;
+	size_t capacity;
+	struct art_frame* stack;
+	int failed;
+	int bounded;
+	unsigned char* end;
+	size_t end_len;
+};
+
+// helpers
+
+static unsigned trailing_zeros(unsigned mask) {
+#if defined(__GNUC__) || defined(__clang__)
+	return (unsigned) __builtin_ctz(mask);
+#else
+	unsigned count = 0;
+	while (!(mask & 1)) {
+		mask >>= 1;
+		count++;
+	}
+	return count;
+#endif
+}
+
+static art_leaf* create_leaf(const unsigned char* key, size_t key_len, const void* v, size_t value_len) {
+	art_leaf* leaf = (art_leaf*) malloc(LEAF_VALUE_OFFSET(key_len) + value_len);
+	if (leaf == NULL)
+		return NULL;
+
+	leaf->key_len = key_len;
+	memcpy(LEAF_KEY(leaf), key, key_len);
+	if (v != NULL)
+		memcpy(LEAF_VALUE(leaf), v, value_len);
+	else
+		memset(LEAF_VALUE(leaf), 0, value_len);
+
+	return leaf;
+}
+
+static int leaf_matches(const art_leaf* leaf, const unsigned char* key, size_t key_len) {
+	return leaf->key_len == key_len && memcmp(LEAF_KEY(leaf), key, key_len) == 0;
+}
+
+// it compares the key of a leaf with a key, a key comes before the longer keys it is a prefix of
+static int leaf_cmp(const art_leaf* leaf, const unsigned char* key, size_t key_len) {
+	int res = memcmp(LEAF_KEY(leaf), key, MIN(leaf->key_len, key_len));
+	if (res != 0)
+		return res;
+
+	return (leaf->key_len < key_len) ? -1 : (leaf->key_len > key_len);
+}
+
+static art_node* create_node(uint8_t type) {
+	size_t size;
+	switch (type) {
+		case NODE4: size = sizeof(art_node4); break;
+		case NODE16: size = sizeof(art_node16); break;
+		case NODE48: size = sizeof(art_node48); break;
+		default: size = sizeof(art_node256); break;
+	}
+
+	art_node* n = (art_node*) calloc(1, size);
+	if (n != NULL)
+		n->type = type;
+
+	return n;
+}
+
+static void copy_header(art_node* dst, const art_node* src) {
+	dst->num_children = src->num_children;
+	dst->prefix_len = src->prefix_len;
+	memcpy(dst->prefix, src->prefix, MIN(src->prefix_len, MAX_PREFIX));
+	dst->leaf = src->leaf;
+}
+
+static void free_tree(void* node) {
+	if (node == NULL)
+		return;
+
+	if (IS_LEAF(node)) {
+		free(AS_LEAF(node));
+		return;
+	}
+
+	art_node* n = (art_node*) node;
+	switch (n->type) {
+		case NODE4:
+			for (int i = 0; i < n->num_children; ++i)
+				free_tree(((art_node4*) n)->children[i]);
+			break;
+		case NODE16:
+			for (int i = 0; i < n->num_children; ++i)
+				free_tree(((art_node16*) n)->children[i]);
+			break;
+		case NODE48:
+			for (int i = 0; i < 48; ++i)
+				free_tree(((art_node48*) n)->children[i]);
+			break;
+		default:
+			for (int i = 0; i < 256; ++i)
+				free_tree(((art_node256*) n)->children[i]);
+			break;
+	}
+
+	free(n->leaf);
+	free(n);
+}
+
+static void** find_child(art_node* n, unsigned char c) {
+	switch (n->type) {
+		case NODE4: {
+			art_node4* n4 = (art_node4*) n;
+			for (int i = 0; i < n->num_children; ++i) {
+				if (n4->keys[i] == c)
+					return &n4->children[i];
+			}
+			return NULL;
+		}
+		case NODE16: {
+			art_node16* n16 = (art_node16*) n;
+#ifdef ART_HAS_SSE2
+			__m128i cmp = _mm_cmpeq_epi8(_mm_set1_epi8((char) c), _mm_loadu_si128((const __m128i*) n16->keys));
+			unsigned mask = (unsigned) _mm_movemask_epi8(cmp) & ((1u << n->num_children) - 1);
+			return mask ? &n16->children[trailing_zeros(mask)] : NULL;
+#else
+			for (int i = 0; i < n->num_children; ++i) {
+				if (n16->keys[i] == c)
+					return &n16->children[i];
+			}
+			return NULL;
+#endif
+		}
+		case NODE48: {
+			art_node48* n48 = (art_node48*) n;
+			return n48->index[c] ? &n48->children[n48->index[c] - 1] : NULL;
+		}
+		default: {
+			art_node256* n256 = (art_node256*) n;
+			return n256->children[c] != NULL ? &n256->children[c] : NULL;
+		}
+	}
+}
+
+// it returns the smallest leaf below a node, every leaf below a node shares its prefix
+static art_leaf* min_leaf(void* node) {
+	while (!IS_LEAF(node)) {
+		art_node* n = (art_node*) node;
+		if (n->leaf != NULL)
+			return n->leaf;
+
+		switch (n->type) {
+			case NODE4:
+				node = ((art_node4*) n)->children[0];
+				break;
+			case NODE16:
+				node = ((art_node16*) n)->children[0];
+				break;
+			case NODE48: {
+				art_node48* n48 = (art_node48*) n;
+				int c = 0;
+				while (!n48->index[c])
+					c++;
+				node = n48->children[n48->index[c] - 1];
+				break;
+			}
+			default: {
+				art_node256* n256 = (art_node256*) n;
+				int c = 0;
+				while (n256->children[c] == NULL)
+					c++;
+				node = n256->children[c];
+				break;
+			}
+		}
+	}
+
+	return AS_LEAF(node);
+}
+
+// it returns how many bytes of the prefix of n match the key from depth on
+static size_t prefix_mismatch(art_node* n, const unsigned char* key, size_t key_len, size_t depth) {
+	size_t max_cmp = MIN((size_t) n->prefix_len, key_len - depth);
+	const unsigned char* prefix = n->prefix;
+	if (n->prefix_len > MAX_PREFIX)
+		prefix = LEAF_KEY(min_leaf(n)) + depth;
+
+	size_t i = 0;
+	while (i < max_cmp && prefix[i] == key[depth + i])
+		i++;
+
+	return i;
+}
+
+static void add_sorted(unsigned char* keys, void** children, int num_children, unsigned char c, void* child) {
+	int i = 0;
+	while (i < num_children && keys[i] < c)
+		i++;
+
+	memmove(keys + i + 1, keys + i, num_children - i);
+	memmove(children + i + 1, children + i, (num_children - i) * sizeof(void*));
+	keys[i] = c;
+	children[i] = child;
+}
+
+// it adds a child to the node referenced by ref, the node is replaced by a bigger one when it is full
+static ds_result add_child(void** ref, art_node* n, unsigned char c, void* child) {
+	switch (n->type) {
+		case NODE4: {
+			art_node4* n4 = (art_node4*) n;
+			if (n->num_children < 4) {
+				add_sorted(n4->keys, n4->children, n->num_children, c, child);
+				n->num_children++;
+				return SUCCESS;
+			}
+
+			art_node16* n16 = (art_node16*) create_node(NODE16);
+			if (n16 == NULL)
+				return GENERIC_ERROR;
+			copy_header(&n16->n, n);
+			memcpy(n16->keys, n4->keys, 4);
+			memcpy(n16->children, n4->children, 4 * sizeof(void*));
+			*ref = n16;
+			free(n);
+			return add_child(ref, &n16->n, c, child);
+		}
+		case NODE16: {
+			art_node16* n16 = (art_node16*) n;
+			if (n->num_children < 16) {
+				add_sorted(n16->keys, n16->children, n->num_children, c, child);
+				n->num_children++;
+				return SUCCESS;
+			}
+
+			art_node48* n48 = (art_node48*) create_node(NODE48);
+			if (n48 == NULL)
+				return GENERIC_ERROR;
+			copy_header(&n48->n, n);
+			for (int i = 0; i < 16; ++i) {
+				n48->children[i] = n16->children[i];
+				n48->index[n16->keys[i]] = (unsigned char) (i + 1);
+			}
+			*ref = n48;
+			free(n);
+			return add_child(ref, &n48->n, c, child);
+		}
+		case NODE48: {
+			art_node48* n48 = (art_node48*) n;
+			if (n->num_children < 48) {
+				// removals leave holes, so the first free slot is looked for
+				int pos = 0;
+				while (n48->children[pos] != NULL)
+					pos++;
+				n48->children[pos] = child;
+				n48->index[c] = (unsigned char) (pos + 1);
+				n->num_children++;
+				return SUCCESS;
+			}
+
+			art_node256* n256 = (art_node256*) create_node(NODE256);
+			if (n256 == NULL)
+				return GENERIC_ERROR;
+			copy_header(&n256->n, n);
+			for (int b = 0; b < 256; ++b) {
+				if (n48->index[b])
+					n256->children[b] = n48->children[n48->index[b] - 1];
+			}
+			*ref = n256;
+			free(n);
+			return add_child(ref, &n256->n, c, child);
+		}
+		default: {
+			art_node256* n256 = (art_node256*) n;
+			n256->children[c] = child;
+			n->num_children++;
+			return SUCCESS;
+		}
+	}
+}
+
+/*
+ * A Node4 left with a single entry is removed: a lone leaf takes its place, while a lone child
+ * takes its place by prepending the prefix of the node and the byte leading to it to its own prefix.
+ */
+static void collapse(void** ref) {
+	art_node4* n4 = (art_node4*) *ref;
+	art_node* n = &n4->n;
+
+	if (n->num_children == 0 && n->leaf != NULL) {
+		*ref = TAG_LEAF(n->leaf);
+		free(n);
+		return;
+	}
+
+	if (n->num_children != 1 || n->leaf != NULL)
+		return;
+
+	void* child = n4->children[0];
+	if (!IS_LEAF(child)) {
+		art_node* c = (art_node*) child;
+		unsigned char merged[MAX_PREFIX];
+		size_t len = MIN((size_t) n->prefix_len, MAX_PREFIX);
+		memcpy(merged, n->prefix, len);
+		if (len < MAX_PREFIX)
+			merged[len++] = n4->keys[0];
+		if (len < MAX_PREFIX) {
+			size_t from_child = MIN((size_t) c->prefix_len, MAX_PREFIX - len);
+			memcpy(merged + len, c->prefix, from_child);
+			len += from_child;
+		}
+
+		c->prefix_len += n->prefix_len + 1;
+		memcpy(c->prefix, merged, len);
+	}
+
+	*ref = child;
+	free(n);
+}
+
+// nodes are replaced by smaller ones well below their capacity, so that a node does not grow and shrink back and forth
+static void shrink(void** ref) {
+	art_node* n = (art_node*) *ref;
+	switch (n->type) {
+		case NODE16: {
+			art_node16* n16 = (art_node16*) n;
+			if (n->num_children > 3)
+				return;
+
+			art_node4* n4 = (art_node4*) create_node(NODE4);
+			if (n4 == NULL)
+				return;
+			copy_header(&n4->n, n);
+			memcpy(n4->keys, n16->keys, n->num_children);
+			memcpy(n4->children, n16->children, n->num_children * sizeof(void*));
+			*ref = n4;
+			free(n);
+			return;
+		}
+		case NODE48: {
+			art_node48* n48 = (art_node48*) n;
+			if (n->num_children > 12)
+				return;
+
+			art_node16* n16 = (art_node16*) create_node(NODE16);
+			if (n16 == NULL)
+				return;
+			copy_header(&n16->n, n);
+			int pos = 0;
+			for (int b = 0; b < 256; ++b) {
+				if (n48->index[b]) {
+					n16->keys[pos] = (unsigned char) b;
+					n16->children[pos] = n48->children[n48->index[b] - 1];
+					pos++;
+				}
+			}
+			*ref = n16;
+			free(n);
+			return;
+		}
+		case NODE256: {
+			art_node256* n256 = (art_node256*) n;
+			if (n->num_children > 37)
+				return;
+
+			art_node48* n48 = (art_node48*) create_node(NODE48);
+			if (n48 == NULL)
+				return;
+			copy_header(&n48->n, n);
+			int pos = 0;
+			for (int b = 0; b < 256; ++b) {
+				if (n256->children[b] != NULL) {
+					n48->children[pos] = n256->children[b];
+					n48->index[b] = (unsigned char) (pos + 1);
+					pos++;
+				}
+			}
+			*ref = n48;
+			free(n);
+			return;
+		}
+		default:
+			collapse(ref);
+			return;
+	}
+}
+
+static void remove_child(void** ref, art_node* n, unsigned char c, void** child) {
+	switch (n->type) {
+		case NODE4: {
+			art_node4* n4 = (art_node4*) n;
+			int pos = (int) (child - n4->children);
+			memmove(n4->keys + pos, n4->keys + pos + 1, n->num_children - pos - 1);
+			memmove(n4->children + pos, n4->children + pos + 1, (n->num_children - pos - 1) * sizeof(void*));
+			break;
+		}
+		case NODE16: {
+			art_node16* n16 = (art_node16*) n;
+			int pos = (int) (child - n16->children);
+			memmove(n16->keys + pos, n16->keys + pos + 1, n->num_children - pos - 1);
+			memmove(n16->children + pos, n16->children + pos + 1, (n->num_children - pos - 1) * sizeof(void*));
+			break;
+		}
+		case NODE48: {
+			art_node48* n48 = (art_node48*) n;
+			n48->children[n48->index[c] - 1] = NULL;
+			n48->index[c] = 0;
+			break;
+		}
+		default:
+			((art_node256*) n)->children[c] = NULL;
+			break;
+	}
+
+	n->num_children--;
+	shrink(ref);
+}
+
+// it returns the leaf holding the key, existed tells if it was already there (and its value is replaced if replace is set)
+static art_leaf* insert_key(ds_art* art, const unsigned char* key, size_t key_len, const void* v, int replace, int* existed) {
+	void** ref = &art->root;
+	size_t depth = 0;
+	*existed = 0;
+
+	for (;;) {
+		void* node = *ref;
+		if (node == NULL) {
+			art_leaf* leaf = create_leaf(key, key_len, v, art->value_len);
+			if (leaf != NULL)
+				*ref = TAG_LEAF(leaf);
+			return leaf;
+		}
+
+		if (IS_LEAF(node)) {
+			art_leaf* l = AS_LEAF(node);
+			if (leaf_matches(l, key, key_len)) {
+				*existed = 1;
+				if (replace)
+					memcpy(LEAF_VALUE(l), v, art->value_len);
+				return l;
+			}
+
+			// the two keys share the bytes up to common, a new node splits them there
+			size_t limit = MIN(l->key_len, key_len);
+			size_t common = depth;
+			while (common < limit && LEAF_KEY(l)[common] == key[common])
+				common++;
+
+			art_node4* n4 = (art_node4*) create_node(NODE4);
+			art_leaf* leaf = create_leaf(key, key_len, v, art->value_len);
+			if (n4 == NULL || leaf == NULL) {
+				free(n4);
+				free(leaf);
+				return NULL;
+			}
+
+			n4->n.prefix_len = (uint32_t) (common - depth);
+			memcpy(n4->n.prefix, key + depth, MIN(common - depth, MAX_PREFIX));
+			if (l->key_len == common)
+				n4->n.leaf = l;
+			else
+				add_child(ref, &n4->n, LEAF_KEY(l)[common], node);
+			if (key_len == common)
+				n4->n.leaf = leaf;
+			else
+				add_child(ref, &n4->n, key[common], TAG_LEAF(leaf));
+
+			*ref = n4;
+			return leaf;
+		}
+
+		art_node* n = (art_node*) node;
+		if (n->prefix_len > 0) {
+			size_t p = prefix_mismatch(n, key, key_len, depth);
+			if (p < n->prefix_len) {
+				// the key leaves the compressed path at p, a new node takes the matching part of the prefix
+				art_node4* n4 = (art_node4*) create_node(NODE4);
+				art_leaf* leaf = create_leaf(key, key_len, v, art->value_len);
+				if (n4 == NULL || leaf == NULL) {
+					free(n4);
+					free(leaf);
+					return NULL;
+				}
+
+				n4->n.prefix_len = (uint32_t) p;
+				memcpy(n4->n.prefix, key + depth, MIN(p, MAX_PREFIX));
+
+				unsigned char edge;
+				if (n->prefix_len <= MAX_PREFIX) {
+					edge = n->prefix[p];
+					n->prefix_len -= (uint32_t) (p + 1);
+					memmove(n->prefix, n->prefix + p + 1, n->prefix_len);
+				}
+				else {
+					const unsigned char* full = LEAF_KEY(min_leaf(n)) + depth;
+					edge = full[p];
+					n->prefix_len -= (uint32_t) (p + 1);
+					memcpy(n->prefix, full + p + 1, MIN((size_t) n->prefix_len, MAX_PREFIX));
+				}
+
+				add_child(ref, &n4->n, edge, n);
+				if (key_len == depth + p)
+					n4->n.leaf = leaf;
+				else
+					add_child(ref, &n4->n, key[depth + p], TAG_LEAF(leaf));
+
+				*ref = n4;
+				return leaf;
+			}
+			depth += n->prefix_len;
+		}
+
+		if (depth == key_len) {
+			if (n->leaf != NULL) {
+				*existed = 1;
+				if (replace)
+					memcpy(LEAF_VALUE(n->leaf), v, art->value_len);
+				return n->leaf;
+			}
+
+			n->leaf = create_leaf(key, key_len, v, art->value_len);
+			return n->leaf;
+		}
+
+		void** child = find_child(n, key[depth]);
+		if (child != NULL) {
+			ref = child;
+			depth++;
+			continue;
+		}
+
+		art_leaf* leaf = create_leaf(key, key_len, v, art->value_len);
+		if (leaf == NULL || add_child(ref, n, key[depth], TAG_LEAF(leaf)) != SUCCESS) {
+			free(leaf);
+			return NULL;
+		}
+		return leaf;
+	}
+}
+
+// it unlinks the leaf holding the key and returns it, NULL if the key does not exist
+static art_leaf* remove_key(ds_art* art, const unsigned char* key, size_t key_len) {
+	void** ref = &art->root;
+	size_t depth = 0;
+
+	for (;;) {
+		void* node = *ref;
+		if (node == NULL)
+			return NULL;
+
+		if (IS_LEAF(node)) {
+			art_leaf* l = AS_LEAF(node);
+			if (!leaf_matches(l, key, key_len))
+				return NULL;
+
+			*ref = NULL;
+			return l;
+		}
+
+		art_node* n = (art_node*) node;
+		if (n->prefix_len > 0) {
+			if (prefix_mismatch(n, key, key_len, depth) != n->prefix_len)
+				return NULL;
+			depth += n->prefix_len;
+		}
+
+		if (depth == key_len) {
+			art_leaf* l = n->leaf;
+			if (l == NULL || !leaf_matches(l, key, key_len))
+				return NULL;
+
+			n->leaf = NULL;
+			if (n->type == NODE4)
+				collapse(ref);
+			return l;
+		}
+
+		void** child = find_child(n, key[depth]);
+		if (child == NULL)
+			return NULL;
+
+		if (IS_LEAF(*child)) {
+			art_leaf* l = AS_LEAF(*child);
+			if (!leaf_matches(l, key, key_len))
+				return NULL;
+
+			remove_child(ref, n, key[depth], child);
+			return l;
+		}
+
+		ref = child;
+		depth++;
+	}
+}
+
+// iterator helpers
+
+// it returns the next child of the node on top of the stack, NULL when there are no more children
+static void* next_child(struct art_frame* f) {
+	art_node* n = f->node;
+	switch (n->type) {
+		case NODE4:
+			return (f->pos < n->num_children) ? ((art_node4*) n)->children[f->pos++] : NULL;
+		case NODE16:
+			return (f->pos < n->num_children) ? ((art_node16*) n)->children[f->pos++] : NULL;
+		case NODE48: {
+			art_node48* n48 = (art_node48*) n;
+			while (f->pos < 256) {
+				int c = f->pos++;
+				if (n48->index[c])
+					return n48->children[n48->index[c] - 1];
+			}
+			return NULL;
+		}
+		default: {
+			art_node256* n256 = (art_node256*) n;
+			while (f->pos < 256) {
+				int c = f->pos++;
+				if (n256->children[c] != NULL)
+					return n256->children[c];
+			}
+			return NULL;
+		}
+	}
+}
+
+// it pushes a node on the stack, it returns 1 if the node is a leaf (which becomes the current one)
+static int push(ds_art_iterator* it, void* node) {
+	if (IS_LEAF(node)) {
+		it->current = AS_LEAF(node);
+		return 1;
+	}
+
+	if (it->depth == it->capacity) {
+		size_t capacity = (it->capacity > 0) ? it->capacity * 2 : 16;
+		struct art_frame* stack = (struct art_frame*) realloc(it->stack, capacity * sizeof(struct art_frame));
+		if (stack == NULL) {
+			// the iteration cannot go on, ds_art_iterator_failed tells it apart from the end of the keys
+			it->current = NULL;
+			it->depth = 0;
+			it->failed = 1;
+			return 1;
+		}
+		it->stack = stack;
+		it->capacity = capacity;
+	}
+
+	it->stack[it->depth].node = (art_node*) node;
+	it->stack[it->depth].pos = -1;
+	it->depth++;
+
+	return 0;
+}
+
+static void step(ds_art_iterator* it) {
+	it->current = NULL;
+	while (it->depth > 0) {
+		struct art_frame* f = &it->stack[it->depth - 1];
+		if (f->pos == -1) {
+			f->pos = 0;
+			if (f->node->leaf != NULL) {
+				it->current = f->node->leaf;
+				return;
+			}
+		}
+
+		void* child = next_child(f);
+		if (child == NULL)
+			it->depth--;
+		else if (push(it, child))
+			return;
+	}
+}
+
+// it ends a range iteration once the current key reaches the end of the range
+static void check_end(ds_art_iterator* it) {
+	if (it->bounded && it->current != NULL && leaf_cmp(it->current, it->end, it->end_len) >= 0) {
+		it->current = NULL;
+		it->depth = 0;
+	}
+}
+
+static void advance(ds_art_iterator* it) {
+	step(it);
+	check_end(it);
+}
+
+static ds_art_iterator* alloc_iterator() {
+	ds_art_iterator* it = (ds_art_iterator*) malloc(sizeof(ds_art_iterator));
+	if (it == NULL)
+		return NULL;
+
+	it->current = NULL;
+	it->depth = 0;
+	it->capacity = 0;
+	it->stack = NULL;
+	it->failed = 0;
+	it->bounded = 0;
+	it->end = NULL;
+	it->end_len = 0;
+
+	return it;
+}
+
+static ds_art_iterator* create_iterator(void* root) {
+	ds_art_iterator* it = alloc_iterator();
+	if (it == NULL)
+		return NULL;
+
+	if (root != NULL && !push(it, root))
+		advance(it);
+
+	return it;
+}
+
+// it returns the position of the first child of n whose byte is bigger than c
+static int position_after(art_node* n, unsigned char c) {
+	if (n->type == NODE48 || n->type == NODE256)
+		return c + 1;
+
+	const unsigned char* keys = (n->type == NODE4) ? ((art_node4*) n)->keys : ((art_node16*) n)->keys;
+	int pos = 0;
+	while (pos < n->num_children && keys[pos] <= c)
+		pos++;
+
+	return pos;
+}
+
+/*
+ * It moves the iterator to the first key not smaller than the given one. Going down the path of the key,
+ * every node is left on the stack positioned after the child taken, so the walk goes on from there.
+ */
+static void seek(ds_art_iterator* it, void* node, const unsigned char* key, size_t key_len) {
+	size_t depth = 0;
+	while (node != NULL) {
+		if (IS_LEAF(node)) {
+			art_leaf* l = AS_LEAF(node);
+			if (leaf_cmp(l, key, key_len) >= 0)
+				it->current = l;
+			else
+				step(it);
+			return;
+		}
+
+		art_node* n = (art_node*) node;
+		if (n->prefix_len > 0) {
+			const unsigned char* prefix = n->prefix;
+			if (n->prefix_len > MAX_PREFIX)
+				prefix = LEAF_KEY(min_leaf(n)) + depth;
+
+			size_t matched = prefix_mismatch(n, key, key_len, depth);
+			if (matched < n->prefix_len) {
+				// the whole subtree is either bigger or smaller than the key
+				if (matched == key_len - depth || key[depth + matched] < prefix[matched]) {
+					if (!push(it, n))
+						step(it);
+				} else {
+					step(it);
+				}
+				return;
+			}
+			depth += n->prefix_len;
+		}
+
+		if (push(it, n))
+			return;
+		if (depth == key_len) {
+			// the key is the leaf of the node, if any, every other key below the node is bigger
+			step(it);
+			return;
+		}
+
+		// the leaf of the node is a prefix of the key, so it is smaller
+		it->stack[it->depth - 1].pos = position_after(n, key[depth]);
+		void** child = find_child(n, key[depth]);
+		if (child == NULL) {
+			step(it);
+			return;
+		}
+
+		node = *child;
+		depth++;
+	}
+
+	step(it);
+}
+
+// Interface functions
+
+ds_art* create_ds_art(size_t value_len) {
+	ds_art* art = (ds_art*) malloc(sizeof(ds_art));
+	if (art == NULL)
+		return NULL;
+
+	art->root = NULL;
+	art->size = 0;
+	art->value_len = value_len;
+
+	return art;
+}
+
+void delete_ds_art(ds_art* art) {
+	if (art == NULL)
+		return;
+
+	free_tree(art->root);
+	free(art);
+}
+
+size_t ds_art_size(ds_art* art) {
+	return art->size;
+}
+
+ds_result ds_art_insert(ds_art* art, const void* k, size_t key_len, const void* v) {
+	if (art == NULL || (k == NULL && key_len > 0))
+		return GENERIC_ERROR;
+
+	int existed;
+	art_leaf* leaf = insert_key(art, (const unsigned char*) k, key_len, v, 0, &existed);
+	if (leaf == NULL)
+		return GENERIC_ERROR;
+	if (existed)
+		return ELEMENT_ALREADY_EXISTS;
+
+	art->size++;
+	return SUCCESS;
+}
+
+ds_result ds_art_put(ds_art* art, const void* k, size_t key_len, const void* v) {
+	if (art == NULL || (k == NULL && key_len > 0))
+		return GENERIC_ERROR;
+
+	int existed;
+	art_leaf* leaf = insert_key(art, (const unsigned char*) k, key_len, v, v != NULL, &existed);
+	if (leaf == NULL)
+		return GENERIC_ERROR;
+
+	if (existed && v == NULL)
+		memset(LEAF_VALUE(leaf), 0, art->value_len);
+	if (!existed)
+		art->size++;
+
+	return SUCCESS;
+}
+
+void* ds_art_get(ds_art* art, const void* k, size_t key_len) {
+	if (art == NULL || (k == NULL && key_len > 0))
+		return NULL;
+
+	// prefixes longer than MAX_PREFIX are skipped without being checked, the leaf tells if the key really matches
+	const unsigned char* key = (const unsigned char*) k;
+	void* node = art->root;
+	size_t depth = 0;
+	while (node != NULL) {
+		if (IS_LEAF(node)) {
+			art_leaf* l = AS_LEAF(node);
+			return leaf_matches(l, key, key_len) ? LEAF_VALUE(l) : NULL;
+		}
+
+		art_node* n = (art_node*) node;
+		if (n->prefix_len > 0) {
+			if (key_len - depth < n->prefix_len)
+				return NULL;
+
+			size_t stored = MIN((size_t) n->prefix_len, MAX_PREFIX);
+			if (memcmp(n->prefix, key + depth, stored) != 0)
+				return NULL;
+			depth += n->prefix_len;
+		}
+
+		if (depth == key_len) {
+			art_leaf* l = n->leaf;
+			return (l != NULL && leaf_matches(l, key, key_len)) ? LEAF_VALUE(l) : NULL;
+		}
+
+		void** child = find_child(n, key[depth]);
+		node = (child != NULL) ? *child : NULL;
+		depth++;
+	}
+
+	return NULL;
+}
+
+int ds_art_search(ds_art* art, const void* k, size_t key_len) {
+	return ds_art_get(art, k, key_len) != NULL;
+}
+
+ds_result ds_art_remove(ds_art* art, const void* k, size_t key_len) {
+	if (art == NULL || (k == NULL && key_len > 0))
+		return GENERIC_ERROR;
+
+	art_leaf* leaf = remove_key(art, (const unsigned char*) k, key_len);
+	if (leaf != NULL) {
+		free(leaf);
+		art->size--;
+	}
+
+	return SUCCESS;
+}
+
+ds_art_iterator* ds_art_first(ds_art* art) {
+	return create_iterator(art->root);
+}
+
+ds_art_iterator* ds_art_lower_bound(ds_art* art, const void* k, size_t key_len) {
+	ds_art_iterator* it = alloc_iterator();
+	if (it == NULL)
+		return NULL;
+
+	seek(it, art->root, (const unsigned char*) k, key_len);
+
+	return it;
+}
+
+ds_art_iterator* ds_art_range(ds_art* art, const void* lo, size_t lo_len, const void* hi, size_t hi_len) {
+	ds_art_iterator* it = alloc_iterator();
+	if (it == NULL)
+		return NULL;
+
+	// the end of the range is copied, so that the caller does not have to keep it around
+	it->end = (unsigned char*) malloc((hi_len > 0) ? hi_len : 1);
+	if (it->end == NULL) {
+		free(it);
+		return NULL;
+	}
+	if (hi_len > 0)
+		memcpy(it->end, hi, hi_len);
+	it->end_len = hi_len;
+	it->bounded = 1;
+
+	seek(it, art->root, (const unsigned char*) lo, lo_len);
+	check_end(it);
+
+	return it;
+}
+
+ds_art_iterator* ds_art_prefix(ds_art* art, const void* prefix, size_t prefix_len) {
+	const unsigned char* p = (const unsigned char*) prefix;
+
+	// it looks for the node whose subtree holds exactly the keys starting with the prefix
+	void* node = art->root;
+	size_t depth = 0;
+	while (node != NULL && depth < prefix_len) {
+		if (IS_LEAF(node)) {
+			art_leaf* l = AS_LEAF(node);
+			if (l->key_len < prefix_len || memcmp(LEAF_KEY(l), p, prefix_len) != 0)
+				node = NULL;
+			break;
+		}
+
+		art_node* n = (art_node*) node;
+		if (n->prefix_len > 0) {
+			size_t to_match = MIN((size_t) n->prefix_len, prefix_len - depth);
+			if (prefix_mismatch(n, p, prefix_len, depth) < to_match) {
+				node = NULL;
+				break;
+			}
+			if (to_match == prefix_len - depth)
+				break;
+			depth += n->prefix_len;
+		}
+
+		void** child = find_child(n, p[depth]);
+		node = (child != NULL) ? *child : NULL;
+		depth++;
+	}
+
+	return create_iterator(node);
+}
+
+void delete_ds_art_iterator(ds_art_iterator* it) {
+	if (it == NULL)
+		return;
+
+	free(it->stack);
+	free(it->end);
+	free(it);
+}
+
+int ds_art_iterator_is_valid(ds_art_iterator* it) {
+	return it->current != NULL;
+}
+
+int ds_art_iterator_failed(ds_art_iterator* it) {
+	return it->failed;
+}
+
+void ds_art_iterator_next(ds_art_iterator* it) {
+	advance(it);
+}
+
+const void* ds_art_iterator_key(ds_art_iterator* it, size_t* key_len) {
+	if (key_len != NULL)
+		*key_len = it->current->key_len;
+
+	return LEAF_KEY(it->current);
+}
+
+void* ds_art_iterator_value(ds_art_iterator* it) {
+	return LEAF_VALUE(it->current);
+}
+
+ds_result ds_art_visit(ds_art* art, void (*visit_func)(const void*, size_t, void*, void*), void* other_args) {
+	ds_art_iterator* it = ds_art_first(art);
+	if (it == NULL)
+		return GENERIC_ERROR;
+
+	for (; ds_art_iterator_is_valid(it); ds_art_iterator_next(it))
+		visit_func(LEAF_KEY(it->current), it->current->key_len, LEAF_VALUE(it->current), other_args);
+
+	ds_result res = ds_art_iterator_failed(it) ? GENERIC_ERROR : SUCCESS;
+	delete_ds_art_iterator(it);
+
+	return res;
+}
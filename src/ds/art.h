@@ -0,0 +1,225 @@
+/**
+ * @file art.h
+ * @author Valerio Bellizia
+ *
+ * This file contains the interface to be used with ds_art. It implements an adaptive radix
+ * tree: a map whose keys are byte strings of any length, sorted as memcmp does (a key comes
+ * before the longer keys it is a prefix of). Inner nodes hold 4, 16, 48 or 256 children and
+ * grow or shrink as needed, and chains of nodes with a single child are compressed into a
+ * prefix. Lookups cost O(key length), whatever the number of keys, and never call a comparison
+ * function.
+ *
+ * Keys and values are copied into the tree, values have a fixed length.
+ */
+
+#ifndef art_h
+#define art_h
+
+#include "result.h"
+
+#include <stddef.h>
+
+/**
+ * This is an opaque structure that represents an adaptive radix tree.
+ */
+typedef struct ds_art ds_art;
+
+/**
+ * This is an opaque structure that represents an iterator on an adaptive radix tree. It visits keys in order,
+ * and it stays valid as long as the tree is not changed. Iterators only move forward, there is no last or previous key.
+ */
+typedef struct ds_art_iterator ds_art_iterator;
+
+/**
+ * This function will create an adaptive radix tree instance.
+ *
+ * @param value_len This is the length of the value type, it can be 0.
+ *
+ * @return It returns the pointer to a new instance of ds_art.
+ */
+ds_art* create_ds_art(size_t value_len);
+
+/**
+ * This function will release the memory of the tree.
+ *
+ * @param art The adaptive radix tree.
+ */
+void delete_ds_art(ds_art* art);
+
+/**
+ * This function will return the number of keys stored in the tree.
+ *
+ * @param art The adaptive radix tree.
+ *
+ * @return The number of keys.
+ */
+size_t ds_art_size(ds_art* art);
+
+/**
+ * This function will insert a <key, value> pair. Both the key and the value are copied.
+ *
+ * @param art The adaptive radix tree.
+ * @param k The key.
+ * @param key_len The length of the key, it can be 0.
+ * @param v The value, if NULL the value is zero-filled.
+ *
+ * @return It returns SUCCESS if the pair is inserted. It returns ELEMENT_ALREADY_EXISTS when the key already exists.
+ */
+ds_result ds_art_insert(ds_art* art, const void* k, size_t key_len, const void* v);
+
+/**
+ * This function will insert a <key, value> pair, or overwrite the value if the key already exists.
+ *
+ * @param art The adaptive radix tree.
+ * @param k The key.
+ * @param key_len The length of the key, it can be 0.
+ * @param v The value, if NULL the value is zero-filled.
+ *
+ * @return It returns SUCCESS if the pair is stored, GENERIC_ERROR if the memory cannot be allocated.
+ */
+ds_result ds_art_put(ds_art* art, const void* k, size_t key_len, const void* v);
+
+/**
+ * This function will return the value associated to a key.
+ *
+ * @param art The adaptive radix tree.
+ * @param k The key.
+ * @param key_len The length of the key.
+ *
+ * @return It returns a pointer to the value, valid until the key is removed, NULL if the key does not exist.
+ */
+void* ds_art_get(ds_art* art, const void* k, size_t key_len);
+
+/**
+ * This function will look for a key.
+ *
+ * @param art The adaptive radix tree.
+ * @param k The key.
+ * @param key_len The length of the key.
+ *
+ * @return It returns 1 if the key exists, 0 otherwise.
+ */
+int ds_art_search(ds_art* art, const void* k, size_t key_len);
+
+/**
+ * This function will remove a key if it exists.
+ *
+ * @param art The adaptive radix tree.
+ * @param k The key.
+ * @param key_len The length of the key.
+ *
+ * @return It returns SUCCESS if the key is removed (or does not exist).
+ */
+ds_result ds_art_remove(ds_art* art, const void* k, size_t key_len);
+
+/**
+ * This function will return an iterator to the first key of the tree.
+ *
+ * @param art The adaptive radix tree.
+ *
+ * @return It returns the iterator, to be released with delete_ds_art_iterator, NULL if the memory cannot be allocated.
+ */
+ds_art_iterator* ds_art_first(ds_art* art);
+
+/**
+ * This function will return an iterator to the first key that is not smaller than the given one.
+ * It is found in O(key length).
+ *
+ * @param art The adaptive radix tree.
+ * @param k The key to compare with.
+ * @param key_len The length of the key.
+ *
+ * @return It returns the iterator, to be released with delete_ds_art_iterator, NULL if the memory cannot be allocated.
+ * The iterator is not valid if every key is smaller than k.
+ */
+ds_art_iterator* ds_art_lower_bound(ds_art* art, const void* k, size_t key_len);
+
+/**
+ * This function will return an iterator visiting, in order, the keys that fall within the range [lo, hi).
+ *
+ * @param art The adaptive radix tree.
+ * @param lo The lower bound of the range (included).
+ * @param lo_len The length of lo.
+ * @param hi The upper bound of the range (excluded), it is copied.
+ * @param hi_len The length of hi.
+ *
+ * @return It returns the iterator, to be released with delete_ds_art_iterator, NULL if the memory cannot be allocated.
+ */
+ds_art_iterator* ds_art_range(ds_art* art, const void* lo, size_t lo_len, const void* hi, size_t hi_len);
+
+/**
+ * This function will return an iterator visiting, in order, only the keys starting with the given prefix.
+ * The subtree holding them is found in O(prefix length).
+ *
+ * @param art The adaptive radix tree.
+ * @param prefix The prefix.
+ * @param prefix_len The length of the prefix, if 0 every key is visited.
+ *
+ * @return It returns the iterator, to be released with delete_ds_art_iterator, NULL if the memory cannot be allocated.
+ */
+ds_art_iterator* ds_art_prefix(ds_art* art, const void* prefix, size_t prefix_len);
+
+/**
+ * This function will release the memory of the iterator.
+ *
+ * @param it The iterator.
+ */
+void delete_ds_art_iterator(ds_art_iterator* it);
+
+/**
+ * This function can be used to check if the iterator is valid.
+ *
+ * @param it The iterator.
+ *
+ * @return it returns 1 if the iterator is valid, 0 otherwise.
+ */
+int ds_art_iterator_is_valid(ds_art_iterator* it);
+
+/**
+ * This function can be used to check if the iteration stopped because the memory to go down the tree
+ * could not be allocated, rather than because there are no more keys.
+ *
+ * @param it The iterator.
+ *
+ * @return it returns 1 if the iteration failed, 0 otherwise.
+ */
+int ds_art_iterator_failed(ds_art_iterator* it);
+
+/**
+ * This function will move the iterator to the next key.
+ *
+ * @param it The iterator.
+ */
+void ds_art_iterator_next(ds_art_iterator* it);
+
+/**
+ * This function will return the key pointed by the iterator.
+ *
+ * @param it The iterator.
+ * @param key_len If not NULL, it is set to the length of the key.
+ *
+ * @return It returns a pointer to the key.
+ */
+const void* ds_art_iterator_key(ds_art_iterator* it, size_t* key_len);
+
+/**
+ * This function will return the value pointed by the iterator.
+ *
+ * @param it The iterator.
+ *
+ * @return It returns a pointer to the value.
+ */
+void* ds_art_iterator_value(ds_art_iterator* it);
+
+/**
+ * This function will visit all the <key, value> pairs in key order.
+ *
+ * @param art The adaptive radix tree.
+ * @param visit_func It is a function like func(const void* key, size_t key_len, void* value, void* other_args).
+ * @param other_args It is the last argument to pass visit_func.
+ *
+ * @return It returns SUCCESS if every key is visited, GENERIC_ERROR if the memory cannot be allocated.
+ */
+ds_result ds_art_visit(ds_art* art, void (*visit_func)(const void*, size_t, void*, void*), void* other_args);
+
+#endif
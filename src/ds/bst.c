@@ -4,7 +4,10 @@
  */
 
 #include "bst.h"
+#include "cmp.h"
 
+#include <pthread.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -13,6 +16,9 @@
 struct ds_bst {
 	ds_bst_node* root;
 	ds_cmp cmp;
+	ds_cmp_kind cmp_kind;
+	ds_bst_augment augment;
+	int multi;
 	size_t elements;
 	size_t element_size;
 };
@@ -20,12 +26,18 @@ struct ds_bst {
 struct ds_bst_node {
 	void* info;
 	int height;
+	size_t size;
 	ds_cmp cmp;
+	ds_bst_augment augment;
 	struct ds_bst_node* parent;
 	struct ds_bst_node* left;
 	struct ds_bst_node* right;
 };
 
+// the offset of the element within the memory block of a node, it is kept aligned for any type
+#define NODE_INFO_ALIGN 16
+#define NODE_INFO_OFFSET (((sizeof(ds_bst_node) + NODE_INFO_ALIGN - 1) / NODE_INFO_ALIGN) * NODE_INFO_ALIGN)
+
 // The following will make msvc happy
 #ifndef max
 static int max(int i1, int i2) {
@@ -37,58 +49,100 @@ static int node_height(ds_bst_node* node) {
 	return node != NULL ? node->height : 0;
 }
 
+static size_t node_size(ds_bst_node* node) {
+	return node != NULL ? node->size : 0;
+}
+
+// it recomputes the augmented fields (height, subtree size and the ones of the element, if any) from the children
+static void node_update(ds_bst_node* node) {
+	node->height = 1 + max(node_height(node->left), node_height(node->right));
+	node->size = 1 + node_size(node->left) + node_size(node->right);
+
+	if (node->augment != NULL)
+		node->augment(node->info, ds_bst_node_get(node->left), ds_bst_node_get(node->right));
+}
+
 static int node_balance(ds_bst_node* node) {
 	return node != NULL ? node_height(node->left) - node_height(node->right) : 0;
 }
 
-static void node_visit(ds_bst_node* root, void (*visit_element)(const void*, void*), void* other_args, ds_visit_type type) {
-	if (root == NULL)
-		return;
+// it walks the tree comparing the values in place, it gives the same results of the library comparison functions
+#define SEARCH_VALUES(TYPE, ROOT, ELEMENT) { \
+	TYPE key; \
+	memcpy(&key, ELEMENT, sizeof(TYPE)); \
+	ds_bst_node* n = ROOT; \
+	while (n != NULL) { \
+		TYPE value; \
+		memcpy(&value, n->info, sizeof(TYPE)); \
+		if (key < value) \
+			n = n->left; \
+		else if (key > value) \
+			n = n->right; \
+		else \
+			return n; \
+	} \
+	return NULL; \
+}
 
-	switch (type) {
-	case DFS_PRE_ORDER:
-		visit_element(root->info, other_args);
-		node_visit(root->left, visit_element, other_args, type);
-		node_visit(root->right, visit_element, other_args, type);
-		break;
-	case DFS_IN_ORDER:
-		node_visit(root->left, visit_element, other_args, type);
-		visit_element(root->info, other_args);
-		node_visit(root->right, visit_element, other_args, type);
-		break;
-	case DFS_POST_ORDER:
-		node_visit(root->left, visit_element, other_args, type);
-		node_visit(root->right, visit_element, other_args, type);
-		visit_element(root->info, other_args);
-		break;
+static ds_bst_node* search_strings(ds_bst_node* root, const void* element) {
+	const char* key = *(const char* const*) element;
+	ds_bst_node* n = root;
+	while (n != NULL) {
+		int cmp_res = strcmp(key, *(const char* const*) n->info);
+		if (cmp_res == 0)
+			return n;
+		n = (cmp_res < 0) ? n->left : n->right;
+	}
+
+	return NULL;
+}
+
+static ds_bst_node* node_search(ds_bst* bt, const void* element) {
+	switch (bt->cmp_kind) {
+	case DS_CMP_INT32:
+		SEARCH_VALUES(int32_t, bt->root, element)
+	case DS_CMP_INT64:
+		SEARCH_VALUES(int64_t, bt->root, element)
+	case DS_CMP_UINT64:
+		SEARCH_VALUES(uint64_t, bt->root, element)
+	case DS_CMP_DOUBLE:
+		SEARCH_VALUES(double, bt->root, element)
+	case DS_CMP_CSTR:
+		return search_strings(bt->root, element);
 	default:
 		break;
 	}
-}
 
-static ds_bst_node* node_search(ds_cmp cmp_func, ds_bst_node* root, const void* element) {
-	if (root == NULL)
-		return NULL;
-	else {
-		int cmp_res = cmp_func(element, root->info);
+	ds_bst_node* n = bt->root;
+	while (n != NULL) {
+		int cmp_res = bt->cmp(element, n->info);
 		if (cmp_res == 0)
-			return root;
-		else if (cmp_res < 0)
-			return node_search(cmp_func, root->left, element);
-		else
-			return node_search(cmp_func, root->right, element);
+			return n;
+		n = (cmp_res < 0) ? n->left : n->right;
 	}
+
+	return NULL;
 }
 
 static void free_nodes(ds_bst_node* root) {
-	if (root == NULL)
-		return;
-	else if (ds_bst_node_is_leaf(root))
-		free(root);
-	else {
-		free_nodes(root->left);
-		free_nodes(root->right);
-		free(root);
+	// children are detached while going down, so that a node is freed once it has no children left
+	ds_bst_node* n = root;
+	while (n != NULL) {
+		if (n->left != NULL) {
+			ds_bst_node* l = n->left;
+			n->left = NULL;
+			n = l;
+		}
+		else if (n->right != NULL) {
+			ds_bst_node* r = n->right;
+			n->right = NULL;
+			n = r;
+		}
+		else {
+			ds_bst_node* parent = (n == root) ? NULL : n->parent;
+			delete_ds_bst_node(n);
+			n = parent;
+		}
 	}
 }
 
@@ -150,6 +204,143 @@ static ds_bst_node* in_order_predecessor(ds_bst_node* node) {
 	return parent;
 }
 
+static ds_bst_node* pre_order_successor(ds_bst_node* node) {
+	if (node->left != NULL)
+		return node->left;
+	if (node->right != NULL)
+		return node->right;
+
+	// going up until we find a right subtree that has not been visited yet
+	ds_bst_node* parent = node->parent;
+	ds_bst_node* n = node;
+	while (parent != NULL) {
+		if (n == parent->left && parent->right != NULL)
+			return parent->right;
+		n = parent;
+		parent = parent->parent;
+	}
+
+	return NULL;
+}
+
+static ds_bst_node* post_order_first(ds_bst_node* root) {
+	ds_bst_node* n = root;
+	while (n != NULL && !ds_bst_node_is_leaf(n))
+		n = (n->left != NULL) ? n->left : n->right;
+
+	return n;
+}
+
+static ds_bst_node* post_order_successor(ds_bst_node* node) {
+	ds_bst_node* parent = node->parent;
+	if (parent != NULL && node == parent->left && parent->right != NULL)
+		return post_order_first(parent->right);
+
+	return parent;
+}
+
+/*
+ * It visits the nodes at the given depth from left to right, following parent links and never going below
+ * that depth, it returns 1 if visit_element asked to stop.
+ */
+static int level_walk(ds_bst_node* root, int level, int (*visit_element)(const void*, void*), void* other_args) {
+	ds_bst_node* top = root->parent;
+	ds_bst_node* from = top;
+	ds_bst_node* n = root;
+	int depth = 0;
+	while (n != top) {
+		ds_bst_node* next = n->parent;
+		if (from == n->parent) {
+			if (depth == level) {
+				if (visit_element(n->info, other_args))
+					return 1;
+			}
+			else if (n->left != NULL)
+				next = n->left;
+			else if (n->right != NULL)
+				next = n->right;
+		}
+		else if (from == n->left && n->right != NULL)
+			next = n->right;
+
+		depth += (next == n->parent) ? -1 : 1;
+		from = n;
+		n = next;
+	}
+
+	return 0;
+}
+
+// without the memory for the queue every level is walked from the root, in O(n log n) at worst
+static int level_order_walk_in_place(ds_bst_node* root, int (*visit_element)(const void*, void*), void* other_args) {
+	for (int level = 0; level < root->height; ++level) {
+		if (level_walk(root, level, visit_element, other_args))
+			return 1;
+	}
+
+	return 0;
+}
+
+static int level_order_walk(ds_bst_node* root, size_t elements, int (*visit_element)(const void*, void*), void* other_args) {
+	// the queue never holds more than the number of elements of the tree
+	ds_bst_node** queue = (ds_bst_node**) malloc(elements * sizeof(ds_bst_node*));
+	if (queue == NULL)
+		return level_order_walk_in_place(root, visit_element, other_args);
+
+	size_t head = 0;
+	size_t tail = 0;
+	queue[tail++] = root;
+
+	int stopped = 0;
+	while (head < tail && !stopped) {
+		ds_bst_node* n = queue[head++];
+		stopped = visit_element(n->info, other_args);
+
+		if (n->left != NULL)
+			queue[tail++] = n->left;
+		if (n->right != NULL)
+			queue[tail++] = n->right;
+	}
+
+	free(queue);
+	return stopped;
+}
+
+// it walks the tree following parent links, it returns 1 if visit_element asked to stop
+static int node_walk(ds_bst_node* root, size_t elements, int (*visit_element)(const void*, void*), void* other_args, ds_visit_type type) {
+	if (root == NULL)
+		return 0;
+
+	ds_bst_node* n;
+	ds_bst_node* (*successor)(ds_bst_node*);
+	switch (type) {
+	case DFS_PRE_ORDER:
+		n = root;
+		successor = pre_order_successor;
+		break;
+	case DFS_IN_ORDER:
+		n = get_min(root);
+		successor = in_order_successor;
+		break;
+	case DFS_POST_ORDER:
+		n = post_order_first(root);
+		successor = post_order_successor;
+		break;
+	case BFS_LEVEL_ORDER:
+		return level_order_walk(root, elements, visit_element, other_args);
+	default:
+		return 0;
+	}
+
+	while (n != NULL) {
+		if (visit_element(n->info, other_args))
+			return 1;
+		n = successor(n);
+	}
+
+	return 0;
+}
+
 static ds_bst_node* rotate_right(ds_bst_node* node) {
 	ds_bst_node* l = node->left;
 	ds_bst_node* l_right = l->right;
@@ -162,8 +353,8 @@ static ds_bst_node* rotate_right(ds_bst_node* node) {
 	l->parent = node->parent;
 	node->parent = l;
 
-	l->height = 1 + max(node_height(l->left), node_height(l->right));
-	node->height = 1 + max(node_height(node->left), node_height(node->right));
+	node_update(node);
+	node_update(l);
 
 	return l;
 }
@@ -180,12 +371,338 @@ static ds_bst_node* rotate_left(ds_bst_node* node) {
 	r->parent = node->parent;
 	node->parent = r;
 
-	node->height = 1 + max(node_height(node->left), node_height(node->right));
-	r->height = 1 + max(node_height(r->left), node_height(r->right));
+	node_update(node);
+	node_update(r);
 
 	return r;
 }
 
+// it restores the AVL property of a node whose children are balanced and differ in height by at most 2
+static ds_bst_node* rebalance(ds_bst_node* r) {
+	int balance = node_balance(r);
+	if (balance > 1 && node_balance(r->left) >= 0)
+		return rotate_right(r);
+
+	if (balance > 1 && node_balance(r->left) < 0) {
+		r->left = rotate_left(r->left);
+		return rotate_right(r);
+	}
+
+	if (balance < -1 && node_balance(r->right) <= 0)
+		return rotate_left(r);
+
+	if (balance < -1 && node_balance(r->right) > 0) {
+		r->right = rotate_right(r->right);
+		return rotate_left(r);
+	}
+
+	return r;
+}
+
+// join-based primitives: all of them work on detached subtrees, whose roots have no parent
+
+static void set_children(ds_bst_node* node, ds_bst_node* left, ds_bst_node* right) {
+	node->left = left;
+	node->right = right;
+	if (left != NULL)
+		left->parent = node;
+	if (right != NULL)
+		right->parent = node;
+	node_update(node);
+}
+
+static ds_bst_node* join_right(ds_bst_node* l, ds_bst_node* k, ds_bst_node* r) {
+	// l is taller than r: we walk down the right spine of l looking for a subtree as tall as r
+	ds_bst_node* c = l->right;
+	if (node_height(c) <= node_height(r) + 1) {
+		set_children(k, c, r);
+		if (node_height(k) <= node_height(l->left) + 1) {
+			set_children(l, l->left, k);
+			return l;
+		}
+
+		k->parent = l;
+		set_children(l, l->left, rotate_right(k));
+		return rotate_left(l);
+	}
+
+	ds_bst_node* t = join_right(c, k, r);
+	set_children(l, l->left, t);
+	if (node_height(t) <= node_height(l->left) + 1)
+		return l;
+
+	return rotate_left(l);
+}
+
+static ds_bst_node* join_left(ds_bst_node* l, ds_bst_node* k, ds_bst_node* r) {
+	// mirror of join_right: r is taller than l
+	ds_bst_node* c = r->left;
+	if (node_height(c) <= node_height(l) + 1) {
+		set_children(k, l, c);
+		if (node_height(k) <= node_height(r->right) + 1) {
+			set_children(r, k, r->right);
+			return r;
+		}
+
+		k->parent = r;
+		set_children(r, rotate_left(k), r->right);
+		return rotate_right(r);
+	}
+
+	ds_bst_node* t = join_left(l, k, c);
+	set_children(r, t, r->right);
+	if (node_height(t) <= node_height(r->right) + 1)
+		return r;
+
+	return rotate_right(r);
+}
+
+// it joins l, k and r where all elements in l are smaller than k and all elements in r are bigger than k
+static ds_bst_node* join_nodes(ds_bst_node* l, ds_bst_node* k, ds_bst_node* r) {
+	ds_bst_node* root;
+	if (node_height(l) > node_height(r) + 1)
+		root = join_right(l, k, r);
+	else if (node_height(r) > node_height(l) + 1)
+		root = join_left(l, k, r);
+	else {
+		set_children(k, l, r);
+		root = k;
+	}
+
+	root->parent = NULL;
+	return root;
+}
+
+// it detaches the maximum of a subtree, it returns the subtree without it
+static ds_bst_node* split_last(ds_bst_node* root, ds_bst_node** last) {
+	ds_bst_node* left = root->left;
+	ds_bst_node* right = root->right;
+	if (left != NULL)
+		left->parent = NULL;
+
+	if (right == NULL) {
+		*last = root;
+		root->left = NULL;
+		node_update(root);
+		return left;
+	}
+
+	right->parent = NULL;
+	return join_nodes(left, root, split_last(right, last));
+}
+
+// it joins two subtrees where all elements of l are smaller than all elements of r
+static ds_bst_node* join2_nodes(ds_bst_node* l, ds_bst_node* r) {
+	if (l == NULL)
+		return r;
+
+	ds_bst_node* k;
+	ds_bst_node* rest = split_last(l, &k);
+	return join_nodes(rest, k, r);
+}
+
+// it splits a subtree in elements smaller and bigger than element, the node equal to element (if any) is detached in found
+static void split_nodes(ds_cmp cmp, ds_bst_node* root, const void* element, ds_bst_node** lt, ds_bst_node** found, ds_bst_node** gt) {
+	if (root == NULL) {
+		*lt = NULL;
+		*gt = NULL;
+		*found = NULL;
+		return;
+	}
+
+	ds_bst_node* left = root->left;
+	ds_bst_node* right = root->right;
+	if (left != NULL)
+		left->parent = NULL;
+	if (right != NULL)
+		right->parent = NULL;
+	root->left = NULL;
+	root->right = NULL;
+	root->parent = NULL;
+
+	int cmp_res = cmp(element, root->info);
+	if (cmp_res == 0) {
+		node_update(root);
+		*lt = left;
+		*gt = right;
+		*found = root;
+	}
+	else if (cmp_res < 0) {
+		ds_bst_node* aux;
+		split_nodes(cmp, left, element, lt, found, &aux);
+		*gt = join_nodes(aux, root, right);
+	}
+	else {
+		ds_bst_node* aux;
+		split_nodes(cmp, right, element, &aux, found, gt);
+		*lt = join_nodes(left, root, aux);
+	}
+}
+
+// it splits a subtree in the elements coming before element and the others, equal elements come before only if inclusive
+static void split_at(ds_cmp cmp, ds_bst_node* root, const void* element, int inclusive, ds_bst_node** before, ds_bst_node** after) {
+	if (root == NULL) {
+		*before = NULL;
+		*after = NULL;
+		return;
+	}
+
+	ds_bst_node* left = root->left;
+	ds_bst_node* right = root->right;
+	if (left != NULL)
+		left->parent = NULL;
+	if (right != NULL)
+		right->parent = NULL;
+	root->left = NULL;
+	root->right = NULL;
+	root->parent = NULL;
+
+	int cmp_res = cmp(element, root->info);
+	ds_bst_node* aux;
+	if (cmp_res < 0 || (cmp_res == 0 && !inclusive)) {
+		split_at(cmp, left, element, inclusive, before, &aux);
+		*after = join_nodes(aux, root, right);
+	}
+	else {
+		split_at(cmp, right, element, inclusive, &aux, after);
+		*before = join_nodes(left, root, aux);
+	}
+}
+
+// it detaches the children of a root, so that they can be used as separate subtrees
+static void expose(ds_bst_node* root, ds_bst_node** left, ds_bst_node** right) {
+	*left = root->left;
+	*right = root->right;
+	if (*left != NULL)
+		(*left)->parent = NULL;
+	if (*right != NULL)
+		(*right)->parent = NULL;
+	root->left = NULL;
+	root->right = NULL;
+}
+
+// below this number of nodes a subtree pair is not worth a thread
+#define PARALLEL_CUTOFF 4096
+
+typedef ds_bst_node* (*set_op)(ds_cmp, ds_bst_node*, ds_bst_node*, int);
+
+struct set_task {
+	set_op op;
+	ds_cmp cmp;
+	ds_bst_node* t1;
+	ds_bst_node* t2;
+	int forks;
+	ds_bst_node* res;
+};
+
+static void* run_set_task(void* arg) {
+	struct set_task* task = (struct set_task*) arg;
+	task->res = task->op(task->cmp, task->t1, task->t2, task->forks);
+	return NULL;
+}
+
+/*
+ * It runs op on the left and on the right pairs of subtrees. The pairs share no node, so while forks is
+ * above 0 and both pairs are big enough, the left one is handed to a new thread. If the thread cannot
+ * be created, the work is done here.
+ */
+static void run_on_children(set_op op, ds_cmp cmp, ds_bst_node* l1, ds_bst_node* l2, ds_bst_node* r1, ds_bst_node* r2, int forks, ds_bst_node** l, ds_bst_node** r) {
+	if (forks > 0 && node_size(l1) + node_size(l2) >= PARALLEL_CUTOFF && node_size(r1) + node_size(r2) >= PARALLEL_CUTOFF) {
+		struct set_task task = { op, cmp, l1, l2, forks - 1, NULL };
+		pthread_t thread;
+		if (pthread_create(&thread, NULL, run_set_task, &task) == 0) {
+			*r = op(cmp, r1, r2, forks - 1);
+			pthread_join(thread, NULL);
+			*l = task.res;
+			return;
+		}
+		forks = 0;
+	}
+
+	*l = op(cmp, l1, l2, forks);
+	*r = op(cmp, r1, r2, forks);
+}
+
+// in all the following operations t1 is the tree being updated, while t2 is consumed, up to 2^forks threads work at once
+static ds_bst_node* union_nodes(ds_cmp cmp, ds_bst_node* t1, ds_bst_node* t2, int forks) {
+	if (t1 == NULL)
+		return t2;
+	if (t2 == NULL)
+		return t1;
+
+	ds_bst_node *l1, *r1, *l2, *r2, *found, *l, *r;
+	expose(t1, &l1, &r1);
+	split_nodes(cmp, t2, t1->info, &l2, &found, &r2);
+	delete_ds_bst_node(found);
+
+	run_on_children(union_nodes, cmp, l1, l2, r1, r2, forks, &l, &r);
+	return join_nodes(l, t1, r);
+}
+
+static ds_bst_node* intersection_nodes(ds_cmp cmp, ds_bst_node* t1, ds_bst_node* t2, int forks) {
+	if (t1 == NULL || t2 == NULL) {
+		free_nodes(t1);
+		free_nodes(t2);
+		return NULL;
+	}
+
+	ds_bst_node *l1, *r1, *l2, *r2, *found, *l, *r;
+	expose(t1, &l1, &r1);
+	split_nodes(cmp, t2, t1->info, &l2, &found, &r2);
+
+	run_on_children(intersection_nodes, cmp, l1, l2, r1, r2, forks, &l, &r);
+	if (found != NULL) {
+		delete_ds_bst_node(found);
+		return join_nodes(l, t1, r);
+	}
+
+	delete_ds_bst_node(t1);
+	return join2_nodes(l, r);
+}
+
+static ds_bst_node* difference_nodes(ds_cmp cmp, ds_bst_node* t1, ds_bst_node* t2, int forks) {
+	if (t1 == NULL || t2 == NULL) {
+		free_nodes(t2);
+		return t1;
+	}
+
+	ds_bst_node *l1, *r1, *l2, *r2, *found, *l, *r;
+	expose(t1, &l1, &r1);
+	split_nodes(cmp, t2, t1->info, &l2, &found, &r2);
+
+	run_on_children(difference_nodes, cmp, l1, l2, r1, r2, forks, &l, &r);
+	if (found != NULL) {
+		delete_ds_bst_node(found);
+		delete_ds_bst_node(t1);
+		return join2_nodes(l, r);
+	}
+
+	return join_nodes(l, t1, r);
+}
+
+static ds_bst_node* copy_nodes(ds_bst_node* root, ds_bst_node* parent, const size_t element_size) {
+	if (root == NULL)
+		return NULL;
+
+	ds_bst_node* node = create_ds_bst_node(root->info, root->cmp, element_size);
+	if (node == NULL)
+		return NULL;
+
+	node->augment = root->augment;
+	node->parent = parent;
+	node->left = copy_nodes(root->left, node, element_size);
+	node->right = copy_nodes(root->right, node, element_size);
+	node_update(node);
+
+	// the allocation of a child failed
+	if (node->size != root->size) {
+		free_nodes(node);
+		return NULL;
+	}
+
+	return node;
+}
+
 ds_bst_iterator ds_bst_first(ds_bst* bt) {
 	ds_bst_iterator it;
 	it.bst = bt;
@@ -202,6 +719,67 @@ ds_bst_iterator ds_bst_last(ds_bst* bt) {
 	return it;
 }
 
+ds_bst_iterator ds_bst_lower_bound(ds_bst* bt, const void* element) {
+	ds_bst_iterator it;
+	it.bst = bt;
+	it.current = NULL;
+
+	// looking for the first node that is not smaller than element
+	ds_bst_node* n = bt->root;
+	while (n != NULL) {
+		if (bt->cmp(element, n->info) <= 0) {
+			it.current = n;
+			n = n->left;
+		}
+		else
+			n = n->right;
+	}
+
+	return it;
+}
+
+ds_bst_iterator ds_bst_upper_bound(ds_bst* bt, const void* element) {
+	ds_bst_iterator it;
+	it.bst = bt;
+	it.current = NULL;
+
+	// looking for the first node that is bigger than element
+	ds_bst_node* n = bt->root;
+	while (n != NULL) {
+		if (bt->cmp(element, n->info) < 0) {
+			it.current = n;
+			n = n->left;
+		}
+		else
+			n = n->right;
+	}
+
+	return it;
+}
+
+ds_bst_iterator ds_bst_floor(ds_bst* bt, const void* element) {
+	ds_bst_iterator it;
+	it.bst = bt;
+	it.current = NULL;
+
+	// looking for the last node that is not bigger than element
+	ds_bst_node* n = bt->root;
+	while (n != NULL) {
+		if (bt->cmp(element, n->info) >= 0) {
+			it.current = n;
+			n = n->right;
+		}
+		else
+			n = n->left;
+	}
+
+	return it;
+}
+
+ds_bst_iterator ds_bst_ceiling(ds_bst* bt, const void* element) {
+	return ds_bst_lower_bound(bt, element);
+}
+
 void ds_bst_iterator_next(ds_bst_iterator* it) {
 	ds_bst_node* successor = in_order_successor(it->current);
 
@@ -225,18 +803,19 @@ const void* ds_bst_iterator_get(ds_bst_iterator* it) {
 }
 
 ds_bst_node* create_ds_bst_node(const void* element, ds_cmp cmp, const size_t size) {
-	ds_bst_node* node = (ds_bst_node*) malloc(sizeof(ds_bst_node));
+	// the element is stored right after the node, so that a single allocation is needed
+	ds_bst_node* node = (ds_bst_node*) malloc(NODE_INFO_OFFSET + size);
 	if (node != NULL) {
 		node->parent = NULL;
 		node->left = NULL;
 		node->right = NULL;
 		node->cmp = cmp;
+		node->augment = NULL;
 
-		node->info = malloc(size);
-		if (node->info != NULL) {
-			memcpy(node->info, element, size);
-		}
+		node->info = (char*)node + NODE_INFO_OFFSET;
+		memcpy(node->info, element, size);
 		node->height = 1;
+		node->size = 1;
 	}
 
 	return node;
@@ -256,12 +835,9 @@ int ds_bst_node_is_leaf(ds_bst_node* node) {
 }
 
 void delete_ds_bst_node(ds_bst_node* node) {
-	if (node != NULL) {
-		if (node->info != NULL) {
-			free(node->info);
-		}
+	// the element lives in the same memory block of the node
+	if (node != NULL)
 		free(node);
-	}
 }
 
 const void* ds_bst_node_get(ds_bst_node* node) {
@@ -278,133 +854,301 @@ ds_bst* create_ds_bst(ds_cmp cmp_func, const size_t size) {
 
 	bt->root = NULL;
 	bt->cmp = cmp_func;
+	bt->cmp_kind = ds_cmp_kind_of(cmp_func, size);
+	bt->augment = NULL;
+	bt->multi = 0;
 	bt->elements = 0;
 	bt->element_size = size;
 
 	return bt;
 }
 
+ds_bst* create_ds_bst_multi(ds_cmp cmp_func, const size_t size) {
+	ds_bst* bt = create_ds_bst(cmp_func, size);
+	if (bt != NULL)
+		bt->multi = 1;
+
+	return bt;
+}
+
+int ds_bst_is_multi(const ds_bst* bt) {
+	return bt->multi;
+}
+
+ds_bst* create_ds_bst_augmented(ds_cmp cmp_func, const size_t size, ds_bst_augment augment_func) {
+	ds_bst* bt = create_ds_bst(cmp_func, size);
+	if (bt != NULL)
+		bt->augment = augment_func;
+
+	return bt;
+}
+
+ds_bst* create_ds_bst_multi_augmented(ds_cmp cmp_func, const size_t size, ds_bst_augment augment_func) {
+	ds_bst* bt = create_ds_bst_augmented(cmp_func, size, augment_func);
+	if (bt != NULL)
+		bt->multi = 1;
+
+	return bt;
+}
+
+ds_bst_node* ds_bst_root(ds_bst* bt) {
+	return bt->root;
+}
+
+static ds_bst_node* build_nodes(ds_bst* bt, ds_bst_node* parent, size_t lo, size_t hi, const void* (*element_at)(size_t, void*), void* other_args) {
+	if (lo >= hi)
+		return NULL;
+
+	// the middle element becomes the root, so both halves differ by at most one element
+	size_t mid = lo + (hi - lo) / 2;
+	ds_bst_node* node = create_ds_bst_node(element_at(mid, other_args), bt->cmp, bt->element_size);
+	if (node == NULL)
+		return NULL;
+
+	node->augment = bt->augment;
+	node->parent = parent;
+	node->left = build_nodes(bt, node, lo, mid, element_at, other_args);
+	node->right = build_nodes(bt, node, mid + 1, hi, element_at, other_args);
+	node_update(node);
+
+	// the allocation of a child failed
+	if (node->size != hi - lo) {
+		free_nodes(node);
+		return NULL;
+	}
+
+	return node;
+}
+
+static ds_bst* build_sorted(ds_cmp cmp_func, const size_t size, const size_t n, const void* (*element_at)(size_t, void*), void* other_args, int multi) {
+	if (element_at == NULL && n > 0)
+		return NULL;
+
+	ds_bst* bt = multi ? create_ds_bst_multi(cmp_func, size) : create_ds_bst(cmp_func, size);
+	if (bt == NULL)
+		return NULL;
+
+	bt->root = build_nodes(bt, NULL, 0, n, element_at, other_args);
+	if (bt->root == NULL && n > 0) {
+		delete_ds_bst(bt);
+		return NULL;
+	}
+	bt->elements = n;
+
+	return bt;
+}
+
+ds_bst* ds_bst_build_sorted_from(ds_cmp cmp_func, const size_t size, const size_t n, const void* (*element_at)(size_t, void*), void* other_args) {
+	return build_sorted(cmp_func, size, n, element_at, other_args, 0);
+}
+
+ds_bst* ds_bst_build_sorted_multi_from(ds_cmp cmp_func, const size_t size, const size_t n, const void* (*element_at)(size_t, void*), void* other_args) {
+	return build_sorted(cmp_func, size, n, element_at, other_args, 1);
+}
+
+struct sorted_array {
+	const char* data;
+	size_t size;
+};
+
+static const void* array_element_at(size_t i, void* other_args) {
+	struct sorted_array* array = (struct sorted_array*) other_args;
+	return array->data + (i * array->size);
+}
+
+// equal neighbours are accepted only by multi trees
+static ds_bst* build_sorted_array(ds_cmp cmp_func, const size_t size, const void* data, const size_t n, int multi) {
+	if (data == NULL && n > 0)
+		return NULL;
+
+	const char* elements = (const char*) data;
+	for (size_t i = 1; i < n; ++i) {
+		int cmp_res = cmp_func(elements + ((i - 1) * size), elements + (i * size));
+		if (cmp_res > 0 || (cmp_res == 0 && !multi))
+			return NULL;
+	}
+
+	struct sorted_array array;
+	array.data = elements;
+	array.size = size;
+
+	return build_sorted(cmp_func, size, n, array_element_at, &array, multi);
+}
+
+ds_bst* ds_bst_build_sorted(ds_cmp cmp_func, const size_t size, const void* data, const size_t n) {
+	return build_sorted_array(cmp_func, size, data, n, 0);
+}
+
+ds_bst* ds_bst_build_sorted_multi(ds_cmp cmp_func, const size_t size, const void* data, const size_t n) {
+	return build_sorted_array(cmp_func, size, data, n, 1);
+}
+
+ds_bst* ds_bst_build_sorted_vect(ds_cmp cmp_func, const ds_vect* v) {
+	if (v == NULL)
+		return NULL;
+
+	size_t n = ds_vect_length(v);
+	if (n == 0)
+		return create_ds_bst(cmp_func, ds_vect_element_size(v));
+
+	// elements of a vector are stored contiguously starting from the first one
+	ds_vect_iterator first = ds_vect_first(v);
+	return ds_bst_build_sorted(cmp_func, ds_vect_element_size(v), ds_vect_iterator_get(&first), n);
+}
+
 size_t ds_bst_size(const ds_bst* bt) {
 	return bt->elements;
 }
 
-static ds_bst_node* insert_node(ds_bst* bt, ds_bst_node* parent, ds_bst_node* r, const void* element) {
+size_t ds_bst_element_size(const ds_bst* bt) {
+	return bt->element_size;
+}
+
+// it returns the new root of the subtree, NULL if nothing has been added; node is set to the node holding element (NULL if the allocation failed)
+static ds_bst_node* insert_node(ds_bst* bt, ds_bst_node* parent, ds_bst_node* r, const void* element, ds_bst_node** node) {
 	if (r == NULL) {
 		ds_bst_node* n = create_ds_bst_node(element, bt->cmp, bt->element_size);
-		n->parent = parent;
+		if (n != NULL) {
+			n->parent = parent;
+			n->augment = bt->augment;
+			node_update(n);
+		}
+		*node = n;
 		return n;
 	}
 
+	// in a multi tree an element goes after the equal ones, so that they stay in insertion order
 	int cmp = bt->cmp(element, r->info);
 	if (cmp < 0) {
-		ds_bst_node* n = insert_node(bt, r, r->left, element);
+		ds_bst_node* n = insert_node(bt, r, r->left, element, node);
 		if (n == NULL)
 			return NULL;
 		r->left = n;
 	}
-	else if (cmp > 0) {
-		ds_bst_node* n = insert_node(bt, r, r->right, element);
+	else if (cmp > 0 || bt->multi) {
+		ds_bst_node* n = insert_node(bt, r, r->right, element, node);
 		if (n == NULL)
 			return NULL;
 		r->right = n;
 	}
-	else
+	else {
+		*node = r;
 		return NULL;
-	
-	// need to update balance factor and balance the tree
-	r->height = 1 + max(node_height(r->left), node_height(r->right));
-	int balance = node_balance(r);
-
-	if (balance > 1 && bt->cmp(element, r->left->info) < 0)
-		return rotate_right(r);
-
-	if (balance < -1 && bt->cmp(element, r->right->info) > 0)
-		return rotate_left(r);
-
-	// following case we have doble rotation...
-	if (balance > 1 && bt->cmp(element, r->left->info) > 0) {
-		r->left = rotate_left(r->left);
-		return rotate_right(r);
 	}
-
-	if (balance < -1 && bt->cmp(element, r->right->info) < 0) {
-		r->right = rotate_right(r->right);
-		return rotate_left(r);
-	}
-
-	return r;
+	
+	// need to update balance factor and balance the tree, the balance of the children tells the rotation (equal elements cannot)
+	node_update(r);
+	return rebalance(r);
 }
 
 ds_result ds_bst_insert(ds_bst* bt, const void* element) {
 	if (element == NULL)
 		return GENERIC_ERROR;
 
-	ds_bst_node* node = insert_node(bt, NULL, bt->root, element);
-	if (node != NULL) {
-		bt->root = node;
+	ds_bst_node* node;
+	ds_bst_node* root = insert_node(bt, NULL, bt->root, element, &node);
+	if (root != NULL) {
+		bt->root = root;
 		bt->elements++;
 		return SUCCESS;
 	}
 	
-	return ELEMENT_ALREADY_EXISTS;
+	return (node != NULL) ? ELEMENT_ALREADY_EXISTS : GENERIC_ERROR;
+}
+
+void* ds_bst_get_or_insert(ds_bst* bt, const void* element, int* inserted) {
+	if (bt == NULL || element == NULL)
+		return NULL;
+
+	ds_bst_node* node;
+	ds_bst_node* root = insert_node(bt, NULL, bt->root, element, &node);
+	if (root != NULL) {
+		bt->root = root;
+		bt->elements++;
+	}
+
+	if (inserted != NULL)
+		*inserted = (root != NULL);
+
+	return (node != NULL) ? node->info : NULL;
 }
 
-static ds_bst_node* delete_node(ds_bst_node* r, const void* element, const size_t element_size, char* decrement_count) {
+static ds_bst_node* delete_node(ds_bst_node* r, const void* element, char* decrement_count) {
 	// recursively look for the node to delete... like in plain BST
 	if (r == NULL)
 		return NULL;
 	else if (r->cmp(element, r->info) < 0)
-		r->left = delete_node(r->left, element, element_size, decrement_count);
+		r->left = delete_node(r->left, element, decrement_count);
 	else if (r->cmp(element, r->info) > 0)
-		r->right = delete_node(r->right, element, element_size, decrement_count);
+		r->right = delete_node(r->right, element, decrement_count);
 	else {
-		if (r->left != NULL && r->right != NULL) {
-			ds_bst_node* successor = in_order_successor(r);
-			memcpy(r->info, successor->info, element_size);
-
-			r->right = delete_node(r->right, successor->info, element_size, decrement_count);
-		}
-		else {
-			ds_bst_node* node = (r->left != NULL) ? r->left : r->right;
-			if (node == NULL) { // is leaf...
-				node = r;
-				r = NULL;
-			}
-			else {
-				memcpy(r->info, node->info, element_size);
-				r->left = node->left;
-				r->right = node->right;
-			}
-
-			delete_ds_bst_node(node);
-			*decrement_count = 1;
-		}
+		// the node is unlinked and its children are joined, elements of the other nodes never move in memory
+		ds_bst_node* parent = r->parent;
+		ds_bst_node* left;
+		ds_bst_node* right;
+		expose(r, &left, &right);
+		delete_ds_bst_node(r);
+		*decrement_count = 1;
+
+		// the joined subtree is balanced and at most one level shorter than the removed one
+		ds_bst_node* joined = join2_nodes(left, right);
+		if (joined != NULL)
+			joined->parent = parent;
+		return joined;
 	}
 
 	if (r == NULL)
 		return NULL;
 
-	r->height = 1 + max(node_height(r->left), node_height(r->right));
+	node_update(r);
 
 	// rebalance if necessary...
-	int balance = node_balance(r);
-	if (balance > 1 && node_balance(r->left) >= 0)
-		return rotate_right(r);
+	return rebalance(r);
+}
 
-	if (balance > 1 && node_balance(r->left) < 0) {
-		r->left = rotate_left(r->left);
-		return rotate_right(r);
-	}
+// it removes a given node, then it rebalances the tree walking up to the root
+static void unlink_node(ds_bst* bt, ds_bst_node* node) {
+	ds_bst_node* parent = node->parent;
+	ds_bst_node* left;
+	ds_bst_node* right;
+	expose(node, &left, &right);
+
+	ds_bst_node* child = join2_nodes(left, right);
+	if (child != NULL)
+		child->parent = parent;
+	if (parent == NULL)
+		bt->root = child;
+	else if (parent->left == node)
+		parent->left = child;
+	else
+		parent->right = child;
+	delete_ds_bst_node(node);
+	bt->elements--;
+
+	while (parent != NULL) {
+		ds_bst_node* grandparent = parent->parent;
+		int is_left = grandparent != NULL && grandparent->left == parent;
+
+		node_update(parent);
+		ds_bst_node* r = rebalance(parent);
+		if (grandparent == NULL)
+			bt->root = r;
+		else if (is_left)
+			grandparent->left = r;
+		else
+			grandparent->right = r;
 
-	if (balance < -1 && node_balance(r->right) <= 0)
-		return rotate_left(r);
-	
-	if (balance < -1 && node_balance(r->right) > 0) {
-		r->right = rotate_right(r->right);
-		return rotate_left(r);
+		parent = grandparent;
 	}
+}
 
-	return r;
+// it returns the first node equal to element
+static ds_bst_node* first_equal(ds_bst* bt, const void* element) {
+	ds_bst_iterator it = ds_bst_lower_bound(bt, element);
+	if (it.current != NULL && bt->cmp(element, it.current->info) == 0)
+		return it.current;
+
+	return NULL;
 }
 
 ds_result ds_bst_remove(ds_bst* bt, const void* element) {
@@ -413,26 +1157,84 @@ ds_result ds_bst_remove(ds_bst* bt, const void* element) {
 	if (bt->root == NULL)
 		return SUCCESS;
 
+	if (bt->multi) {
+		ds_bst_node* node = first_equal(bt, element);
+		if (node != NULL)
+			unlink_node(bt, node);
+		return SUCCESS;
+	}
+
 	char decrement_count = 0;
-	bt->root = delete_node(bt->root, element, bt->element_size, &decrement_count);
+	bt->root = delete_node(bt->root, element, &decrement_count);
 	if (decrement_count)
 		bt->elements--;
 
 	return SUCCESS;
 }
 
+ds_result ds_bst_remove_all(ds_bst* bt, const void* element) {
+	if (bt == NULL || element == NULL)
+		return GENERIC_ERROR;
+	if (!bt->multi)
+		return ds_bst_remove(bt, element);
+
+	// the equal elements are split away as a whole subtree, then the rest is joined back
+	ds_bst_node* lt;
+	ds_bst_node* rest;
+	ds_bst_node* eq;
+	ds_bst_node* gt;
+	split_at(bt->cmp, bt->root, element, 0, &lt, &rest);
+	split_at(bt->cmp, rest, element, 1, &eq, &gt);
+
+	bt->elements -= node_size(eq);
+	free_nodes(eq);
+	bt->root = join2_nodes(lt, gt);
+
+	return SUCCESS;
+}
+
+void ds_bst_erase(ds_bst* bt, ds_bst_iterator* it) {
+	if (bt == NULL || it == NULL || it->current == NULL)
+		return;
+
+	// elements never move, so the successor is still the next element once the node is gone
+	ds_bst_node* next = in_order_successor(it->current);
+	unlink_node(bt, it->current);
+	it->current = next;
+}
+
+size_t ds_bst_count(ds_bst* bt, const void* element) {
+	if (bt == NULL || element == NULL)
+		return 0;
+
+	// the equal elements are the ones between the rank of element and the number of elements less than or equal to it
+	size_t less_or_equal = 0;
+	ds_bst_node* n = bt->root;
+	while (n != NULL) {
+		if (bt->cmp(element, n->info) < 0)
+			n = n->left;
+		else {
+			less_or_equal += node_size(n->left) + 1;
+			n = n->right;
+		}
+	}
+
+	return less_or_equal - ds_bst_rank(bt, element);
+}
+
 int ds_bst_search(ds_bst* bt, const void* element) {
 	if (bt == NULL || element == NULL || bt->root == NULL)
 		return 0;
 
-	return node_search(bt->cmp, bt->root, element) != NULL;
+	return ds_bst_get(bt, element) != NULL;
 }
 
 const void* ds_bst_get(ds_bst* bt, const void* element) {
 	if (bt == NULL || element == NULL || bt->root == NULL)
 		return NULL;
 
-	ds_bst_node* res = node_search(bt->cmp, bt->root, element);
+	// in a multi tree the first of the equal elements is returned
+	ds_bst_node* res = bt->multi ? first_equal(bt, element) : node_search(bt, element);
 	if (res == NULL)
 		return NULL;
 	return res->info;
@@ -473,9 +1275,196 @@ const void* ds_bst_min(ds_bst* bt) {
 	return min->info;
 }
 
+size_t ds_bst_rank(ds_bst* bt, const void* element) {
+	if (bt == NULL || element == NULL)
+		return 0;
+
+	size_t rank = 0;
+	ds_bst_node* n = bt->root;
+	while (n != NULL) {
+		int cmp_res = bt->cmp(element, n->info);
+		if (cmp_res <= 0)
+			n = n->left;
+		else {
+			rank += node_size(n->left) + 1;
+			n = n->right;
+		}
+	}
+
+	return rank;
+}
+
+const void* ds_bst_select(ds_bst* bt, const size_t k) {
+	if (bt == NULL || k >= bt->elements)
+		return NULL;
+
+	size_t pos = k;
+	ds_bst_node* n = bt->root;
+	while (n != NULL) {
+		size_t left_size = node_size(n->left);
+		if (pos < left_size)
+			n = n->left;
+		else if (pos > left_size) {
+			pos -= left_size + 1;
+			n = n->right;
+		}
+		else
+			return n->info;
+	}
+
+	return NULL;
+}
+
+size_t ds_bst_count_range(ds_bst* bt, const void* lo, const void* hi) {
+	if (bt == NULL || lo == NULL || hi == NULL || bt->cmp(lo, hi) >= 0)
+		return 0;
+
+	return ds_bst_rank(bt, hi) - ds_bst_rank(bt, lo);
+}
+
+void ds_bst_range_visit(ds_bst* bt, const void* lo, const void* hi, void (*visit_element)(const void*, void*), void* other_args) {
+	if (bt == NULL || lo == NULL || hi == NULL)
+		return;
+
+	// subtrees outside the range are never entered: we jump to the first element
+	// in range and walk the successors until we go past hi
+	ds_bst_iterator it = ds_bst_lower_bound(bt, lo);
+	while (ds_bst_iterator_is_valid(&it) && bt->cmp(it.current->info, hi) < 0) {
+		visit_element(it.current->info, other_args);
+		ds_bst_iterator_next(&it);
+	}
+}
+
+struct visit_adapter {
+	void (*visit_element)(const void*, void*);
+	void* other_args;
+};
+
+static int adapt_visit(const void* element, void* aux) {
+	struct visit_adapter* adapter = (struct visit_adapter*) aux;
+	adapter->visit_element(element, adapter->other_args);
+
+	return 0;
+}
+
 void ds_bst_visit(ds_bst* bt, void (*visit_element)(const void*, void*), void* other_args, ds_visit_type type) {
 	if (bt == NULL)
 		return;
 
-	node_visit(bt->root, visit_element, other_args, type);
+	struct visit_adapter adapter;
+	adapter.visit_element = visit_element;
+	adapter.other_args = other_args;
+	node_walk(bt->root, bt->elements, adapt_visit, &adapter, type);
+}
+
+int ds_bst_visit_until(ds_bst* bt, int (*visit_element)(const void*, void*), void* other_args, ds_visit_type type) {
+	if (bt == NULL)
+		return 0;
+
+	return node_walk(bt->root, bt->elements, visit_element, other_args, type);
+}
+
+ds_result ds_bst_split(ds_bst* bt, const void* element, ds_bst** lt, ds_bst** gt) {
+	if (bt == NULL || element == NULL || lt == NULL || gt == NULL)
+		return GENERIC_ERROR;
+
+	*lt = create_ds_bst(bt->cmp, bt->element_size);
+	*gt = create_ds_bst(bt->cmp, bt->element_size);
+	if (*lt == NULL || *gt == NULL) {
+		delete_ds_bst(*lt);
+		delete_ds_bst(*gt);
+		*lt = NULL;
+		*gt = NULL;
+		return GENERIC_ERROR;
+	}
+	(*lt)->augment = bt->augment;
+	(*gt)->augment = bt->augment;
+	(*lt)->multi = bt->multi;
+	(*gt)->multi = bt->multi;
+
+	// in a multi tree the whole run of equal elements stays in bt
+	ds_bst_node* found;
+	if (bt->multi) {
+		ds_bst_node* rest;
+		split_at(bt->cmp, bt->root, element, 0, &(*lt)->root, &rest);
+		split_at(bt->cmp, rest, element, 1, &found, &(*gt)->root);
+	}
+	else
+		split_nodes(bt->cmp, bt->root, element, &(*lt)->root, &found, &(*gt)->root);
+	(*lt)->elements = node_size((*lt)->root);
+	(*gt)->elements = node_size((*gt)->root);
+
+	bt->root = found;
+	bt->elements = node_size(found);
+
+	return SUCCESS;
+}
+
+ds_result ds_bst_join(ds_bst* lt, ds_bst* gt) {
+	// a set cannot take the elements of a tree that may hold duplicates
+	if (lt == NULL || gt == NULL || lt->element_size != gt->element_size || (gt->multi && !lt->multi))
+		return GENERIC_ERROR;
+	if (gt->root == NULL)
+		return SUCCESS;
+
+	// equal elements at the boundary are fine when the resulting tree accepts duplicates
+	if (lt->root != NULL) {
+		int cmp_res = lt->cmp(get_max(lt->root)->info, get_min(gt->root)->info);
+		if (cmp_res > 0 || (cmp_res == 0 && !lt->multi))
+			return GENERIC_ERROR;
+	}
+
+	lt->root = join2_nodes(lt->root, gt->root);
+	lt->elements += gt->elements;
+	gt->root = NULL;
+	gt->elements = 0;
+
+	return SUCCESS;
+}
+
+static ds_result set_operation(ds_bst* a, const ds_bst* b, set_op op, unsigned threads) {
+	// set operations work on sets, duplicates would be matched one against many
+	if (a == NULL || b == NULL || a->element_size != b->element_size || a->multi || b->multi)
+		return GENERIC_ERROR;
+
+	// b must be left untouched, while the operation consumes its second argument
+	ds_bst_node* copy = copy_nodes(b->root, NULL, b->element_size);
+	if (copy == NULL && b->root != NULL)
+		return GENERIC_ERROR;
+
+	// every fork doubles the threads at work
+	int forks = 0;
+	while (threads >= 2) {
+		threads /= 2;
+		forks++;
+	}
+
+	a->root = op(a->cmp, a->root, copy, forks);
+	a->elements = node_size(a->root);
+
+	return SUCCESS;
+}
+
+ds_result ds_bst_union(ds_bst* a, const ds_bst* b) {
+	return set_operation(a, b, union_nodes, 1);
+}
+
+ds_result ds_bst_intersection(ds_bst* a, const ds_bst* b) {
+	return set_operation(a, b, intersection_nodes, 1);
+}
+
+ds_result ds_bst_difference(ds_bst* a, const ds_bst* b) {
+	return set_operation(a, b, difference_nodes, 1);
+}
+
+ds_result ds_bst_union_parallel(ds_bst* a, const ds_bst* b, unsigned threads) {
+	return set_operation(a, b, union_nodes, threads);
+}
+
+ds_result ds_bst_intersection_parallel(ds_bst* a, const ds_bst* b, unsigned threads) {
+	return set_operation(a, b, intersection_nodes, threads);
+}
+
+ds_result ds_bst_difference_parallel(ds_bst* a, const ds_bst* b, unsigned threads) {
+	return set_operation(a, b, difference_nodes, threads);
 }
@@ -11,6 +11,7 @@
 
 #include "result.h"
 #include "defs.h"
+#include "vect.h"
 
 #include <stddef.h>
 
@@ -24,6 +25,11 @@ typedef struct ds_bst ds_bst;
  */
 typedef struct ds_bst_node ds_bst_node;
 
+/**
+ * This is the type of the functions that recompute the augmented fields of an element from the elements of the children of its node.
+ */
+typedef void (*ds_bst_augment)(void*, const void*, const void*);
+
 /**
  * This is a structure that represents an iterator for a binary tree
  */
@@ -34,8 +40,11 @@ typedef struct ds_bst_iterator {
 
 /**
  * This represents the supported visiting strategies.
+ * Depth-first visits follow parent links and need no additional memory, while the level order (breadth-first) visit
+ * needs a queue as big as the number of elements. If the queue cannot be allocated, the level order visit walks
+ * every level down from the root instead: it needs no memory, but it takes O(n log n) at worst.
  */
-typedef enum ds_visit_type { DFS_PRE_ORDER, DFS_IN_ORDER, DFS_POST_ORDER } ds_visit_type;
+typedef enum ds_visit_type { DFS_PRE_ORDER, DFS_IN_ORDER, DFS_POST_ORDER, BFS_LEVEL_ORDER } ds_visit_type;
 
 /**
  * This function will move the iterator forward.
@@ -175,6 +184,121 @@ const void* ds_bst_node_get(ds_bst_node* node);
  */
 ds_bst* create_ds_bst(ds_cmp cmp_func, const size_t size);
 
+/**
+ * This function will create an instance of ds_bst whose elements carry augmented fields, i.e. fields summarising
+ * the subtree of the node holding the element (e.g. the maximum of some value within the subtree). augment_func is
+ * called whenever the subtree of a node changes (insertions, removals, rotations, joins and splits), from the bottom up,
+ * so the augmented fields of the children are always up to date. It must not change the part of the element compared by cmp_func.
+ *
+ * @param cmp_func This is the pointer to a function that will be used to compare two elements.
+ * @param size It is the size of the element that the tree is supposed to store.
+ * @param augment_func It is a function like func(void* element, const void* left, const void* right), where left and right are the elements of the children (NULL if missing).
+ *
+ * @return It returns the pointer to a new instance of ds_bst.
+ */
+ds_bst* create_ds_bst_augmented(ds_cmp cmp_func, const size_t size, ds_bst_augment augment_func);
+
+/**
+ * This function will create an instance of ds_bst that accepts duplicates (a multiset). Equal elements are kept
+ * in insertion order, ds_bst_get and ds_bst_remove work on the first of them, and ds_bst_get_or_insert always inserts.
+ * Use ds_bst_lower_bound and ds_bst_upper_bound to walk all the elements equal to a given one.
+ *
+ * @param cmp_func This is the pointer to a function that will be used to compare two elements.
+ * @param size It is the size of the element that the tree is supposed to store.
+ *
+ * @return It returns the pointer to a new instance of ds_bst.
+ */
+ds_bst* create_ds_bst_multi(ds_cmp cmp_func, const size_t size);
+
+/**
+ * This function will create an augmented instance of ds_bst that accepts duplicates. It combines
+ * create_ds_bst_augmented and create_ds_bst_multi.
+ *
+ * @param cmp_func This is the pointer to a function that will be used to compare two elements.
+ * @param size It is the size of the element that the tree is supposed to store.
+ * @param augment_func See create_ds_bst_augmented.
+ *
+ * @return It returns the pointer to a new instance of ds_bst.
+ */
+ds_bst* create_ds_bst_multi_augmented(ds_cmp cmp_func, const size_t size, ds_bst_augment augment_func);
+
+/**
+ * This function will tell if the tree accepts duplicates.
+ *
+ * @param bt The binary tree.
+ *
+ * @return It returns 1 if the tree has been created by create_ds_bst_multi or create_ds_bst_multi_augmented, 0 otherwise.
+ */
+int ds_bst_is_multi(const ds_bst* bt);
+
+/**
+ * This function will create an instance of ds_bst filled with the given elements, that must be sorted in
+ * ascending order without duplicates. The tree is built as a perfectly balanced AVL tree in O(n), with no
+ * rotations and no comparisons other than the ones needed to check the order of the input.
+ *
+ * @param cmp_func This is the pointer to a function that will be used to compare two elements.
+ * @param size It is the size of a single element.
+ * @param data It is the pointer to an array of n elements laid out contiguously.
+ * @param n It is the number of elements.
+ * 
+ * @return It returns the pointer to a new instance of ds_bst, NULL if the input is not strictly sorted or if the memory cannot be allocated.
+ */
+ds_bst* ds_bst_build_sorted(ds_cmp cmp_func, const size_t size, const void* data, const size_t n);
+
+/**
+ * This function will create an instance of ds_bst filled with the elements of a vector, that must be sorted in
+ * ascending order without duplicates. See ds_bst_build_sorted.
+ *
+ * @param cmp_func This is the pointer to a function that will be used to compare two elements.
+ * @param v The vector holding the elements.
+ * 
+ * @return It returns the pointer to a new instance of ds_bst, NULL if the input is not strictly sorted or if the memory cannot be allocated.
+ */
+ds_bst* ds_bst_build_sorted_vect(ds_cmp cmp_func, const ds_vect* v);
+
+/**
+ * This function will create an instance of ds_bst filled with n elements produced by a function, in the same
+ * way as ds_bst_build_sorted. It is meant for elements that are not laid out in an array (e.g. they are decoded
+ * from a file). The elements are requested in no particular order, and their order is not checked: the caller
+ * must guarantee that element i is smaller than element i + 1.
+ *
+ * @param cmp_func This is the pointer to a function that will be used to compare two elements.
+ * @param size It is the size of a single element.
+ * @param n It is the number of elements.
+ * @param element_at The function returning the i-th element, like func(size_t, void*) where the first argument is the position and the second is other_args. The returned element is copied before the next call.
+ * @param other_args It is the second argument to pass element_at.
+ * 
+ * @return It returns the pointer to a new instance of ds_bst, NULL if the memory cannot be allocated.
+ */
+ds_bst* ds_bst_build_sorted_from(ds_cmp cmp_func, const size_t size, const size_t n, const void* (*element_at)(size_t, void*), void* other_args);
+
+/**
+ * This function will create an instance of ds_bst that accepts duplicates, filled with the given elements, that must be
+ * sorted in ascending order. Equal elements are allowed and keep their order. See ds_bst_build_sorted.
+ *
+ * @param cmp_func This is the pointer to a function that will be used to compare two elements.
+ * @param size It is the size of a single element.
+ * @param data It is the pointer to an array of n elements laid out contiguously.
+ * @param n It is the number of elements.
+ * 
+ * @return It returns the pointer to a new instance of ds_bst, NULL if the input is not sorted or if the memory cannot be allocated.
+ */
+ds_bst* ds_bst_build_sorted_multi(ds_cmp cmp_func, const size_t size, const void* data, const size_t n);
+
+/**
+ * This function will create an instance of ds_bst that accepts duplicates, filled with n elements produced by a function.
+ * The caller must guarantee that element i is not bigger than element i + 1. See ds_bst_build_sorted_from.
+ *
+ * @param cmp_func This is the pointer to a function that will be used to compare two elements.
+ * @param size It is the size of a single element.
+ * @param n It is the number of elements.
+ * @param element_at The function returning the i-th element, like func(size_t, void*) where the first argument is the position and the second is other_args. The returned element is copied before the next call.
+ * @param other_args It is the second argument to pass element_at.
+ * 
+ * @return It returns the pointer to a new instance of ds_bst, NULL if the memory cannot be allocated.
+ */
+ds_bst* ds_bst_build_sorted_multi_from(ds_cmp cmp_func, const size_t size, const size_t n, const void* (*element_at)(size_t, void*), void* other_args);
+
 /**
  * This function will release the memory allocated to the binary tree.
  * Elements stored in the list will be freed using 'free'.
@@ -192,6 +316,16 @@ void delete_ds_bst(ds_bst* bt);
  */
 ds_cmp ds_bst_cmp(ds_bst* bt);
 
+/**
+ * This function will return the root of the tree, it can be used with ds_bst_node_left and ds_bst_node_right
+ * to walk the tree (e.g. to search it using augmented fields).
+ *
+ * @param bt The binary tree.
+ *
+ * @return It returns the root node, NULL if the tree is empty.
+ */
+ds_bst_node* ds_bst_root(ds_bst* bt);
+
 /**
  * This function will return the number of elements store in the binary tree.
  *
@@ -201,6 +335,15 @@ ds_cmp ds_bst_cmp(ds_bst* bt);
  */
 size_t ds_bst_size(const ds_bst* bt);
 
+/**
+ * This function will return the size of the elements stored in the binary tree.
+ *
+ * @param bt The binary tree.
+ * 
+ * @return The size of a single element, as given when the tree has been created.
+ */
+size_t ds_bst_element_size(const ds_bst* bt);
+
 /**
  * This function will insert an element into the binary tree.
  *
@@ -212,7 +355,21 @@ size_t ds_bst_size(const ds_bst* bt);
 ds_result ds_bst_insert(ds_bst* bt, const void* element);
 
 /**
- * This function will remove an element into the binary tree if exists.
+ * This function will look for an element into the binary tree and insert it if it does not exist,
+ * walking the tree only once. The returned element can be changed, as long as the changes do not
+ * affect the way it compares with the other elements.
+ *
+ * @param bt The binary tree.
+ * @param element The element.
+ * @param inserted If not NULL, it is set to 1 if the element has been inserted, 0 if it already existed.
+ *
+ * @return It returns a pointer to the element into the binary tree, NULL if the memory cannot be allocated.
+ */
+void* ds_bst_get_or_insert(ds_bst* bt, const void* element, int* inserted);
+
+/**
+ * This function will remove an element into the binary tree if exists. If the tree accepts duplicates, the first
+ * of the equal elements is removed.
  *
  * @param bt The binary tree.
  * @param element The element.
@@ -220,6 +377,35 @@ ds_result ds_bst_insert(ds_bst* bt, const void* element);
  */
 ds_result ds_bst_remove(ds_bst* bt, const void* element);
 
+/**
+ * This function will remove all the elements equal to the given one in O(log n + k), where k is the number of
+ * removed elements.
+ *
+ * @param bt The binary tree.
+ * @param element The element.
+ * @return The result of the operation.
+ */
+ds_result ds_bst_remove_all(ds_bst* bt, const void* element);
+
+/**
+ * This function will remove the element pointed by the iterator, which is moved to the next element.
+ * The other iterators remain valid.
+ *
+ * @param bt The binary tree.
+ * @param it The iterator.
+ */
+void ds_bst_erase(ds_bst* bt, ds_bst_iterator* it);
+
+/**
+ * This function will count the elements equal to the given one in O(log n).
+ *
+ * @param bt The binary tree.
+ * @param element The element.
+ *
+ * @return It returns the number of elements equal to element.
+ */
+size_t ds_bst_count(ds_bst* bt, const void* element);
+
 /**
  * This function will look for an element into the binary tree.
  *
@@ -232,7 +418,8 @@ int ds_bst_search(ds_bst* bt, const void* element);
 
 /**
  * This function will look for an element into the binary tree, if exists it will
- * return a pointer to the element, NULL otherwise.
+ * return a pointer to the element, NULL otherwise. Elements never move in memory,
+ * so the pointer is valid until the element is removed.
  * 
  * @param bt The binary tree.
  * @param element The element we are looking for.
@@ -259,6 +446,39 @@ const void* ds_bst_max(ds_bst* bt);
  */
 const void* ds_bst_min(ds_bst* bt);
 
+/**
+ * This function will return the rank of an element, i.e. the number of elements in the binary tree
+ * that are smaller than the given one. The element does not need to be stored in the tree.
+ * Every node keeps the size of its subtree, therefore it takes O(log n).
+ *
+ * @param bt The binary tree.
+ * @param element The element.
+ * 
+ * @return The number of elements smaller than the given one.
+ */
+size_t ds_bst_rank(ds_bst* bt, const void* element);
+
+/**
+ * This function will return the k-th smallest element of the binary tree (k starts from 0).
+ *
+ * @param bt The binary tree.
+ * @param k The position of the element in the sorted sequence.
+ * 
+ * @return It returns a pointer to the k-th smallest element, NULL if k is not smaller than the size of the tree.
+ */
+const void* ds_bst_select(ds_bst* bt, const size_t k);
+
+/**
+ * This function will count the elements that fall within the range [lo, hi).
+ *
+ * @param bt The binary tree.
+ * @param lo The lower bound of the range (included).
+ * @param hi The upper bound of the range (excluded).
+ * 
+ * @return The number of elements e such that lo <= e < hi. It returns 0 when the range is empty.
+ */
+size_t ds_bst_count_range(ds_bst* bt, const void* lo, const void* hi);
+
 /**
  * This function will return an iterator to the first (smallest) element of the binary tree.
  * 
@@ -277,6 +497,59 @@ ds_bst_iterator ds_bst_first(ds_bst* bt);
  */
 ds_bst_iterator ds_bst_last(ds_bst* bt);
 
+/**
+ * This function will return an iterator to the first element that is not smaller than the given one.
+ * 
+ * @param bt The binary tree.
+ * @param element The element to compare with.
+ * 
+ * @return The iterator to the first element e such that e >= element. The iterator is not valid if such element does not exist.
+ */
+ds_bst_iterator ds_bst_lower_bound(ds_bst* bt, const void* element);
+
+/**
+ * This function will return an iterator to the first element that is bigger than the given one.
+ * 
+ * @param bt The binary tree.
+ * @param element The element to compare with.
+ * 
+ * @return The iterator to the first element e such that e > element. The iterator is not valid if such element does not exist.
+ */
+ds_bst_iterator ds_bst_upper_bound(ds_bst* bt, const void* element);
+
+/**
+ * This function will return an iterator to the biggest element that is not bigger than the given one.
+ * 
+ * @param bt The binary tree.
+ * @param element The element to compare with.
+ * 
+ * @return The iterator to the last element e such that e <= element. The iterator is not valid if such element does not exist.
+ */
+ds_bst_iterator ds_bst_floor(ds_bst* bt, const void* element);
+
+/**
+ * This function will return an iterator to the smallest element that is not smaller than the given one.
+ * It is the same as ds_bst_lower_bound.
+ * 
+ * @param bt The binary tree.
+ * @param element The element to compare with.
+ * 
+ * @return The iterator to the first element e such that e >= element. The iterator is not valid if such element does not exist.
+ */
+ds_bst_iterator ds_bst_ceiling(ds_bst* bt, const void* element);
+
+/**
+ * This function will visit, in order, the elements that fall within the range [lo, hi).
+ * Subtrees outside the range are skipped, so it takes O(log n + k) where k is the number of visited elements.
+ *
+ * @param bt The binary tree.
+ * @param lo The lower bound of the range (included).
+ * @param hi The upper bound of the range (excluded).
+ * @param visit_func The function that will be used to visit the elements. See ds_bst_visit.
+ * @param other_args It is the second argument to pass visit_func.
+ */
+void ds_bst_range_visit(ds_bst* bt, const void* lo, const void* hi, void (*visit_func)(const void*, void*), void* other_args);
+
 /**
  * This function will implement a custom visit on tree nodes using a specified visiting strategy.
  *
@@ -287,4 +560,114 @@ ds_bst_iterator ds_bst_last(ds_bst* bt);
  */
 void ds_bst_visit(ds_bst* bt, void (*visit_func)(const void*, void*), void* other_args, ds_visit_type type);
 
+/**
+ * This function will implement a custom visit on tree nodes that can be stopped early. It works like ds_bst_visit,
+ * but the visit ends as soon as visit_func returns a value different from 0.
+ *
+ * @param bt The binary tree.
+ * @param visit_func The function that will be used to visit the element within the node. It returns 0 to go on with the visit, any other value to stop it.
+ * @param other_args It is the second argument to pass visit_func.
+ * @param type The type of the tree visit.
+ * 
+ * @return It returns 1 if the visit has been stopped by visit_func, 0 otherwise.
+ */
+int ds_bst_visit_until(ds_bst* bt, int (*visit_func)(const void*, void*), void* other_args, ds_visit_type type);
+
+/**
+ * This function will split the binary tree according to the given element. All the elements smaller than element are moved
+ * to a new tree stored in lt, while the bigger ones are moved to a new tree stored in gt. The element equal to the given one,
+ * if any, is the only one left in bt (all the equal ones, if the tree accepts duplicates). The new trees accept duplicates
+ * if bt does. It takes O(log n) and no element is copied.
+ * 
+ * @param bt The binary tree to split.
+ * @param element The element used to split the tree.
+ * @param lt It will hold a new tree with the elements smaller than element. It should be deleted with delete_ds_bst.
+ * @param gt It will hold a new tree with the elements bigger than element. It should be deleted with delete_ds_bst.
+ * 
+ * @return The result of the operation.
+ */
+ds_result ds_bst_split(ds_bst* bt, const void* element, ds_bst** lt, ds_bst** gt);
+
+/**
+ * This function will move all the elements of gt into lt. All the elements of lt must be smaller than the ones of gt
+ * (or equal, if lt accepts duplicates). It takes O(log n) and no element is copied. After the operation gt is empty.
+ * A tree accepting duplicates can be joined only into another tree accepting duplicates.
+ * 
+ * @param lt The binary tree with the smaller elements, it will hold the result.
+ * @param gt The binary tree with the bigger elements.
+ * 
+ * @return The result of the operation. It returns GENERIC_ERROR, leaving both trees untouched, if the elements are not ordered as expected
+ * or if gt accepts duplicates while lt does not.
+ */
+ds_result ds_bst_join(ds_bst* lt, ds_bst* gt);
+
+/**
+ * This function will add to a all the elements of b. Elements of a that are also in b are kept as they are.
+ * It takes O(m log(n/m + 1)) where m and n are the sizes of the smaller and the bigger tree. b is left untouched.
+ * 
+ * @param a The binary tree that will hold the result.
+ * @param b The other binary tree.
+ * 
+ * @return The result of the operation. It returns GENERIC_ERROR if either tree accepts duplicates.
+ */
+ds_result ds_bst_union(ds_bst* a, const ds_bst* b);
+
+/**
+ * This function will remove from a all the elements that are not in b.
+ * It takes O(m log(n/m + 1)) where m and n are the sizes of the smaller and the bigger tree. b is left untouched.
+ * 
+ * @param a The binary tree that will hold the result.
+ * @param b The other binary tree.
+ * 
+ * @return The result of the operation. It returns GENERIC_ERROR if either tree accepts duplicates.
+ */
+ds_result ds_bst_intersection(ds_bst* a, const ds_bst* b);
+
+/**
+ * This function will remove from a all the elements that are in b.
+ * It takes O(m log(n/m + 1)) where m and n are the sizes of the smaller and the bigger tree. b is left untouched.
+ * 
+ * @param a The binary tree that will hold the result.
+ * @param b The other binary tree.
+ * 
+ * @return The result of the operation. It returns GENERIC_ERROR if either tree accepts duplicates.
+ */
+ds_result ds_bst_difference(ds_bst* a, const ds_bst* b);
+
+/**
+ * This function works as ds_bst_union, but the two halves of the divide and conquer run on separate threads,
+ * down to subtrees of a few thousand elements. The comparison and the augment functions (if any) must be safe
+ * to call from many threads at once, and no other thread may use a or b meanwhile.
+ * 
+ * @param a The binary tree that will hold the result.
+ * @param b The other binary tree.
+ * @param threads The number of threads that may work at once, rounded down to a power of two. With 0 or 1 it is the same as ds_bst_union.
+ * 
+ * @return The result of the operation. It returns GENERIC_ERROR if either tree accepts duplicates.
+ * If a thread cannot be created, its work is done by the calling thread.
+ */
+ds_result ds_bst_union_parallel(ds_bst* a, const ds_bst* b, unsigned threads);
+
+/**
+ * This function works as ds_bst_intersection, running on up to the given number of threads. See ds_bst_union_parallel.
+ * 
+ * @param a The binary tree that will hold the result.
+ * @param b The other binary tree.
+ * @param threads The number of threads that may work at once, rounded down to a power of two.
+ * 
+ * @return The result of the operation. It returns GENERIC_ERROR if either tree accepts duplicates.
+ */
+ds_result ds_bst_intersection_parallel(ds_bst* a, const ds_bst* b, unsigned threads);
+
+/**
+ * This function works as ds_bst_difference, running on up to the given number of threads. See ds_bst_union_parallel.
+ * 
+ * @param a The binary tree that will hold the result.
+ * @param b The other binary tree.
+ * @param threads The number of threads that may work at once, rounded down to a power of two.
+ * 
+ * @return The result of the operation. It returns GENERIC_ERROR if either tree accepts duplicates.
+ */
+ds_result ds_bst_difference_parallel(ds_bst* a, const ds_bst* b, unsigned threads);
+
 #endif
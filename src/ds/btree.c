@@ -0,0 +1,578 @@
+/*
+ * @file btree.c
+ * @author Valerio Bellizia
+ */
+
+#include "btree.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// the size of the elements of a node, it should span a few cache lines
+#define NODE_BYTES 256
+#define MIN_CAPACITY 4
+
+// elements start right after the node header, they are kept aligned for any type
+#define KEYS_ALIGN 16
+#define KEYS_OFFSET (((sizeof(ds_btree_node) + KEYS_ALIGN - 1) / KEYS_ALIGN) * KEYS_ALIGN)
+
+// these macros return the pointer to the element at position POS and the pointer to the children of an internal node
+#define KEY_AT(THIS, NODE, POS) ((char*)(NODE) + KEYS_OFFSET + ((size_t)(POS) * (THIS)->element_size))
+#define CHILDREN(THIS, NODE) ((ds_btree_node**)((char*)(NODE) + (THIS)->children_offset))
+
+// struct definitions
+
+struct ds_btree {
+	ds_btree_node* root;
+	ds_cmp cmp;
+	size_t elements;
+	size_t element_size;
+
+	// the maximum number of elements in a node, every node but the root holds at least half of them
+	int capacity;
+	size_t children_offset;
+
+	// scratch space used to move a separator from a node to its parent
+	char* separator;
+};
+
+/*
+ * A node is a single block of memory: the header, then capacity + 1 elements (one more than
+ * needed so that a node can overflow before being split) and, for internal nodes only,
+ * capacity + 2 pointers to the children. Child i holds the elements that are not smaller
+ * than the separator i - 1 and smaller than the separator i.
+ */
+struct ds_btree_node {
+	int leaf;
+	int count;
+
+	// leaves are linked to walk the elements in order
+	struct ds_btree_node* prev;
+	struct ds_btree_node* next;
+};
+
+// helpers
+
+static int min_count(const ds_btree* this) {
+	return this->capacity / 2;
+}
+
+static ds_btree_node* create_node(ds_btree* this, int leaf) {
+	size_t size = this->children_offset;
+	if (!leaf)
+		size += (this->capacity + 2) * sizeof(ds_btree_node*);
+
+	ds_btree_node* node = (ds_btree_node*) malloc(size);
+	if (node != NULL) {
+		node->leaf = leaf;
+		node->count = 0;
+		node->prev = NULL;
+		node->next = NULL;
+	}
+
+	return node;
+}
+
+static void free_node(ds_btree* this, ds_btree_node* node) {
+	if (!node->leaf) {
+		ds_btree_node** children = CHILDREN(this, node);
+		for (int i = 0; i <= node->count; ++i)
+			free_node(this, children[i]);
+	}
+
+	free(node);
+}
+
+// it returns the position of the first element not smaller than element, found is set if they are equal
+static int lower_bound_pos(const ds_btree* this, ds_btree_node* node, const void* element, int* found) {
+	int lo = 0;
+	int hi = node->count;
+	*found = 0;
+	while (lo < hi) {
+		int mid = lo + (hi - lo) / 2;
+		int cmp_res = this->cmp(KEY_AT(this, node, mid), element);
+		if (cmp_res < 0)
+			lo = mid + 1;
+		else {
+			if (cmp_res == 0)
+				*found = 1;
+			hi = mid;
+		}
+	}
+
+	return lo;
+}
+
+// it returns the index of the child of an internal node that may hold element, i.e. the position of the first element bigger than element
+static int child_pos(const ds_btree* this, ds_btree_node* node, const void* element) {
+	int lo = 0;
+	int hi = node->count;
+	while (lo < hi) {
+		int mid = lo + (hi - lo) / 2;
+		if (this->cmp(element, KEY_AT(this, node, mid)) < 0)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+
+	return lo;
+}
+
+static ds_btree_node* find_leaf(const ds_btree* this, const void* element) {
+	ds_btree_node* node = this->root;
+	while (!node->leaf)
+		node = CHILDREN(this, node)[child_pos(this, node, element)];
+
+	return node;
+}
+
+static void insert_key(ds_btree* this, ds_btree_node* node, int pos, const void* element) {
+	memmove(KEY_AT(this, node, pos + 1), KEY_AT(this, node, pos), (node->count - pos) * this->element_size);
+	memcpy(KEY_AT(this, node, pos), element, this->element_size);
+	node->count++;
+}
+
+static void remove_key(ds_btree* this, ds_btree_node* node, int pos) {
+	memmove(KEY_AT(this, node, pos), KEY_AT(this, node, pos + 1), (node->count - pos - 1) * this->element_size);
+	node->count--;
+}
+
+// it moves the upper half of an overflowing node to right, the separator to move up is copied to this->separator
+static void split_node(ds_btree* this, ds_btree_node* node, ds_btree_node* right) {
+	int mid = node->count / 2;
+
+	if (node->leaf) {
+		right->count = node->count - mid;
+		memcpy(KEY_AT(this, right, 0), KEY_AT(this, node, mid), right->count * this->element_size);
+		node->count = mid;
+		memcpy(this->separator, KEY_AT(this, right, 0), this->element_size);
+
+		right->next = node->next;
+		right->prev = node;
+		if (node->next != NULL)
+			node->next->prev = right;
+		node->next = right;
+	}
+	else {
+		// the middle element moves up, it is not kept in any of the two halves
+		right->count = node->count - mid - 1;
+		memcpy(KEY_AT(this, right, 0), KEY_AT(this, node, mid + 1), right->count * this->element_size);
+		memcpy(CHILDREN(this, right), CHILDREN(this, node) + mid + 1, (right->count + 1) * sizeof(ds_btree_node*));
+		memcpy(this->separator, KEY_AT(this, node, mid), this->element_size);
+		node->count = mid;
+	}
+}
+
+// it returns the new sibling if the node has been split, result is set to the result of the insertion
+static ds_btree_node* insert_element(ds_btree* this, ds_btree_node* node, const void* element, ds_result* result) {
+	// a full node may need to be split: its new sibling is allocated before changing anything
+	ds_btree_node* sibling = NULL;
+	if (node->count == this->capacity) {
+		sibling = create_node(this, node->leaf);
+		if (sibling == NULL) {
+			*result = GENERIC_ERROR;
+			return NULL;
+		}
+	}
+
+	int split = 0;
+	if (node->leaf) {
+		int found;
+		int pos = lower_bound_pos(this, node, element, &found);
+		if (found)
+			*result = ELEMENT_ALREADY_EXISTS;
+		else {
+			insert_key(this, node, pos, element);
+			*result = SUCCESS;
+			split = node->count > this->capacity;
+		}
+	}
+	else {
+		int pos = child_pos(this, node, element);
+		ds_btree_node** children = CHILDREN(this, node);
+		ds_btree_node* child_sibling = insert_element(this, children[pos], element, result);
+		if (child_sibling != NULL) {
+			insert_key(this, node, pos, this->separator);
+			memmove(children + pos + 2, children + pos + 1, (node->count - pos - 1) * sizeof(ds_btree_node*));
+			children[pos + 1] = child_sibling;
+			split = node->count > this->capacity;
+		}
+	}
+
+	if (!split) {
+		free(sibling);
+		return NULL;
+	}
+
+	split_node(this, node, sibling);
+	return sibling;
+}
+
+static void borrow_from_left(ds_btree* this, ds_btree_node* parent, int i) {
+	ds_btree_node** children = CHILDREN(this, parent);
+	ds_btree_node* left = children[i - 1];
+	ds_btree_node* child = children[i];
+
+	if (child->leaf) {
+		insert_key(this, child, 0, KEY_AT(this, left, left->count - 1));
+		left->count--;
+		memcpy(KEY_AT(this, parent, i - 1), KEY_AT(this, child, 0), this->element_size);
+	}
+	else {
+		// the separator goes down to child, the last element of left goes up
+		ds_btree_node** child_children = CHILDREN(this, child);
+		memmove(child_children + 1, child_children, (child->count + 1) * sizeof(ds_btree_node*));
+		child_children[0] = CHILDREN(this, left)[left->count];
+		insert_key(this, child, 0, KEY_AT(this, parent, i - 1));
+		memcpy(KEY_AT(this, parent, i - 1), KEY_AT(this, left, left->count - 1), this->element_size);
+		left->count--;
+	}
+}
+
+static void borrow_from_right(ds_btree* this, ds_btree_node* parent, int i) {
+	ds_btree_node** children = CHILDREN(this, parent);
+	ds_btree_node* child = children[i];
+	ds_btree_node* right = children[i + 1];
+
+	if (child->leaf) {
+		insert_key(this, child, child->count, KEY_AT(this, right, 0));
+		remove_key(this, right, 0);
+		memcpy(KEY_AT(this, parent, i), KEY_AT(this, right, 0), this->element_size);
+	}
+	else {
+		// the separator goes down to child, the first element of right goes up
+		ds_btree_node** right_children = CHILDREN(this, right);
+		insert_key(this, child, child->count, KEY_AT(this, parent, i));
+		CHILDREN(this, child)[child->count] = right_children[0];
+		memcpy(KEY_AT(this, parent, i), KEY_AT(this, right, 0), this->element_size);
+		memmove(right_children, right_children + 1, right->count * sizeof(ds_btree_node*));
+		remove_key(this, right, 0);
+	}
+}
+
+// it merges the child i + 1 into the child i
+static void merge_children(ds_btree* this, ds_btree_node* parent, int i) {
+	ds_btree_node** children = CHILDREN(this, parent);
+	ds_btree_node* left = children[i];
+	ds_btree_node* right = children[i + 1];
+
+	if (left->leaf) {
+		left->next = right->next;
+		if (right->next != NULL)
+			right->next->prev = left;
+	}
+	else {
+		// the separator goes down between the elements of the two nodes
+		memcpy(KEY_AT(this, left, left->count), KEY_AT(this, parent, i), this->element_size);
+		left->count++;
+		memcpy(CHILDREN(this, left) + left->count, CHILDREN(this, right), (right->count + 1) * sizeof(ds_btree_node*));
+	}
+
+	memcpy(KEY_AT(this, left, left->count), KEY_AT(this, right, 0), right->count * this->element_size);
+	left->count += right->count;
+	free(right);
+
+	memmove(children + i + 1, children + i + 2, (parent->count - i - 1) * sizeof(ds_btree_node*));
+	remove_key(this, parent, i);
+}
+
+static void fix_underflow(ds_btree* this, ds_btree_node* parent, int i) {
+	ds_btree_node** children = CHILDREN(this, parent);
+
+	if (i > 0 && children[i - 1]->count > min_count(this))
+		borrow_from_left(this, parent, i);
+	else if (i < parent->count && children[i + 1]->count > min_count(this))
+		borrow_from_right(this, parent, i);
+	else if (i > 0)
+		merge_children(this, parent, i - 1);
+	else
+		merge_children(this, parent, i);
+}
+
+// it returns 1 if the element has been removed
+static int remove_element(ds_btree* this, ds_btree_node* node, const void* element) {
+	if (node->leaf) {
+		int found;
+		int pos = lower_bound_pos(this, node, element, &found);
+		if (found)
+			remove_key(this, node, pos);
+
+		return found;
+	}
+
+	int pos = child_pos(this, node, element);
+	ds_btree_node* child = CHILDREN(this, node)[pos];
+	int removed = remove_element(this, child, element);
+	if (removed && child->count < min_count(this))
+		fix_underflow(this, node, pos);
+
+	return removed;
+}
+
+static ds_btree_node* first_leaf(const ds_btree* this) {
+	ds_btree_node* node = this->root;
+	while (!node->leaf)
+		node = CHILDREN(this, node)[0];
+
+	return node;
+}
+
+static ds_btree_node* last_leaf(const ds_btree* this) {
+	ds_btree_node* node = this->root;
+	while (!node->leaf)
+		node = CHILDREN(this, node)[node->count];
+
+	return node;
+}
+
+static ds_btree_iterator create_iterator(const ds_btree* this, ds_btree_node* leaf, int pos) {
+	ds_btree_iterator it;
+	it.tree = this;
+	it.leaf = (leaf != NULL && pos >= 0 && pos < leaf->count) ? leaf : NULL;
+	it.pos = pos;
+
+	return it;
+}
+
+// Interface functions
+
+void ds_btree_iterator_next(ds_btree_iterator* it) {
+	it->pos++;
+	if (it->pos >= it->leaf->count) {
+		it->leaf = it->leaf->next;
+		it->pos = 0;
+	}
+}
+
+void ds_btree_iterator_prev(ds_btree_iterator* it) {
+	it->pos--;
+	if (it->pos < 0) {
+		it->leaf = it->leaf->prev;
+		it->pos = (it->leaf != NULL) ? it->leaf->count - 1 : 0;
+	}
+}
+
+int ds_btree_iterator_is_valid(ds_btree_iterator* it) {
+	return it->leaf != NULL;
+}
+
+const void* ds_btree_iterator_get(ds_btree_iterator* it) {
+	return KEY_AT(it->tree, it->leaf, it->pos);
+}
+
+ds_btree* create_ds_btree(ds_cmp cmp_func, const size_t size) {
+	ds_btree* bt = (ds_btree*) malloc(sizeof(ds_btree));
+	if (bt == NULL)
+		return NULL;
+
+	bt->cmp = cmp_func;
+	bt->elements = 0;
+	bt->element_size = size;
+	bt->capacity = (size > 0 && NODE_BYTES / size > MIN_CAPACITY) ? (int)(NODE_BYTES / size) : MIN_CAPACITY;
+
+	size_t keys_size = (bt->capacity + 1) * size;
+	bt->children_offset = KEYS_OFFSET + ((keys_size + sizeof(void*) - 1) / sizeof(void*)) * sizeof(void*);
+
+	bt->separator = (char*) malloc(size);
+	bt->root = create_node(bt, 1);
+	if (bt->separator == NULL || bt->root == NULL) {
+		free(bt->separator);
+		free(bt->root);
+		free(bt);
+		return NULL;
+	}
+
+	return bt;
+}
+
+void delete_ds_btree(ds_btree* bt) {
+	if (bt == NULL)
+		return;
+
+	free_node(bt, bt->root);
+	free(bt->separator);
+	free(bt);
+}
+
+ds_cmp ds_btree_cmp(ds_btree* bt) {
+	return bt->cmp;
+}
+
+size_t ds_btree_size(const ds_btree* bt) {
+	return bt->elements;
+}
+
+ds_result ds_btree_insert(ds_btree* bt, const void* element) {
+	if (bt == NULL || element == NULL)
+		return GENERIC_ERROR;
+
+	// if the root is full, it may be split and a new root will be needed
+	ds_btree_node* new_root = NULL;
+	if (bt->root->count == bt->capacity) {
+		new_root = create_node(bt, 0);
+		if (new_root == NULL)
+			return GENERIC_ERROR;
+	}
+
+	ds_result res;
+	ds_btree_node* sibling = insert_element(bt, bt->root, element, &res);
+	if (sibling != NULL) {
+		memcpy(KEY_AT(bt, new_root, 0), bt->separator, bt->element_size);
+		new_root->count = 1;
+		CHILDREN(bt, new_root)[0] = bt->root;
+		CHILDREN(bt, new_root)[1] = sibling;
+		bt->root = new_root;
+	}
+	else
+		free(new_root);
+
+	if (res == SUCCESS)
+		bt->elements++;
+
+	return res;
+}
+
+ds_result ds_btree_remove(ds_btree* bt, const void* element) {
+	if (bt == NULL)
+		return GENERIC_ERROR;
+	if (element == NULL)
+		return SUCCESS;
+
+	if (remove_element(bt, bt->root, element))
+		bt->elements--;
+
+	// the root may be left with a single child
+	if (!bt->root->leaf && bt->root->count == 0) {
+		ds_btree_node* old_root = bt->root;
+		bt->root = CHILDREN(bt, old_root)[0];
+		free(old_root);
+	}
+
+	return SUCCESS;
+}
+
+int ds_btree_search(ds_btree* bt, const void* element) {
+	return ds_btree_get(bt, element) != NULL;
+}
+
+const void* ds_btree_get(ds_btree* bt, const void* element) {
+	if (bt == NULL || element == NULL)
+		return NULL;
+
+	ds_btree_node* leaf = find_leaf(bt, element);
+	int found;
+	int pos = lower_bound_pos(bt, leaf, element, &found);
+
+	return found ? KEY_AT(bt, leaf, pos) : NULL;
+}
+
+const void* ds_btree_max(ds_btree* bt) {
+	if (bt == NULL || bt->elements == 0)
+		return NULL;
+
+	ds_btree_node* leaf = last_leaf(bt);
+	return KEY_AT(bt, leaf, leaf->count - 1);
+}
+
+const void* ds_btree_min(ds_btree* bt) {
+	if (bt == NULL || bt->elements == 0)
+		return NULL;
+
+	return KEY_AT(bt, first_leaf(bt), 0);
+}
+
+ds_btree_iterator ds_btree_first(ds_btree* bt) {
+	return create_iterator(bt, first_leaf(bt), 0);
+}
+
+ds_btree_iterator ds_btree_last(ds_btree* bt) {
+	ds_btree_node* leaf = last_leaf(bt);
+	return create_iterator(bt, leaf, leaf->count - 1);
+}
+
+ds_btree_iterator ds_btree_lower_bound(ds_btree* bt, const void* element) {
+	ds_btree_node* leaf = find_leaf(bt, element);
+	int found;
+	int pos = lower_bound_pos(bt, leaf, element, &found);
+
+	// all the elements of the leaf are smaller: the answer is the first element of the next one
+	if (pos == leaf->count) {
+		leaf = leaf->next;
+		pos = 0;
+	}
+
+	return create_iterator(bt, leaf, pos);
+}
+
+ds_btree_iterator ds_btree_upper_bound(ds_btree* bt, const void* element) {
+	ds_btree_node* leaf = find_leaf(bt, element);
+	int pos = child_pos(bt, leaf, element);
+
+	// all the elements of the leaf are not bigger: the answer is the first element of the next one
+	if (pos == leaf->count) {
+		leaf = leaf->next;
+		pos = 0;
+	}
+
+	return create_iterator(bt, leaf, pos);
+}
+
+ds_btree_iterator ds_btree_floor(ds_btree* bt, const void* element) {
+	ds_btree_iterator it = ds_btree_upper_bound(bt, element);
+	if (!ds_btree_iterator_is_valid(&it))
+		return ds_btree_last(bt);
+
+	ds_btree_iterator_prev(&it);
+	return it;
+}
+
+ds_btree_iterator ds_btree_ceiling(ds_btree* bt, const void* element) {
+	return ds_btree_lower_bound(bt, element);
+}
+
+void ds_btree_range_visit(ds_btree* bt, const void* lo, const void* hi, void (*visit_func)(const void*, void*), void* other_args) {
+	if (bt == NULL || lo == NULL || hi == NULL)
+		return;
+
+	// the walk starts from the leaf holding lo and follows the links until it goes past hi
+	ds_btree_iterator it = ds_btree_lower_bound(bt, lo);
+	while (ds_btree_iterator_is_valid(&it) && bt->cmp(ds_btree_iterator_get(&it), hi) < 0) {
+		visit_func(ds_btree_iterator_get(&it), other_args);
+		ds_btree_iterator_next(&it);
+	}
+}
+
+struct visit_adapter {
+	void (*visit_func)(const void*, void*);
+	void* other_args;
+};
+
+static int adapt_visit(const void* element, void* aux) {
+	struct visit_adapter* adapter = (struct visit_adapter*) aux;
+	adapter->visit_func(element, adapter->other_args);
+
+	return 0;
+}
+
+void ds_btree_visit(ds_btree* bt, void (*visit_func)(const void*, void*), void* other_args, ds_visit_type type) {
+	struct visit_adapter adapter;
+	adapter.visit_func = visit_func;
+	adapter.other_args = other_args;
+	ds_btree_visit_until(bt, adapt_visit, &adapter, type);
+}
+
+int ds_btree_visit_until(ds_btree* bt, int (*visit_func)(const void*, void*), void* other_args, ds_visit_type type) {
+	if (bt == NULL)
+		return 0;
+
+	// elements live in the leaves, which are all at the same depth: every visit meets them in order
+	(void) type;
+	for (ds_btree_node* leaf = first_leaf(bt); leaf != NULL; leaf = leaf->next) {
+		for (int i = 0; i < leaf->count; ++i) {
+			if (visit_func(KEY_AT(bt, leaf, i), other_args))
+				return 1;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,285 @@
+/**
+ * @file btree.h
+ * @author Valerio Bellizia
+ *
+ * This file contains the interface to be used with ds_btree. It implements
+ * an ordered container as a B+tree: every node stores its elements contiguously
+ * and it is sized to span a few cache lines, elements are stored in the leaves
+ * and leaves are linked to each other to walk the elements in order.
+ * It is an ordered set: the functions it shares with ds_bst have the same signatures, so
+ * code using ds_bst as a set can switch by renaming. It has no key/value interface, a map
+ * can be stored as elements compared by key (see ds_treemap for a map on top of ds_bst).
+ */
+
+#ifndef btree_h
+#define btree_h
+
+#include "result.h"
+#include "defs.h"
+#include "bst.h"
+
+#include <stddef.h>
+
+/**
+ * This is an opaque structure that represents a B+tree.
+ */
+typedef struct ds_btree ds_btree;
+
+/**
+ * This is an opaque structure that represents a B+tree node.
+ */
+typedef struct ds_btree_node ds_btree_node;
+
+/**
+ * This is a structure that represents an iterator for a B+tree.
+ */
+typedef struct ds_btree_iterator {
+	const ds_btree* tree;
+	ds_btree_node* leaf;
+	int pos;
+} ds_btree_iterator;
+
+/**
+ * This function will move the iterator forward.
+ *
+ * @param it The iterator.
+ */
+void ds_btree_iterator_next(ds_btree_iterator* it);
+
+/**
+ * This function will move the iterator backward.
+ *
+ * @param it The iterator.
+ */
+void ds_btree_iterator_prev(ds_btree_iterator* it);
+
+/**
+ * This function can be used to check if the iterator is valid.
+ *
+ * @param it The iterator.
+ *
+ * @return it returns 1 if the iterator is valid, 0 otherwise.
+ */
+int ds_btree_iterator_is_valid(ds_btree_iterator* it);
+
+/**
+ * This function will get the element pointed by the iterator as const void*.
+ *
+ * @param it The iterator.
+ *
+ * @return The pointer to the element pointed by the iterator.
+ */
+const void* ds_btree_iterator_get(ds_btree_iterator* it);
+
+/**
+ * This function will get the typed pointer to the element pointed by the iterator.
+ *
+ * @param TYPE The type we want as output.
+ * @param IT The iterator.
+ *
+ * @return The pointer to the element stored into the tree casted to the given type.
+ */
+#define ds_btree_iterator_get_ptr(TYPE, IT) ((TYPE*)ds_btree_iterator_get(IT))
+
+/**
+ * This function will get the value of the element pointed by the iterator.
+ *
+ * @param TYPE The type we want as output.
+ * @param IT The iterator.
+ *
+ * @return The value to the element stored into the tree casted to the given type.
+ */
+#define ds_btree_iterator_get_value(TYPE, IT) (*(TYPE*)ds_btree_iterator_get(IT))
+
+/**
+ * This function will create an instance of ds_btree. The number of elements per node is chosen
+ * according to the element size, so that the elements of a node fill a few cache lines.
+ *
+ * @param cmp_func This is the pointer to a function that will be used to compare two elements.
+ * @param size It is the size of the element that the tree is supposed to store.
+ *
+ * @return It returns the pointer to a new instance of ds_btree.
+ */
+ds_btree* create_ds_btree(ds_cmp cmp_func, const size_t size);
+
+/**
+ * This function will release the memory allocated to the B+tree.
+ *
+ * @param bt The B+tree.
+ */
+void delete_ds_btree(ds_btree* bt);
+
+/**
+ * This function will return the comparison function used by the B+tree.
+ *
+ * @param bt The B+tree.
+ *
+ * @return The comparison function.
+ */
+ds_cmp ds_btree_cmp(ds_btree* bt);
+
+/**
+ * This function will return the number of elements stored in the B+tree.
+ *
+ * @param bt The B+tree.
+ *
+ * @return The number of elements stored in the B+tree.
+ */
+size_t ds_btree_size(const ds_btree* bt);
+
+/**
+ * This function will insert an element into the B+tree.
+ *
+ * @param bt The B+tree.
+ * @param element The element.
+ *
+ * @return The result of the operation. The function will return ELEMENT_ALREADY_EXISTS if attempts to insert a duplicate.
+ */
+ds_result ds_btree_insert(ds_btree* bt, const void* element);
+
+/**
+ * This function will remove an element from the B+tree if exists.
+ *
+ * @param bt The B+tree.
+ * @param element The element.
+ *
+ * @return The result of the operation.
+ */
+ds_result ds_btree_remove(ds_btree* bt, const void* element);
+
+/**
+ * This function will look for an element into the B+tree.
+ *
+ * @param bt The B+tree.
+ * @param element The element.
+ *
+ * @return It returns 1 if the element exists, 0 otherwise.
+ */
+int ds_btree_search(ds_btree* bt, const void* element);
+
+/**
+ * This function will look for an element into the B+tree, if exists it will
+ * return a pointer to the element, NULL otherwise.
+ *
+ * @param bt The B+tree.
+ * @param element The element we are looking for.
+ *
+ * @return It returns a pointer to the element into the B+tree if such element exists, NULL otherwise.
+ */
+const void* ds_btree_get(ds_btree* bt, const void* element);
+
+/**
+ * This function will return the maximum value into the B+tree.
+ *
+ * @param bt The B+tree.
+ *
+ * @return The maximum value stored in the B+tree, NULL if it is empty.
+ */
+const void* ds_btree_max(ds_btree* bt);
+
+/**
+ * This function will return the minimum value into the B+tree.
+ *
+ * @param bt The B+tree.
+ *
+ * @return The minimum value stored in the B+tree, NULL if it is empty.
+ */
+const void* ds_btree_min(ds_btree* bt);
+
+/**
+ * This function will return an iterator to the first (smallest) element of the B+tree.
+ *
+ * @param bt The B+tree.
+ *
+ * @return The iterator to the smallest element of the B+tree.
+ */
+ds_btree_iterator ds_btree_first(ds_btree* bt);
+
+/**
+ * This function will return an iterator to the last (biggest) element of the B+tree.
+ *
+ * @param bt The B+tree.
+ *
+ * @return The iterator to the biggest element of the B+tree.
+ */
+ds_btree_iterator ds_btree_last(ds_btree* bt);
+
+/**
+ * This function will return an iterator to the first element that is not smaller than the given one.
+ *
+ * @param bt The B+tree.
+ * @param element The element to compare with.
+ *
+ * @return The iterator to the first element e such that e >= element. The iterator is not valid if such element does not exist.
+ */
+ds_btree_iterator ds_btree_lower_bound(ds_btree* bt, const void* element);
+
+/**
+ * This function will return an iterator to the first element that is bigger than the given one.
+ *
+ * @param bt The B+tree.
+ * @param element The element to compare with.
+ *
+ * @return The iterator to the first element e such that e > element. The iterator is not valid if such element does not exist.
+ */
+ds_btree_iterator ds_btree_upper_bound(ds_btree* bt, const void* element);
+
+/**
+ * This function will return an iterator to the biggest element that is not bigger than the given one.
+ *
+ * @param bt The B+tree.
+ * @param element The element to compare with.
+ *
+ * @return The iterator to the last element e such that e <= element. The iterator is not valid if such element does not exist.
+ */
+ds_btree_iterator ds_btree_floor(ds_btree* bt, const void* element);
+
+/**
+ * This function will return an iterator to the smallest element that is not smaller than the given one.
+ * It is the same as ds_btree_lower_bound.
+ *
+ * @param bt The B+tree.
+ * @param element The element to compare with.
+ *
+ * @return The iterator to the first element e such that e >= element. The iterator is not valid if such element does not exist.
+ */
+ds_btree_iterator ds_btree_ceiling(ds_btree* bt, const void* element);
+
+/**
+ * This function will visit, in order, the elements that fall within the range [lo, hi).
+ * It takes O(log n + k) where k is the number of visited elements.
+ *
+ * @param bt The B+tree.
+ * @param lo The lower bound of the range (included).
+ * @param hi The upper bound of the range (excluded).
+ * @param visit_func The function that will be used to visit the elements. See ds_btree_visit.
+ * @param other_args It is the second argument to pass visit_func.
+ */
+void ds_btree_range_visit(ds_btree* bt, const void* lo, const void* hi, void (*visit_func)(const void*, void*), void* other_args);
+
+/**
+ * This function will visit all the elements of the B+tree, walking the linked leaves. The type is accepted
+ * for compatibility with ds_bst_visit: elements are stored only in the leaves, which are all at the same depth,
+ * so every visiting strategy meets them in ascending order.
+ *
+ * @param bt The B+tree.
+ * @param visit_func The function that will be used to visit the elements. It is a function like func(const void*, void*) where the first argument is the pointer to the element, and the second is an optional argument that may be used with this function to pass data.
+ * @param other_args It is the second argument to pass visit_func.
+ * @param type The type of the tree visit.
+ */
+void ds_btree_visit(ds_btree* bt, void (*visit_func)(const void*, void*), void* other_args, ds_visit_type type);
+
+/**
+ * This function will visit the elements of the B+tree like ds_btree_visit, but the visit ends as soon as
+ * visit_func returns a value different from 0.
+ *
+ * @param bt The B+tree.
+ * @param visit_func The function that will be used to visit the elements. It returns 0 to go on with the visit, any other value to stop it.
+ * @param other_args It is the second argument to pass visit_func.
+ * @param type The type of the tree visit.
+ *
+ * @return It returns 1 if the visit has been stopped by visit_func, 0 otherwise.
+ */
+int ds_btree_visit_until(ds_btree* bt, int (*visit_func)(const void*, void*), void* other_args, ds_visit_type type);
+
+#endif
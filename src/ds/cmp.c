@@ -0,0 +1,57 @@
+/*
+ * @file cmp.c
+ * @author Valerio Bellizia
+ */
+
+#include "cmp.h"
+
+#include <stdint.h>
+#include <string.h>
+
+// elements are read with memcpy, the store of a container does not guarantee any alignment
+#define CMP_VALUES(TYPE, E1, E2) \
+	TYPE v1; \
+	TYPE v2; \
+	memcpy(&v1, E1, sizeof(TYPE)); \
+	memcpy(&v2, E2, sizeof(TYPE)); \
+	return (v1 > v2) - (v1 < v2);
+
+int ds_cmp_int32(const void* e1, const void* e2) {
+	CMP_VALUES(int32_t, e1, e2)
+}
+
+int ds_cmp_int64(const void* e1, const void* e2) {
+	CMP_VALUES(int64_t, e1, e2)
+}
+
+int ds_cmp_uint64(const void* e1, const void* e2) {
+	CMP_VALUES(uint64_t, e1, e2)
+}
+
+int ds_cmp_double(const void* e1, const void* e2) {
+	CMP_VALUES(double, e1, e2)
+}
+
+int ds_cmp_cstr(const void* e1, const void* e2) {
+	const char* s1;
+	const char* s2;
+	memcpy(&s1, e1, sizeof(const char*));
+	memcpy(&s2, e2, sizeof(const char*));
+
+	return strcmp(s1, s2);
+}
+
+ds_cmp_kind ds_cmp_kind_of(ds_cmp cmp_func, const size_t element_size) {
+	if (cmp_func == ds_cmp_int32 && element_size >= sizeof(int32_t))
+		return DS_CMP_INT32;
+	if (cmp_func == ds_cmp_int64 && element_size >= sizeof(int64_t))
+		return DS_CMP_INT64;
+	if (cmp_func == ds_cmp_uint64 && element_size >= sizeof(uint64_t))
+		return DS_CMP_UINT64;
+	if (cmp_func == ds_cmp_double && element_size >= sizeof(double))
+		return DS_CMP_DOUBLE;
+	if (cmp_func == ds_cmp_cstr && element_size >= sizeof(const char*))
+		return DS_CMP_CSTR;
+
+	return DS_CMP_CUSTOM;
+}
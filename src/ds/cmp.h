@@ -0,0 +1,92 @@
+/**
+ * @file cmp.h
+ * @author Valerio Bellizia
+ *
+ * This file contains the comparison functions provided by the library. Any ds_cmp can be
+ * given to a container, but the containers recognise these ones when they are created:
+ * searches then use loops where the comparison is inlined, instead of calling the
+ * comparison function for every element.
+ */
+
+#ifndef cmp_h
+#define cmp_h
+
+#include "defs.h"
+
+#include <stddef.h>
+
+/**
+ * This enumeration tells which of the library comparison functions is used by a container.
+ */
+typedef enum ds_cmp_kind {
+	DS_CMP_CUSTOM,
+	DS_CMP_INT32,
+	DS_CMP_INT64,
+	DS_CMP_UINT64,
+	DS_CMP_DOUBLE,
+	DS_CMP_CSTR
+} ds_cmp_kind;
+
+/**
+ * This function compares two int32_t.
+ *
+ * @param e1 The pointer to the first element.
+ * @param e2 The pointer to the second element.
+ *
+ * @return It returns a negative value if e1 < e2, 0 if they are equal, a positive value otherwise.
+ */
+int ds_cmp_int32(const void* e1, const void* e2);
+
+/**
+ * This function compares two int64_t.
+ *
+ * @param e1 The pointer to the first element.
+ * @param e2 The pointer to the second element.
+ *
+ * @return It returns a negative value if e1 < e2, 0 if they are equal, a positive value otherwise.
+ */
+int ds_cmp_int64(const void* e1, const void* e2);
+
+/**
+ * This function compares two uint64_t.
+ *
+ * @param e1 The pointer to the first element.
+ * @param e2 The pointer to the second element.
+ *
+ * @return It returns a negative value if e1 < e2, 0 if they are equal, a positive value otherwise.
+ */
+int ds_cmp_uint64(const void* e1, const void* e2);
+
+/**
+ * This function compares two double. NaN is neither less nor greater than any value.
+ *
+ * @param e1 The pointer to the first element.
+ * @param e2 The pointer to the second element.
+ *
+ * @return It returns a negative value if e1 < e2, 0 if they are equal, a positive value otherwise.
+ */
+int ds_cmp_double(const void* e1, const void* e2);
+
+/**
+ * This function compares two C strings with strcmp. The elements are char* pointers,
+ * so the arguments are pointers to char*.
+ *
+ * @param e1 The pointer to the first element.
+ * @param e2 The pointer to the second element.
+ *
+ * @return It returns a negative value if e1 < e2, 0 if they are equal, a positive value otherwise.
+ */
+int ds_cmp_cstr(const void* e1, const void* e2);
+
+/**
+ * This function tells if the given function is one of the library comparison functions.
+ * Containers call it when they are created.
+ *
+ * @param cmp_func The comparison function.
+ * @param element_size The size of the elements the function will compare.
+ *
+ * @return It returns the kind of the function, DS_CMP_CUSTOM if it is not a library function or if the elements are too small for it.
+ */
+ds_cmp_kind ds_cmp_kind_of(ds_cmp cmp_func, const size_t element_size);
+
+#endif
@@ -0,0 +1,349 @@
+/*
+ * @file concurrent_treemap.c
+ * @author Valerio Bellizia
+ */
+
+#include "concurrent_treemap.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+// shards are kept on separate cache lines, so that taking the lock of a shard does not slow down the others
+#define CACHE_LINE 64
+#define SHARD_SIZE (((sizeof(struct shard) + CACHE_LINE - 1) / CACHE_LINE) * CACHE_LINE)
+#define SHARD(MAP, I) ((struct shard*)((MAP)->shards + (I) * SHARD_SIZE))
+
+// struct definitions
+
+struct shard {
+	pthread_rwlock_t lock;
+	ds_treemap* map;
+};
+
+/*
+ * When bounds is NULL keys are assigned to shards by hash, otherwise bounds holds the
+ * shards - 1 keys splitting the key space, laid out one after the other.
+ */
+struct ds_concurrent_treemap {
+	char* shards;
+	size_t count;
+
+	ds_cmp key_cmp;
+	size_t key_len;
+	size_t value_len;
+	char* bounds;
+};
+
+/*
+ * The iterator holds a cursor for every shard. With range partitioning shards are visited one
+ * after the other, otherwise the shards that still have elements are kept in a min-heap ordered
+ * by the key of their cursor, and the iterator points to the cursor on top of the heap.
+ */
+struct ds_concurrent_treemap_iterator {
+	ds_concurrent_treemap* map;
+	size_t heap_size;
+	size_t* heap;
+	ds_treemap_iterator cursors[];
+};
+
+// helpers
+
+// FNV-1a, the final mixing spreads the low bits as the shard is taken by modulo
+static size_t hash_key(const void* k, size_t len) {
+	const unsigned char* bytes = (const unsigned char*) k;
+	uint64_t h = 14695981039346656037ULL;
+	for (size_t i = 0; i < len; ++i) {
+		h ^= bytes[i];
+		h *= 1099511628211ULL;
+	}
+	h ^= h >> 32;
+
+	return (size_t) h;
+}
+
+// it returns the number of bounds less than or equal to k
+static size_t range_of(ds_concurrent_treemap* map, const void* k) {
+	size_t lo = 0;
+	size_t hi = map->count - 1;
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		if (map->key_cmp(map->bounds + mid * map->key_len, k) <= 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+static struct shard* shard_of(ds_concurrent_treemap* map, const void* k) {
+	size_t i = (map->bounds != NULL) ? range_of(map, k) : hash_key(k, map->key_len) % map->count;
+	return SHARD(map, i);
+}
+
+static ds_concurrent_treemap* create_map(ds_cmp key_cmp, size_t key_len, size_t value_len, size_t shards) {
+	ds_concurrent_treemap* map = (ds_concurrent_treemap*) malloc(sizeof(ds_concurrent_treemap));
+	if (map == NULL)
+		return NULL;
+
+	map->shards = (char*) aligned_alloc(CACHE_LINE, shards * SHARD_SIZE);
+	if (map->shards == NULL) {
+		free(map);
+		return NULL;
+	}
+
+	map->count = 0;
+	map->key_cmp = key_cmp;
+	map->key_len = key_len;
+	map->value_len = value_len;
+	map->bounds = NULL;
+
+	for (; map->count < shards; map->count++) {
+		struct shard* s = SHARD(map, map->count);
+		s->map = create_ds_treemap(key_cmp, key_len, value_len);
+		if (s->map == NULL || pthread_rwlock_init(&s->lock, NULL) != 0) {
+			delete_ds_treemap(s->map);
+			delete_ds_concurrent_treemap(map);
+			return NULL;
+		}
+	}
+
+	return map;
+}
+
+static int cursor_less(ds_concurrent_treemap_iterator* it, size_t a, size_t b) {
+	const ds_treemap_entry* ea = ds_treemap_iterator_get(&it->cursors[a]);
+	const ds_treemap_entry* eb = ds_treemap_iterator_get(&it->cursors[b]);
+	return it->map->key_cmp(ea->key, eb->key) < 0;
+}
+
+static void sift_down(ds_concurrent_treemap_iterator* it, size_t i) {
+	for (;;) {
+		size_t smallest = i;
+		size_t l = 2 * i + 1;
+		size_t r = l + 1;
+		if (l < it->heap_size && cursor_less(it, it->heap[l], it->heap[smallest]))
+			smallest = l;
+		if (r < it->heap_size && cursor_less(it, it->heap[r], it->heap[smallest]))
+			smallest = r;
+		if (smallest == i)
+			return;
+
+		size_t aux = it->heap[i];
+		it->heap[i] = it->heap[smallest];
+		it->heap[smallest] = aux;
+		i = smallest;
+	}
+}
+
+// with range partitioning the top of the heap is the shard being visited, the next non-empty one replaces it
+static void skip_empty_ranges(ds_concurrent_treemap_iterator* it) {
+	while (it->heap_size > 0 && !ds_treemap_iterator_is_valid(&it->cursors[it->heap[0]])) {
+		if (it->heap[0] + 1 < it->map->count)
+			it->heap[0]++;
+		else
+			it->heap_size = 0;
+	}
+}
+
+// Interface functions
+
+ds_concurrent_treemap* create_ds_concurrent_treemap(ds_cmp key_cmp, size_t key_len, size_t value_len, size_t shards) {
+	if (shards == 0)
+		return NULL;
+
+	return create_map(key_cmp, key_len, value_len, shards);
+}
+
+ds_concurrent_treemap* create_ds_concurrent_treemap_ranged(ds_cmp key_cmp, size_t key_len, size_t value_len, const void* bounds, size_t n) {
+	const char* b = (const char*) bounds;
+	for (size_t i = 1; i < n; ++i) {
+		if (key_cmp(b + (i - 1) * key_len, b + i * key_len) >= 0)
+			return NULL;
+	}
+
+	char* copy = (char*) malloc(n > 0 ? n * key_len : 1);
+	if (copy == NULL)
+		return NULL;
+	if (n > 0)
+		memcpy(copy, bounds, n * key_len);
+
+	ds_concurrent_treemap* map = create_map(key_cmp, key_len, value_len, n + 1);
+	if (map == NULL) {
+		free(copy);
+		return NULL;
+	}
+	map->bounds = copy;
+
+	return map;
+}
+
+void delete_ds_concurrent_treemap(ds_concurrent_treemap* map) {
+	if (map == NULL)
+		return;
+
+	for (size_t i = 0; i < map->count; ++i) {
+		struct shard* s = SHARD(map, i);
+		pthread_rwlock_destroy(&s->lock);
+		delete_ds_treemap(s->map);
+	}
+
+	free(map->bounds);
+	free(map->shards);
+	free(map);
+}
+
+size_t ds_concurrent_treemap_shards(ds_concurrent_treemap* map) {
+	return map->count;
+}
+
+ds_result ds_concurrent_treemap_insert(ds_concurrent_treemap* map, const void* k, const void* v) {
+	if (map == NULL || k == NULL || v == NULL)
+		return GENERIC_ERROR;
+
+	struct shard* s = shard_of(map, k);
+	pthread_rwlock_wrlock(&s->lock);
+	ds_result res = ds_treemap_insert(s->map, k, v);
+	pthread_rwlock_unlock(&s->lock);
+
+	return res;
+}
+
+ds_result ds_concurrent_treemap_put(ds_concurrent_treemap* map, const void* k, const void* v) {
+	if (map == NULL || k == NULL || v == NULL)
+		return GENERIC_ERROR;
+
+	struct shard* s = shard_of(map, k);
+	pthread_rwlock_wrlock(&s->lock);
+	ds_result res = ds_treemap_put(s->map, k, v);
+	pthread_rwlock_unlock(&s->lock);
+
+	return res;
+}
+
+ds_result ds_concurrent_treemap_compute(ds_concurrent_treemap* map, const void* k, void (*compute_func)(const void*, void*, int, void*), void* other_args) {
+	if (map == NULL || k == NULL || compute_func == NULL)
+		return GENERIC_ERROR;
+
+	struct shard* s = shard_of(map, k);
+	pthread_rwlock_wrlock(&s->lock);
+	ds_result res = ds_treemap_compute(s->map, k, compute_func, other_args);
+	pthread_rwlock_unlock(&s->lock);
+
+	return res;
+}
+
+int ds_concurrent_treemap_get(ds_concurrent_treemap* map, const void* k, void* v) {
+	if (map == NULL || k == NULL)
+		return 0;
+
+	struct shard* s = shard_of(map, k);
+	pthread_rwlock_rdlock(&s->lock);
+	const ds_treemap_entry* entry = ds_treemap_get(s->map, (void*) k);
+	if (entry != NULL && v != NULL)
+		memcpy(v, entry->value, map->value_len);
+	pthread_rwlock_unlock(&s->lock);
+
+	return entry != NULL;
+}
+
+int ds_concurrent_treemap_search(ds_concurrent_treemap* map, const void* k) {
+	return ds_concurrent_treemap_get(map, k, NULL);
+}
+
+ds_result ds_concurrent_treemap_remove(ds_concurrent_treemap* map, const void* k) {
+	if (map == NULL || k == NULL)
+		return GENERIC_ERROR;
+
+	struct shard* s = shard_of(map, k);
+	pthread_rwlock_wrlock(&s->lock);
+	ds_result res = ds_treemap_remove(s->map, (void*) k);
+	pthread_rwlock_unlock(&s->lock);
+
+	return res;
+}
+
+size_t ds_concurrent_treemap_size(ds_concurrent_treemap* map) {
+	size_t size = 0;
+	for (size_t i = 0; i < map->count; ++i) {
+		struct shard* s = SHARD(map, i);
+		pthread_rwlock_rdlock(&s->lock);
+		size += ds_treemap_size(s->map);
+		pthread_rwlock_unlock(&s->lock);
+	}
+
+	return size;
+}
+
+ds_concurrent_treemap_iterator* ds_concurrent_treemap_first(ds_concurrent_treemap* map) {
+	ds_concurrent_treemap_iterator* it = (ds_concurrent_treemap_iterator*) malloc(sizeof(ds_concurrent_treemap_iterator) + map->count * sizeof(ds_treemap_iterator));
+	if (it == NULL)
+		return NULL;
+
+	it->heap = (size_t*) malloc(map->count * sizeof(size_t));
+	if (it->heap == NULL) {
+		free(it);
+		return NULL;
+	}
+	it->map = map;
+	it->heap_size = 0;
+
+	// shards are always locked in the same order, writers take a single lock so they cannot deadlock with iterators
+	for (size_t i = 0; i < map->count; ++i) {
+		struct shard* s = SHARD(map, i);
+		pthread_rwlock_rdlock(&s->lock);
+		it->cursors[i] = ds_treemap_first(s->map);
+	}
+
+	if (map->bounds != NULL) {
+		it->heap[0] = 0;
+		it->heap_size = 1;
+		skip_empty_ranges(it);
+		return it;
+	}
+
+	for (size_t i = 0; i < map->count; ++i) {
+		if (ds_treemap_iterator_is_valid(&it->cursors[i]))
+			it->heap[it->heap_size++] = i;
+	}
+	for (size_t i = it->heap_size / 2; i > 0; --i)
+		sift_down(it, i - 1);
+
+	return it;
+}
+
+void delete_ds_concurrent_treemap_iterator(ds_concurrent_treemap_iterator* it) {
+	if (it == NULL)
+		return;
+
+	for (size_t i = 0; i < it->map->count; ++i)
+		pthread_rwlock_unlock(&SHARD(it->map, i)->lock);
+
+	free(it->heap);
+	free(it);
+}
+
+int ds_concurrent_treemap_iterator_is_valid(ds_concurrent_treemap_iterator* it) {
+	return it->heap_size > 0;
+}
+
+void ds_concurrent_treemap_iterator_next(ds_concurrent_treemap_iterator* it) {
+	ds_treemap_iterator* cursor = &it->cursors[it->heap[0]];
+	ds_treemap_iterator_next(cursor);
+
+	if (it->map->bounds != NULL) {
+		skip_empty_ranges(it);
+		return;
+	}
+
+	// an exhausted shard leaves the heap, otherwise its cursor may not be the smallest anymore
+	if (!ds_treemap_iterator_is_valid(cursor))
+		it->heap[0] = it->heap[--it->heap_size];
+	sift_down(it, 0);
+}
+
+const ds_treemap_entry* ds_concurrent_treemap_iterator_get(ds_concurrent_treemap_iterator* it) {
+	return ds_treemap_iterator_get(&it->cursors[it->heap[0]]);
+}
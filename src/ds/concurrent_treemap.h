@@ -0,0 +1,196 @@
+/**
+ * @file concurrent_treemap.h
+ * @author Valerio Bellizia
+ *
+ * This file contains the interface to be used with ds_concurrent_treemap. It implements
+ * a thread-safe treemap made of many ds_treemap shards, each one protected by its own
+ * reader-writer lock, so that threads working on different shards never wait for each other.
+ * Keys are assigned to shards by hashing their bytes or by splitting the key space in ranges.
+ *
+ * Keys and values are copied into the map, values are copied out of it as well: no pointer to
+ * the memory of the map is returned outside of an iterator.
+ */
+
+#ifndef concurrent_treemap_h
+#define concurrent_treemap_h
+
+#include "result.h"
+#include "defs.h"
+#include "treemap.h"
+
+#include <stddef.h>
+
+/**
+ * This is an opaque structure that represents a concurrent treemap.
+ */
+typedef struct ds_concurrent_treemap ds_concurrent_treemap;
+
+/**
+ * This is an opaque structure that represents an iterator visiting all the shards of a concurrent treemap in key order.
+ */
+typedef struct ds_concurrent_treemap_iterator ds_concurrent_treemap_iterator;
+
+/**
+ * This function will create a concurrent treemap whose keys are assigned to shards by hashing their bytes.
+ * Keys that are equal according to key_cmp must have the same bytes (as it happens for integers).
+ *
+ * @param key_cmp This is the key comparison function.
+ * @param key_len This is the length of the key type.
+ * @param value_len This is the length of the value type.
+ * @param shards This is the number of shards, it should be a few times the number of threads writing the map.
+ *
+ * @return It returns the pointer to a new instance of ds_concurrent_treemap, NULL if shards is 0 or if the memory cannot be allocated.
+ */
+ds_concurrent_treemap* create_ds_concurrent_treemap(ds_cmp key_cmp, size_t key_len, size_t value_len, size_t shards);
+
+/**
+ * This function will create a concurrent treemap whose keys are assigned to shards by range: the n bounds split
+ * the key space in n + 1 shards, and a key belongs to the shard of the greatest bound that is less than or equal
+ * to it (the first shard holds the keys less than the first bound).
+ *
+ * @param key_cmp This is the key comparison function.
+ * @param key_len This is the length of the key type.
+ * @param value_len This is the length of the value type.
+ * @param bounds This is an array of n keys, sorted according to key_cmp. The keys are copied.
+ * @param n This is the number of bounds.
+ *
+ * @return It returns the pointer to a new instance of ds_concurrent_treemap, NULL if the bounds are not sorted or if the memory cannot be allocated.
+ */
+ds_concurrent_treemap* create_ds_concurrent_treemap_ranged(ds_cmp key_cmp, size_t key_len, size_t value_len, const void* bounds, size_t n);
+
+/**
+ * This function will release the memory of the map. No other thread should be using it.
+ *
+ * @param map The concurrent treemap.
+ */
+void delete_ds_concurrent_treemap(ds_concurrent_treemap* map);
+
+/**
+ * This function will return the number of shards of the map.
+ *
+ * @param map The concurrent treemap.
+ *
+ * @return The number of shards.
+ */
+size_t ds_concurrent_treemap_shards(ds_concurrent_treemap* map);
+
+/**
+ * This function will insert a <key, value> pair in the map.
+ *
+ * @param map The concurrent treemap.
+ * @param k The key.
+ * @param v The value.
+ *
+ * @return It returns SUCCESS if the element is inserted properly. It returns ELEMENT_ALREADY_EXISTS when adding an element whose key already exists.
+ */
+ds_result ds_concurrent_treemap_insert(ds_concurrent_treemap* map, const void* k, const void* v);
+
+/**
+ * This function will insert a <key, value> pair in the map, replacing the value if the key already exists.
+ *
+ * @param map The concurrent treemap.
+ * @param k The key.
+ * @param v The value.
+ *
+ * @return It returns SUCCESS if the value is stored, GENERIC_ERROR otherwise.
+ */
+ds_result ds_concurrent_treemap_put(ds_concurrent_treemap* map, const void* k, const void* v);
+
+/**
+ * This function will call compute_func on the value associated to a key while holding the lock of its shard,
+ * so that the value can be updated atomically. If the key does not exist, it is inserted with a zero-filled value.
+ * compute_func must not use the map.
+ *
+ * @param map The concurrent treemap.
+ * @param k The key.
+ * @param compute_func The function that updates the value. It is a function like func(const void* key, void* value, int existed, void* other_args).
+ * @param other_args It is the last argument to pass compute_func.
+ *
+ * @return It returns SUCCESS if compute_func has been called, GENERIC_ERROR otherwise.
+ */
+ds_result ds_concurrent_treemap_compute(ds_concurrent_treemap* map, const void* k, void (*compute_func)(const void*, void*, int, void*), void* other_args);
+
+/**
+ * This function will copy the value associated to a key.
+ *
+ * @param map The concurrent treemap.
+ * @param k The key.
+ * @param v The memory where the value is copied, it can be NULL to only check if the key exists.
+ *
+ * @return It returns 1 if the key is found, 0 otherwise.
+ */
+int ds_concurrent_treemap_get(ds_concurrent_treemap* map, const void* k, void* v);
+
+/**
+ * This function will look for a key.
+ *
+ * @param map The concurrent treemap.
+ * @param k The key.
+ *
+ * @return It returns 1 if the key is found, 0 otherwise.
+ */
+int ds_concurrent_treemap_search(ds_concurrent_treemap* map, const void* k);
+
+/**
+ * This function will remove the element whose key is provided as argument.
+ *
+ * @param map The concurrent treemap.
+ * @param k The key.
+ *
+ * @return It returns SUCCESS if the element is removed (or does not exist).
+ */
+ds_result ds_concurrent_treemap_remove(ds_concurrent_treemap* map, const void* k);
+
+/**
+ * This function will return the number of elements stored in the map. Shards are counted one at a time,
+ * so the result may not match any state of the map while other threads are changing it.
+ *
+ * @param map The concurrent treemap.
+ *
+ * @return The number of elements.
+ */
+size_t ds_concurrent_treemap_size(ds_concurrent_treemap* map);
+
+/**
+ * This function will return an iterator to the first element of the map. The iterator holds the read lock
+ * of every shard until it is deleted: writers wait for it, and the thread owning it must not change the map.
+ *
+ * @param map The concurrent treemap.
+ *
+ * @return It returns the iterator, NULL if the memory cannot be allocated.
+ */
+ds_concurrent_treemap_iterator* ds_concurrent_treemap_first(ds_concurrent_treemap* map);
+
+/**
+ * This function will release the locks held by the iterator and its memory.
+ *
+ * @param it The iterator.
+ */
+void delete_ds_concurrent_treemap_iterator(ds_concurrent_treemap_iterator* it);
+
+/**
+ * This function can be used to check if the iterator is valid.
+ *
+ * @param it The iterator.
+ *
+ * @return it returns 1 if the iterator is valid, 0 otherwise.
+ */
+int ds_concurrent_treemap_iterator_is_valid(ds_concurrent_treemap_iterator* it);
+
+/**
+ * This function will move the iterator to the next key, whatever shard it belongs to.
+ *
+ * @param it The iterator.
+ */
+void ds_concurrent_treemap_iterator_next(ds_concurrent_treemap_iterator* it);
+
+/**
+ * This function will get the entry pointed by the iterator, it is valid until the iterator is deleted.
+ *
+ * @param it The iterator.
+ *
+ * @return The pointer to the entry pointed by the iterator.
+ */
+const ds_treemap_entry* ds_concurrent_treemap_iterator_get(ds_concurrent_treemap_iterator* it);
+
+#endif
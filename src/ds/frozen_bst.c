@@ -0,0 +1,206 @@
+/*
+ * @file frozen_bst.c
+ * @author Valerio Bellizia
+ */
+
+#include "frozen_bst.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// the search prefetches the elements this many levels below the current one (16 descendants)
+#define PREFETCH_LEVELS 4
+
+#if defined(__GNUC__) || defined(__clang__)
+#define PREFETCH(ADDR) __builtin_prefetch(ADDR)
+#else
+#define PREFETCH(ADDR) ((void)(ADDR))
+#endif
+
+#define ELEMENT(T, I) ((T)->data + (I) * (T)->element_size)
+
+// struct definitions
+
+/*
+ * data holds n + 1 elements, the slot 0 is not used so that the children of i are 2i and 2i + 1.
+ */
+struct ds_frozen_bst {
+	char* data;
+	ds_cmp cmp;
+	size_t elements;
+	size_t element_size;
+};
+
+// helpers
+
+static size_t trailing_ones(size_t i) {
+#if defined(__GNUC__) || defined(__clang__)
+	return (size_t) __builtin_ctzll(~(unsigned long long) i);
+#else
+	size_t count = 0;
+	while (i & 1) {
+		i >>= 1;
+		count++;
+	}
+	return count;
+#endif
+}
+
+// it fills the subtree rooted at i with the elements of the iterator in order
+static void fill(ds_frozen_bst* t, size_t i, ds_bst_iterator* it) {
+	if (i > t->elements)
+		return;
+
+	fill(t, 2 * i, it);
+	memcpy(ELEMENT(t, i), ds_bst_iterator_get(it), t->element_size);
+	ds_bst_iterator_next(it);
+	fill(t, 2 * i + 1, it);
+}
+
+/*
+ * It returns the index of the first element not less than the given one, 0 if there is none.
+ * The walk goes always down to a leaf: the comparison picks the child without a branch, and
+ * the index of a node records the path from the root in its bits (1 means right). The answer
+ * is the last node where the walk went left, so the trailing right turns are dropped at the end.
+ */
+static size_t lower_bound_index(const ds_frozen_bst* t, const void* element) {
+	size_t i = 1;
+	while (i <= t->elements) {
+		size_t ahead = i << PREFETCH_LEVELS;
+		if (ahead <= t->elements)
+			PREFETCH(ELEMENT(t, ahead));
+		i = 2 * i + (t->cmp(ELEMENT(t, i), element) < 0);
+	}
+
+	return i >> (trailing_ones(i) + 1);
+}
+
+static size_t leftmost(const ds_frozen_bst* t, size_t i) {
+	while (2 * i <= t->elements)
+		i = 2 * i;
+	return i;
+}
+
+static size_t rightmost(const ds_frozen_bst* t, size_t i) {
+	while (2 * i + 1 <= t->elements)
+		i = 2 * i + 1;
+	return i;
+}
+
+// Interface functions
+
+void ds_frozen_bst_iterator_next(ds_frozen_bst_iterator* it) {
+	size_t i = it->index;
+	if (2 * i + 1 <= it->tree->elements) {
+		it->index = leftmost(it->tree, 2 * i + 1);
+		return;
+	}
+
+	// going up until we come from a left child, the root has no parent (index 0)
+	while (i & 1)
+		i >>= 1;
+	it->index = i >> 1;
+}
+
+void ds_frozen_bst_iterator_prev(ds_frozen_bst_iterator* it) {
+	size_t i = it->index;
+	if (2 * i <= it->tree->elements) {
+		it->index = rightmost(it->tree, 2 * i);
+		return;
+	}
+
+	// going up until we come from a right child
+	while (i > 1 && !(i & 1))
+		i >>= 1;
+	it->index = i >> 1;
+}
+
+int ds_frozen_bst_iterator_is_valid(ds_frozen_bst_iterator* it) {
+	return it->index != 0;
+}
+
+const void* ds_frozen_bst_iterator_get(ds_frozen_bst_iterator* it) {
+	return ELEMENT(it->tree, it->index);
+}
+
+ds_frozen_bst* ds_bst_freeze(ds_bst* bt) {
+	if (bt == NULL)
+		return NULL;
+
+	ds_frozen_bst* t = (ds_frozen_bst*) malloc(sizeof(ds_frozen_bst));
+	if (t == NULL)
+		return NULL;
+
+	t->cmp = ds_bst_cmp(bt);
+	t->elements = ds_bst_size(bt);
+	t->element_size = ds_bst_element_size(bt);
+	t->data = (char*) malloc((t->elements + 1) * t->element_size);
+	if (t->data == NULL) {
+		free(t);
+		return NULL;
+	}
+
+	ds_bst_iterator it = ds_bst_first(bt);
+	fill(t, 1, &it);
+
+	return t;
+}
+
+void delete_ds_frozen_bst(ds_frozen_bst* t) {
+	if (t == NULL)
+		return;
+
+	free(t->data);
+	free(t);
+}
+
+size_t ds_frozen_bst_size(const ds_frozen_bst* t) {
+	return t->elements;
+}
+
+int ds_frozen_bst_search(const ds_frozen_bst* t, const void* element) {
+	return ds_frozen_bst_get(t, element) != NULL;
+}
+
+const void* ds_frozen_bst_get(const ds_frozen_bst* t, const void* element) {
+	if (t == NULL || element == NULL)
+		return NULL;
+
+	size_t i = lower_bound_index(t, element);
+	if (i == 0 || t->cmp(ELEMENT(t, i), element) != 0)
+		return NULL;
+
+	return ELEMENT(t, i);
+}
+
+ds_frozen_bst_iterator ds_frozen_bst_lower_bound(const ds_frozen_bst* t, const void* element) {
+	ds_frozen_bst_iterator it;
+	it.tree = t;
+	it.index = lower_bound_index(t, element);
+
+	return it;
+}
+
+ds_frozen_bst_iterator ds_frozen_bst_first(const ds_frozen_bst* t) {
+	ds_frozen_bst_iterator it;
+	it.tree = t;
+	it.index = (t->elements > 0) ? leftmost(t, 1) : 0;
+
+	return it;
+}
+
+ds_frozen_bst_iterator ds_frozen_bst_last(const ds_frozen_bst* t) {
+	ds_frozen_bst_iterator it;
+	it.tree = t;
+	it.index = (t->elements > 0) ? rightmost(t, 1) : 0;
+
+	return it;
+}
+
+void ds_frozen_bst_visit(const ds_frozen_bst* t, void (*visit_func)(const void*, void*), void* other_args) {
+	if (t == NULL)
+		return;
+
+	for (ds_frozen_bst_iterator it = ds_frozen_bst_first(t); ds_frozen_bst_iterator_is_valid(&it); ds_frozen_bst_iterator_next(&it))
+		visit_func(ds_frozen_bst_iterator_get(&it), other_args);
+}
@@ -0,0 +1,173 @@
+/**
+ * @file frozen_bst.h
+ * @author Valerio Bellizia
+ *
+ * This file contains the interface to be used with ds_frozen_bst. It is an immutable
+ * search structure built from a ds_bst: the elements are packed into a single array
+ * following the Eytzinger (BFS) layout, so the root is at index 1 and the children of
+ * the element at index i are at 2i and 2i+1. Searches walk the array without branching
+ * on the comparison result and prefetch the elements a few levels below, so the cache
+ * misses of consecutive levels overlap instead of being paid one at a time.
+ * It is meant for trees that are built once and then queried many times.
+ */
+
+#ifndef frozen_bst_h
+#define frozen_bst_h
+
+#include "result.h"
+#include "defs.h"
+#include "bst.h"
+
+#include <stddef.h>
+
+/**
+ * This is an opaque structure that represents a frozen binary search tree.
+ */
+typedef struct ds_frozen_bst ds_frozen_bst;
+
+/**
+ * This is a structure that represents an iterator for a frozen binary search tree.
+ * Elements are visited in order. The iterator is valid when index is not 0.
+ */
+typedef struct ds_frozen_bst_iterator {
+	const ds_frozen_bst* tree;
+	size_t index;
+} ds_frozen_bst_iterator;
+
+/**
+ * This function will move the iterator forward.
+ *
+ * @param it The iterator.
+ */
+void ds_frozen_bst_iterator_next(ds_frozen_bst_iterator* it);
+
+/**
+ * This function will move the iterator backward.
+ *
+ * @param it The iterator.
+ */
+void ds_frozen_bst_iterator_prev(ds_frozen_bst_iterator* it);
+
+/**
+ * This function can be used to check if the iterator is valid.
+ *
+ * @param it The iterator.
+ *
+ * @return it returns 1 if the iterator is valid, 0 otherwise.
+ */
+int ds_frozen_bst_iterator_is_valid(ds_frozen_bst_iterator* it);
+
+/**
+ * This function will get the element pointed by the iterator as const void*.
+ *
+ * @param it The iterator.
+ *
+ * @return The pointer to the element pointed by the iterator.
+ */
+const void* ds_frozen_bst_iterator_get(ds_frozen_bst_iterator* it);
+
+/**
+ * This function will get the typed pointer to the element pointed by the iterator.
+ *
+ * @param TYPE The type we want as output.
+ * @param IT The iterator.
+ *
+ * @return The pointer to the element stored into the tree casted to the given type.
+ */
+#define ds_frozen_bst_iterator_get_ptr(TYPE, IT) ((TYPE*)ds_frozen_bst_iterator_get(IT))
+
+/**
+ * This function will get the value of the element pointed by the iterator.
+ *
+ * @param TYPE The type we want as output.
+ * @param IT The iterator.
+ *
+ * @return The value to the element stored into the tree casted to the given type.
+ */
+#define ds_frozen_bst_iterator_get_value(TYPE, IT) (*(TYPE*)ds_frozen_bst_iterator_get(IT))
+
+/**
+ * This function will build a frozen copy of the tree in O(n). The tree is not changed
+ * and the frozen copy does not depend on it.
+ *
+ * @param bt The binary search tree.
+ *
+ * @return It returns the pointer to a new instance of ds_frozen_bst, NULL if the memory cannot be allocated.
+ */
+ds_frozen_bst* ds_bst_freeze(ds_bst* bt);
+
+/**
+ * This function will release the memory used by the frozen tree.
+ *
+ * @param t The frozen binary search tree.
+ */
+void delete_ds_frozen_bst(ds_frozen_bst* t);
+
+/**
+ * This function will return the number of elements stored in the frozen tree.
+ *
+ * @param t The frozen binary search tree.
+ *
+ * @return The number of elements stored in the tree.
+ */
+size_t ds_frozen_bst_size(const ds_frozen_bst* t);
+
+/**
+ * This function will look for an element into the frozen tree.
+ *
+ * @param t The frozen binary search tree.
+ * @param element The element.
+ *
+ * @return It returns 1 if the element exists, 0 otherwise.
+ */
+int ds_frozen_bst_search(const ds_frozen_bst* t, const void* element);
+
+/**
+ * This function will look for an element into the frozen tree, if exists it will
+ * return a pointer to the element, NULL otherwise.
+ *
+ * @param t The frozen binary search tree.
+ * @param element The element we are looking for.
+ *
+ * @return It returns a pointer to the element into the tree if such element exists, NULL otherwise.
+ */
+const void* ds_frozen_bst_get(const ds_frozen_bst* t, const void* element);
+
+/**
+ * This function will return an iterator to the first element that is not less than the given one.
+ *
+ * @param t The frozen binary search tree.
+ * @param element The element.
+ *
+ * @return The iterator to the first element not less than element, it is not valid if such element does not exist.
+ */
+ds_frozen_bst_iterator ds_frozen_bst_lower_bound(const ds_frozen_bst* t, const void* element);
+
+/**
+ * This function will return an iterator to the first (smallest) element of the frozen tree.
+ *
+ * @param t The frozen binary search tree.
+ *
+ * @return The iterator to the smallest element of the tree.
+ */
+ds_frozen_bst_iterator ds_frozen_bst_first(const ds_frozen_bst* t);
+
+/**
+ * This function will return an iterator to the last (biggest) element of the frozen tree.
+ *
+ * @param t The frozen binary search tree.
+ *
+ * @return The iterator to the biggest element of the tree.
+ */
+ds_frozen_bst_iterator ds_frozen_bst_last(const ds_frozen_bst* t);
+
+/**
+ * This function will visit all the elements of the frozen tree in order.
+ *
+ * @param t The frozen binary search tree.
+ * @param visit_func The function that will be used to visit the elements. It is a function like func(const void*, void*) where the first argument is the pointer to the element, and the second is an optional argument that may be used with this function to pass data.
+ * @param other_args It is the second argument to pass visit_func.
+ */
+void ds_frozen_bst_visit(const ds_frozen_bst* t, void (*visit_func)(const void*, void*), void* other_args);
+
+#endif
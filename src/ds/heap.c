@@ -4,78 +4,326 @@
  */
 
 #include "heap.h"
-#include "vect.h"
 
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
-#include <math.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define HEAP_HAS_SSE2
+#endif
+
+#define INITIAL_CAPACITY 16
+#define CACHE_LINE 64
+
+#define ELEMENT_AT(H, INDEX) ((H)->elements + (INDEX) * (H)->element_size)
+
+// it terminates the list of free slots
+#define NO_SLOT ((size_t) -1)
+
+// a handle is made of the slot of its entry in the low bits and the generation of the slot in the high bits
+#define SLOT_BITS 32
+#define SLOT_MASK ((((ds_heap_handle) 1) << SLOT_BITS) - 1)
 
 // struct definitions
+
+/*
+ * Priorities and elements are kept in two parallel arrays: sifting only reads priorities, so
+ * they are packed together, and an element is copied once, when its final place is known.
+ * Priorities are stored as keys, the smallest key is the top of the heap whatever its type: a
+ * max-heap stores ~priority, which reverses the order without overflowing. Comparisons then
+ * do not depend on the type, and the compiler turns the choice of a child into a cmov.
+ *
+ * The children of index i are the arity entries from arity * i + 1. The keys are shifted
+ * within their block of memory so that, with a power of two arity up to 16, every group of
+ * children is aligned to its own size: picking the best child then reads a single cache line.
+ *
+ * Once a handle is asked for, every entry gets a slot: handles maps an index to the slot of its
+ * entry, positions maps a slot back to the index. Slots of removed entries are chained in a free
+ * list through positions, so there are never more slots than entries the heap has room for.
+ * Until then these arrays are NULL, and moves do not pay for keeping them up to date. The
+ * generation of a slot is bumped whenever its entry leaves the heap, so the handles given out
+ * for the old entry do not match the new entry that reuses the slot.
+ */
 struct ds_heap {
-	ds_vect* v;
+	int* keys;
+	char* keys_block;
+	char* elements;
+	size_t* handles;
+	size_t* positions;
+	uint32_t* generations;
+	size_t free_slots;
+	size_t next_slot;
+	size_t size;
+	size_t capacity;
 	size_t element_size;
+	size_t arity;
 	ds_heap_type type;
-	size_t(*left_is_up)(ds_vect* h, int left, int right);
+
+	// an element is kept here while its entry is moved to a new place
+	char* scratch;
 };
 
 // helper functions
-static int entry_cmp(const void* el1, const void* el2) {
-	// it does not matter...
-	return 0;
+
+static size_t parent_index(const ds_heap* h, size_t index) {
+	return (index - 1) / h->arity;
+}
+
+static size_t first_child_index(const ds_heap* h, size_t index) {
+	return (index * h->arity) + 1;
 }
 
-static int left_child_index(int index) {
-	return (index * 2) + 1;
+// it turns a priority into a key and back
+static int order_key(const ds_heap* h, int priority) {
+	return (h->type == MIN_HEAP) ? priority : ~priority;
 }
 
-static int right_child_index(int index) {
-	return (index * 2) + 2;
+static void move_handle(ds_heap* h, size_t to, size_t from) {
+	h->handles[to] = h->handles[from];
+	h->positions[h->handles[to]] = to;
 }
 
-static int parent_index(int index) {
-	if (index == 0) {
-		// the root has no parent
-		return -1;
+static void move_entry(ds_heap* h, size_t to, size_t from) {
+	h->keys[to] = h->keys[from];
+	memcpy(ELEMENT_AT(h, to), ELEMENT_AT(h, from), h->element_size);
+	if (h->handles != NULL)
+		move_handle(h, to, from);
+}
+
+static void place_entry(ds_heap* h, size_t index, int key, const void* element, size_t slot) {
+	h->keys[index] = key;
+	memcpy(ELEMENT_AT(h, index), element, h->element_size);
+	if (h->handles != NULL) {
+		h->handles[index] = slot;
+		h->positions[slot] = index;
 	}
+}
 
-	return floor(((double)index - 1) / 2);
+static void free_handles(ds_heap* h) {
+	free(h->handles);
+	free(h->positions);
+	free(h->generations);
+	h->handles = NULL;
+	h->positions = NULL;
+	h->generations = NULL;
 }
 
-static size_t min_heap_cmp(ds_vect* h, int left, int right) {
-	ds_vect_iterator left_it = ds_vect_at(h, left);
-	ds_vect_iterator right_it = ds_vect_at(h, right);
+// the entries already in the heap get the slots from 0 on
+static ds_result track_handles(ds_heap* h) {
+	h->handles = (size_t*) malloc((h->capacity + 1) * sizeof(size_t));
+	h->positions = (size_t*) malloc((h->capacity + 1) * sizeof(size_t));
+	h->generations = (uint32_t*) calloc(h->capacity + 1, sizeof(uint32_t));
+	if (h->handles == NULL || h->positions == NULL || h->generations == NULL) {
+		free_handles(h);
+		return GENERIC_ERROR;
+	}
 
-	ds_heap_entry* left_element = ds_vect_iterator_get_ptr(ds_heap_entry, &left_it);
-	ds_heap_entry* right_element = ds_vect_iterator_get_ptr(ds_heap_entry, &right_it);
+	for (size_t i = 0; i < h->size; ++i) {
+		h->handles[i] = i;
+		h->positions[i] = i;
+	}
+	h->next_slot = h->size;
+	h->free_slots = NO_SLOT;
 
-	return left_element->priority < right_element->priority;
+	return SUCCESS;
 }
 
-static size_t max_heap_cmp(ds_vect* h, int left, int right) {
-	ds_vect_iterator left_it = ds_vect_at(h, left);
-	ds_vect_iterator right_it = ds_vect_at(h, right);
+static size_t acquire_slot(ds_heap* h) {
+	if (h->handles == NULL)
+		return NO_SLOT;
+
+	if (h->free_slots == NO_SLOT)
+		return h->next_slot++;
 
-	ds_heap_entry* left_element = ds_vect_iterator_get_ptr(ds_heap_entry, &left_it);
-	ds_heap_entry* right_element = ds_vect_iterator_get_ptr(ds_heap_entry, &right_it);
+	size_t slot = h->free_slots;
+	h->free_slots = h->positions[slot];
+	return slot;
+}
+
+static void release_slot(ds_heap* h, size_t slot) {
+	h->generations[slot]++;
+	h->positions[slot] = h->free_slots;
+	h->free_slots = slot;
+}
 
-	return left_element->priority > right_element->priority;
+static ds_heap_handle make_handle(const ds_heap* h, size_t slot) {
+	return ((ds_heap_handle) h->generations[slot] << SLOT_BITS) | (ds_heap_handle) slot;
 }
 
-static void heapify(size_t (*left_is_up)(ds_vect*, int, int), ds_vect* h, int i) {
-	int left_index = left_child_index(i);
-	int right_index = right_child_index(i);
+// a free slot has already moved to the next generation, so only the handle of the entry holding the slot matches
+static int is_live(const ds_heap* h, ds_heap_handle handle) {
+	size_t slot = (size_t) (handle & SLOT_MASK);
+	return h->handles != NULL && slot < h->next_slot && h->generations[slot] == (uint32_t) (handle >> SLOT_BITS);
+}
 
-	size_t array_size = ds_vect_length(h);
+static ds_result expand(ds_heap* h) {
+	if (h->size < h->capacity)
+		return SUCCESS;
 
-	int upmost_index = i;
-	if (left_index < array_size && left_is_up(h, left_index, upmost_index))
-		upmost_index = left_index;
-	if (right_index < array_size && left_is_up(h, right_index, upmost_index))
-		upmost_index = right_index;
-	if (upmost_index != i) {
-		ds_vect_swap(h, i, upmost_index);
-		heapify(left_is_up, h, upmost_index);
+	size_t capacity = (h->capacity > 0) ? h->capacity * 2 : INITIAL_CAPACITY;
+
+	// realloc does not keep the alignment, so the block is moved by hand
+	size_t shift = h->arity - 1;
+	char* block = (char*) malloc(CACHE_LINE + (shift + capacity) * sizeof(int));
+	if (block == NULL)
+		return GENERIC_ERROR;
+
+	uintptr_t aligned = ((uintptr_t) block + CACHE_LINE - 1) & ~(uintptr_t) (CACHE_LINE - 1);
+	int* keys = (int*) aligned + shift;
+	if (h->size > 0)
+		memcpy(keys, h->keys, h->size * sizeof(int));
+	free(h->keys_block);
+	h->keys_block = block;
+	h->keys = keys;
+
+	// a zero element size is fine, but realloc is not asked for 0 bytes
+	char* elements = (char*) realloc(h->elements, capacity * h->element_size + 1);
+	if (elements == NULL)
+		return GENERIC_ERROR;
+	h->elements = elements;
+
+	if (h->handles != NULL) {
+		size_t* handles = (size_t*) realloc(h->handles, capacity * sizeof(size_t));
+		if (handles == NULL)
+			return GENERIC_ERROR;
+		h->handles = handles;
+
+		size_t* positions = (size_t*) realloc(h->positions, capacity * sizeof(size_t));
+		if (positions == NULL)
+			return GENERIC_ERROR;
+		h->positions = positions;
+
+		// slots never outnumber the entries the heap has room for, the new ones start from generation 0
+		uint32_t* generations = (uint32_t*) realloc(h->generations, capacity * sizeof(uint32_t));
+		if (generations == NULL)
+			return GENERIC_ERROR;
+		memset(generations + h->capacity, 0, (capacity - h->capacity) * sizeof(uint32_t));
+		h->generations = generations;
 	}
+
+	h->capacity = capacity;
+	return SUCCESS;
+}
+
+/*
+ * Parents are moved down into the hole left at index, until the place of the key is found.
+ * It returns the place, the caller fills it.
+ */
+static size_t sift_up(ds_heap* h, size_t index, int key) {
+	while (index > 0) {
+		size_t parent = parent_index(h, index);
+		if (key >= h->keys[parent])
+			break;
+
+		move_entry(h, index, parent);
+		index = parent;
+	}
+
+	return index;
+}
+
+#ifdef HEAP_HAS_SSE2
+static unsigned trailing_zeros(unsigned mask) {
+#if defined(__GNUC__) || defined(__clang__)
+	return (unsigned) __builtin_ctz(mask);
+#else
+	unsigned count = 0;
+	while (!(mask & 1)) {
+		mask >>= 1;
+		count++;
+	}
+	return count;
+#endif
+}
+
+// SSE2 has no 32 bit min, it is made of a comparison and a blend
+static __m128i min_of(__m128i a, __m128i b) {
+	__m128i a_greater = _mm_cmpgt_epi32(a, b);
+	return _mm_or_si128(_mm_and_si128(a_greater, b), _mm_andnot_si128(a_greater, a));
+}
+
+// every lane is set to the minimum of the four lanes
+static __m128i spread_min(__m128i v) {
+	v = min_of(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+	return min_of(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+}
+
+static unsigned lanes_equal(__m128i v, __m128i min) {
+	return (unsigned) _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(v, min)));
+}
+
+// it returns the position of the smallest key of a full group of 4 or 8 children, the first one on ties
+static size_t best_child_simd(const ds_heap* h, const int* children) {
+	__m128i low = _mm_loadu_si128((const __m128i*) children);
+	if (h->arity == 4)
+		return trailing_zeros(lanes_equal(low, spread_min(low)));
+
+	__m128i high = _mm_loadu_si128((const __m128i*) (children + 4));
+	__m128i min = spread_min(min_of(low, high));
+	return trailing_zeros(lanes_equal(low, min) | (lanes_equal(high, min) << 4));
+}
+#endif
+
+static size_t best_child(const ds_heap* h, size_t child) {
+	size_t last = child + h->arity;
+	if (last > h->size)
+		last = h->size;
+
+#ifdef HEAP_HAS_SSE2
+	if (last - child == h->arity && (h->arity == 4 || h->arity == 8))
+		return child + best_child_simd(h, h->keys + child);
+#endif
+
+	// the comparisons are random, so they are turned into additions and selects rather than branches
+	if (h->arity == 2)
+		return (last - child == 2) ? child + (h->keys[child + 1] < h->keys[child]) : child;
+
+	size_t best = child;
+	int best_key = h->keys[child];
+	for (size_t c = child + 1; c < last; ++c) {
+		int better = h->keys[c] < best_key;
+		best = better ? c : best;
+		best_key = better ? h->keys[c] : best_key;
+	}
+
+	return best;
+}
+
+// the best child is moved up into the hole left at index, until the place of the key is found
+static size_t sift_down(ds_heap* h, size_t index, int key) {
+	size_t child;
+	while ((child = first_child_index(h, index)) < h->size) {
+		child = best_child(h, child);
+		if (h->keys[child] >= key)
+			break;
+
+		move_entry(h, index, child);
+		index = child;
+	}
+
+	return index;
+}
+
+// the hole left at index moves towards the top or the bottom, until the place of the key is found
+static size_t reposition(ds_heap* h, size_t index, int key) {
+	if (index > 0 && key < h->keys[parent_index(h, index)])
+		return sift_up(h, index, key);
+
+	return sift_down(h, index, key);
+}
+
+// the last entry fills the hole left at index, it stays past the end until its place is found
+static void remove_at(ds_heap* h, size_t index) {
+	if (h->handles != NULL)
+		release_slot(h, h->handles[index]);
+	h->size--;
+	if (index == h->size)
+		return;
+
+	index = reposition(h, index, h->keys[h->size]);
+	move_entry(h, index, h->size);
 }
 
 // Interface functions
@@ -86,14 +334,36 @@ void delete_ds_heap_entry(ds_heap_entry* entry) {
 }
 
 ds_heap* create_ds_heap(ds_heap_type type, const size_t element_size) {
+	return create_ds_dary_heap(type, element_size, 2);
+}
+
+ds_heap* create_ds_dary_heap(ds_heap_type type, const size_t element_size, const size_t arity) {
+	if (arity < 2)
+		return NULL;
+
 	ds_heap* heap = (ds_heap*)malloc(sizeof(ds_heap));
 	if (heap == NULL)
 		return NULL;
 
-	heap->v = create_ds_vect(entry_cmp, sizeof(ds_heap_entry));
+	heap->scratch = (char*) malloc(element_size + 1);
+	if (heap->scratch == NULL) {
+		free(heap);
+		return NULL;
+	}
+
+	heap->keys = NULL;
+	heap->keys_block = NULL;
+	heap->elements = NULL;
+	heap->handles = NULL;
+	heap->positions = NULL;
+	heap->generations = NULL;
+	heap->free_slots = NO_SLOT;
+	heap->next_slot = 0;
+	heap->size = 0;
+	heap->capacity = 0;
 	heap->element_size = element_size;
+	heap->arity = arity;
 	heap->type = type;
-	heap->left_is_up = (heap->type == MAX_HEAP) ? max_heap_cmp : min_heap_cmp;
 
 	return heap;
 }
@@ -102,69 +372,125 @@ void delete_ds_heap(ds_heap* h) {
 	if (h == NULL)
 		return;
 
-	if (h->v != NULL) {
-		delete_ds_vect(h->v);
-	}
-
+	free(h->keys_block);
+	free(h->elements);
+	free_handles(h);
+	free(h->scratch);
 	free(h);
 }
 
 size_t ds_heap_size(ds_heap* h) {
-	return ds_vect_length(h->v);
+	return h->size;
 }
 
 ds_heap_type ds_heap_get_type(ds_heap* h) {
 	return h->type;
 }
 
-ds_result ds_heap_push(ds_heap* h, const void* element, const int priority) {
-	int current = ds_vect_length(h->v);
+size_t ds_heap_arity(ds_heap* h) {
+	return h->arity;
+}
 
-	ds_heap_entry entry;
-	entry.priority = priority;
+ds_result ds_heap_push(ds_heap* h, const void* element, const int priority) {
+	return ds_heap_push_handle(h, element, priority, NULL);
+}
 
-	// We are copying the pointer here... the deep copy will be done when it will be added to te vector
-	entry.info = (void*) element;
+ds_result ds_heap_push_handle(ds_heap* h, const void* element, const int priority, ds_heap_handle* handle) {
+	if (handle != NULL && h->handles == NULL && track_handles(h) != SUCCESS)
+		return GENERIC_ERROR;
 
-	ds_vect_push_back(h->v, &entry);
+	// slots have to fit in the low bits of a handle
+	if (h->handles != NULL && h->size >= SLOT_MASK)
+		return GENERIC_ERROR;
 
-	int parent = parent_index(current);
-	if (parent == -1) {
-		return SUCCESS;
-	}
+	ds_result res = expand(h);
+	if (res != SUCCESS)
+		return res;
 
-	while (h->left_is_up(h->v, current, parent)) {
-		ds_vect_swap(h->v, current, parent);
+	int key = order_key(h, priority);
+	size_t slot = acquire_slot(h);
+	size_t index = sift_up(h, h->size, key);
+	place_entry(h, index, key, element, slot);
+	h->size++;
 
-		current = parent;
-		parent = parent_index(current);
-		if (parent == -1)
-			break;
-	}
+	if (handle != NULL)
+		*handle = make_handle(h, slot);
 
 	return SUCCESS;
 }
 
 ds_heap_entry ds_heap_pop(ds_heap* h) {
-	ds_vect_iterator top_it = ds_vect_at(h->v, 0);
-	ds_heap_entry* el_to_pop = ds_vect_iterator_get_ptr(ds_heap_entry, &top_it);
-
-	// We need to copy, otherwise ds_vect_remove will eventually release the memory
 	ds_heap_entry entry;
-	entry.priority = el_to_pop->priority;
+	entry.priority = order_key(h, h->keys[0]);
 	entry.info = malloc(h->element_size);
-	memcpy(entry.info, el_to_pop->info, h->element_size);
+	if (entry.info != NULL)
+		memcpy(entry.info, ELEMENT_AT(h, 0), h->element_size);
 
-	int array_size = ds_vect_length(h->v);
-
-	if (array_size == 1) {
-		ds_vect_remove(h->v, 0);
-	}
-	else {
-		ds_vect_swap(h->v, 0, array_size-1);
-		ds_vect_remove(h->v, array_size - 1);
-		heapify(h->left_is_up, h->v, 0);
-	}
+	remove_at(h, 0);
 
 	return entry;
 }
+
+ds_result ds_heap_pop_into(ds_heap* h, void* element, int* priority) {
+	if (h == NULL || h->size == 0)
+		return GENERIC_ERROR;
+
+	if (element != NULL)
+		memcpy(element, ELEMENT_AT(h, 0), h->element_size);
+	if (priority != NULL)
+		*priority = order_key(h, h->keys[0]);
+
+	remove_at(h, 0);
+
+	return SUCCESS;
+}
+
+const void* ds_heap_peek(ds_heap* h, int* priority) {
+	if (h == NULL || h->size == 0)
+		return NULL;
+
+	if (priority != NULL)
+		*priority = order_key(h, h->keys[0]);
+
+	return ELEMENT_AT(h, 0);
+}
+
+int ds_heap_contains(ds_heap* h, ds_heap_handle handle) {
+	return is_live(h, handle);
+}
+
+void* ds_heap_get(ds_heap* h, ds_heap_handle handle, int* priority) {
+	if (h == NULL || !is_live(h, handle))
+		return NULL;
+
+	size_t index = h->positions[handle & SLOT_MASK];
+	if (priority != NULL)
+		*priority = order_key(h, h->keys[index]);
+
+	return ELEMENT_AT(h, index);
+}
+
+ds_result ds_heap_update_priority(ds_heap* h, ds_heap_handle handle, const int priority) {
+	if (h == NULL || !is_live(h, handle))
+		return GENERIC_ERROR;
+
+	// the entry leaves a hole at its index, then it moves towards the top or the bottom
+	size_t slot = (size_t) (handle & SLOT_MASK);
+	size_t index = h->positions[slot];
+	memcpy(h->scratch, ELEMENT_AT(h, index), h->element_size);
+	int key = order_key(h, priority);
+	index = reposition(h, index, key);
+	place_entry(h, index, key, h->scratch, slot);
+
+	return SUCCESS;
+}
+
+ds_result ds_heap_remove(ds_heap* h, ds_heap_handle handle) {
+	if (h == NULL)
+		return GENERIC_ERROR;
+
+	if (is_live(h, handle))
+		remove_at(h, h->positions[handle & SLOT_MASK]);
+
+	return SUCCESS;
+}
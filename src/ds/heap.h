@@ -2,7 +2,8 @@
  * @file heap.h
  * @author Valerio Bellizia
  *
- * This file contains the interface to be used with ds_heap.
+ * This file contains the interface to be used with ds_heap. Elements are copied into the heap when
+ * they are pushed, next to their priority, so they do not need to outlive the call.
  */
 
 #ifndef heap_h
@@ -12,6 +13,7 @@
 #include "defs.h"
 
 #include <stddef.h>
+#include <stdint.h>
 
 /**
  * This is an opaque struct that represents a heap
@@ -27,7 +29,15 @@ typedef enum ds_heap_type {
 } ds_heap_type;
 
 /**
- * This is an opaque struct that represents an element of an heap
+ * This is a handle to an entry of the heap. It stays valid while the entry is in the heap, whatever
+ * the moves of the entry. Once the entry is popped or removed the handle is rejected, even after its
+ * place is given to a new entry (unless the place is reused 2^32 times while the handle is kept).
+ */
+typedef uint64_t ds_heap_handle;
+
+/**
+ * This is a struct that represents an element popped from the heap with ds_heap_pop, info is a copy
+ * of the element owned by the caller.
  */
 typedef struct ds_heap_entry {
 	void* info;
@@ -51,6 +61,20 @@ void delete_ds_heap_entry(ds_heap_entry* entry);
  */
 ds_heap* create_ds_heap(ds_heap_type type, const size_t element_size);
 
+/**
+ * This function will create an instance of ds_heap where every node has arity children (a d-ary heap).
+ * A wider heap is shallower, pushes are cheaper and pops compare more children per level; the children
+ * of a node are contiguous, so with an arity of 4 or 8 they are read from a single cache line (and
+ * compared all at once when SSE2 is available). create_ds_heap creates a binary heap.
+ * 
+ * @param type the heap type determine if it will be a min-heap or a max-heap
+ * @param element_size It is the size of the element to held within the heap.
+ * @param arity The number of children of every node, it must be at least 2.
+ * 
+ * @return It returns an instance of the heap, NULL if the arity is less than 2.
+ */
+ds_heap* create_ds_dary_heap(ds_heap_type type, const size_t element_size, const size_t arity);
+
 /**
  * This function will release the memory allocated to the heap.
  * Elements stored in the heap will be 'freed'
@@ -77,17 +101,49 @@ size_t ds_heap_size(ds_heap* h);
  */
 ds_heap_type ds_heap_get_type(ds_heap* h);
 
+/**
+ * This function will return the number of children of every node of the heap.
+ * 
+ * @param h The heap.
+ * 
+ * @return It returns the arity of the heap, 2 for a binary heap.
+ */
+size_t ds_heap_arity(ds_heap* h);
+
 /**
  * This function will pop the first element of the heap. It returns and removes it.
+ * The element is copied into memory allocated for the caller: ds_heap_pop_into avoids that.
  * 
  * @param h The heap.
  * 
- * @return It returns the first element of the heap after it has been removed.
+ * @return It returns the first element of the heap after it has been removed, it must be released with delete_ds_heap_entry.
  */
 ds_heap_entry ds_heap_pop(ds_heap* h);
 
 /**
- * This function will insert an element in the heap.
+ * This function will pop the first element of the heap, copying it into a buffer of the caller.
+ * It does not allocate memory.
+ * 
+ * @param h The heap.
+ * @param element The buffer receiving the element, it must hold element_size bytes. If NULL the element is discarded.
+ * @param priority If not NULL, it is set to the priority of the element.
+ * 
+ * @return It returns SUCCESS if an element is popped, GENERIC_ERROR if the heap is empty.
+ */
+ds_result ds_heap_pop_into(ds_heap* h, void* element, int* priority);
+
+/**
+ * This function will return the first element of the heap without removing it.
+ * 
+ * @param h The heap.
+ * @param priority If not NULL, it is set to the priority of the element.
+ * 
+ * @return It returns a pointer to the element within the heap, valid until the heap is changed, NULL if the heap is empty.
+ */
+const void* ds_heap_peek(ds_heap* h, int* priority);
+
+/**
+ * This function will insert an element in the heap. The element is copied.
  * 
  * @param h The heap.
  * @param element The element to push into the heap.
@@ -97,4 +153,63 @@ ds_heap_entry ds_heap_pop(ds_heap* h);
  */
 ds_result ds_heap_push(ds_heap* h, const void* element, const int priority);
 
+/**
+ * This function will insert an element in the heap and return a handle to it, so that its priority
+ * can be changed, or it can be removed, later on. The element is copied.
+ * Handles are kept up to date only after the first one is asked for, so heaps that never use them
+ * do not pay for it.
+ * 
+ * @param h The heap.
+ * @param element The element to push into the heap.
+ * @param priority The priority.
+ * @param handle If not NULL, it is set to the handle of the new entry.
+ * 
+ * @return it returns SUCCESS if the element is succesfully inserted, GENERIC_ERROR if the memory cannot be allocated
+ * or if a heap tracking handles already holds 2^32 - 1 entries.
+ */
+ds_result ds_heap_push_handle(ds_heap* h, const void* element, const int priority, ds_heap_handle* handle);
+
+/**
+ * This function can be used to check if a handle refers to an entry of the heap.
+ * 
+ * @param h The heap.
+ * @param handle The handle.
+ * 
+ * @return It returns 1 if the entry the handle was given for is in the heap, 0 if it has been popped or removed.
+ */
+int ds_heap_contains(ds_heap* h, ds_heap_handle handle);
+
+/**
+ * This function will return the element of an entry.
+ * 
+ * @param h The heap.
+ * @param handle The handle of the entry.
+ * @param priority If not NULL, it is set to the priority of the entry.
+ * 
+ * @return It returns a pointer to the element within the heap, valid until the heap is changed, NULL if the entry is not in the heap.
+ */
+void* ds_heap_get(ds_heap* h, ds_heap_handle handle, int* priority);
+
+/**
+ * This function will change the priority of an entry in O(log n), the entry moves up or down
+ * as needed (a decrease-key in a min-heap, an increase-key in a max-heap, or the other way around).
+ * 
+ * @param h The heap.
+ * @param handle The handle of the entry.
+ * @param priority The new priority.
+ * 
+ * @return It returns SUCCESS if the priority is changed, GENERIC_ERROR if the entry is not in the heap.
+ */
+ds_result ds_heap_update_priority(ds_heap* h, ds_heap_handle handle, const int priority);
+
+/**
+ * This function will remove an entry in O(log n), wherever it is in the heap.
+ * 
+ * @param h The heap.
+ * @param handle The handle of the entry.
+ * 
+ * @return It returns SUCCESS if the entry is removed (or is not in the heap).
+ */
+ds_result ds_heap_remove(ds_heap* h, ds_heap_handle handle);
+
 #endif
@@ -0,0 +1,198 @@
+/*
+ * @file interval_tree.c
+ * @author Valerio Bellizia
+ */
+
+#include "interval_tree.h"
+#include "bst.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// the value follows the element header
+#define VALUE_OFFSET (((sizeof(struct interval_element) + sizeof(void*) - 1) / sizeof(void*)) * sizeof(void*))
+#define ELEMENT_VALUE(ELEMENT) ((char*)(ELEMENT) + VALUE_OFFSET)
+
+// struct definitions
+
+// max_hi is the augmented field: the greatest upper endpoint within the subtree of the node
+struct interval_element {
+	ds_interval interval;
+	int64_t max_hi;
+};
+
+struct ds_interval_tree {
+	ds_bst* bst;
+	size_t value_len;
+
+	// elements are built here before being inserted, it is also used as a probe
+	struct interval_element* scratch;
+};
+
+// helpers
+
+// intervals are sorted by lower endpoint, then by upper endpoint, equal intervals are kept in insertion order
+static int interval_cmp(const void* e1, const void* e2) {
+	const ds_interval* i1 = (const ds_interval*) e1;
+	const ds_interval* i2 = (const ds_interval*) e2;
+
+	if (i1->lo != i2->lo)
+		return (i1->lo < i2->lo) ? -1 : 1;
+	if (i1->hi != i2->hi)
+		return (i1->hi < i2->hi) ? -1 : 1;
+
+	return 0;
+}
+
+static void update_max_hi(void* element, const void* left, const void* right) {
+	struct interval_element* e = (struct interval_element*) element;
+	e->max_hi = e->interval.hi;
+
+	if (left != NULL && ((const struct interval_element*) left)->max_hi > e->max_hi)
+		e->max_hi = ((const struct interval_element*) left)->max_hi;
+	if (right != NULL && ((const struct interval_element*) right)->max_hi > e->max_hi)
+		e->max_hi = ((const struct interval_element*) right)->max_hi;
+}
+
+static struct interval_element* node_element(ds_bst_node* node) {
+	return (struct interval_element*) ds_bst_node_get(node);
+}
+
+static const void* probe(ds_interval_tree* tree, int64_t lo, int64_t hi) {
+	tree->scratch->interval.lo = lo;
+	tree->scratch->interval.hi = hi;
+	return tree->scratch;
+}
+
+struct overlap_query {
+	int64_t lo;
+	int64_t hi;
+	void (*visit_func)(const ds_interval*, void*, void*);
+	void* other_args;
+	size_t found;
+};
+
+/*
+ * A subtree is skipped when its greatest upper endpoint is before the query, and the right subtree
+ * of a node is skipped when the node starts after the query (so does every interval on its right).
+ */
+static void visit_overlaps(ds_bst_node* node, struct overlap_query* q) {
+	while (node != NULL) {
+		struct interval_element* e = node_element(node);
+		if (e->max_hi < q->lo)
+			return;
+
+		visit_overlaps(ds_bst_node_left(node), q);
+		if (e->interval.lo > q->hi)
+			return;
+
+		if (e->interval.hi >= q->lo) {
+			if (q->visit_func != NULL)
+				q->visit_func(&e->interval, ELEMENT_VALUE(e), q->other_args);
+			q->found++;
+		}
+
+		node = ds_bst_node_right(node);
+	}
+}
+
+// Interface functions
+
+ds_interval_tree* create_ds_interval_tree(size_t value_len) {
+	ds_interval_tree* tree = (ds_interval_tree*) malloc(sizeof(ds_interval_tree));
+	if (tree == NULL)
+		return NULL;
+
+	tree->value_len = value_len;
+	tree->bst = create_ds_bst_multi_augmented(interval_cmp, VALUE_OFFSET + value_len, update_max_hi);
+	tree->scratch = (struct interval_element*) calloc(1, VALUE_OFFSET + value_len);
+	if (tree->bst == NULL || tree->scratch == NULL) {
+		delete_ds_bst(tree->bst);
+		free(tree->scratch);
+		free(tree);
+		return NULL;
+	}
+
+	return tree;
+}
+
+void delete_ds_interval_tree(ds_interval_tree* tree) {
+	if (tree == NULL)
+		return;
+
+	delete_ds_bst(tree->bst);
+	free(tree->scratch);
+	free(tree);
+}
+
+size_t ds_interval_tree_size(ds_interval_tree* tree) {
+	return ds_bst_size(tree->bst);
+}
+
+ds_result ds_interval_tree_insert(ds_interval_tree* tree, int64_t lo, int64_t hi, const void* v) {
+	if (tree == NULL || lo > hi)
+		return GENERIC_ERROR;
+
+	probe(tree, lo, hi);
+	if (v != NULL)
+		memcpy(ELEMENT_VALUE(tree->scratch), v, tree->value_len);
+	else
+		memset(ELEMENT_VALUE(tree->scratch), 0, tree->value_len);
+
+	return ds_bst_insert(tree->bst, tree->scratch);
+}
+
+ds_result ds_interval_tree_remove(ds_interval_tree* tree, int64_t lo, int64_t hi) {
+	if (tree == NULL)
+		return GENERIC_ERROR;
+
+	return ds_bst_remove(tree->bst, probe(tree, lo, hi));
+}
+
+void* ds_interval_tree_get(ds_interval_tree* tree, int64_t lo, int64_t hi) {
+	if (tree == NULL)
+		return NULL;
+
+	const void* element = ds_bst_get(tree->bst, probe(tree, lo, hi));
+	return (element != NULL) ? ELEMENT_VALUE(element) : NULL;
+}
+
+const ds_interval* ds_interval_tree_find_overlap(ds_interval_tree* tree, int64_t lo, int64_t hi, void** value) {
+	if (tree == NULL)
+		return NULL;
+
+	// if the left subtree reaches lo and holds no overlapping interval, neither does the right one
+	ds_bst_node* node = ds_bst_root(tree->bst);
+	while (node != NULL) {
+		struct interval_element* e = node_element(node);
+		if (e->interval.lo <= hi && e->interval.hi >= lo) {
+			if (value != NULL)
+				*value = ELEMENT_VALUE(e);
+			return &e->interval;
+		}
+
+		ds_bst_node* left = ds_bst_node_left(node);
+		node = (left != NULL && node_element(left)->max_hi >= lo) ? left : ds_bst_node_right(node);
+	}
+
+	return NULL;
+}
+
+size_t ds_interval_tree_overlaps(ds_interval_tree* tree, int64_t lo, int64_t hi, void (*visit_func)(const ds_interval*, void*, void*), void* other_args) {
+	if (tree == NULL || lo > hi)
+		return 0;
+
+	struct overlap_query q;
+	q.lo = lo;
+	q.hi = hi;
+	q.visit_func = visit_func;
+	q.other_args = other_args;
+	q.found = 0;
+	visit_overlaps(ds_bst_root(tree->bst), &q);
+
+	return q.found;
+}
+
+size_t ds_interval_tree_stab(ds_interval_tree* tree, int64_t x, void (*visit_func)(const ds_interval*, void*, void*), void* other_args) {
+	return ds_interval_tree_overlaps(tree, x, x, visit_func, other_args);
+}
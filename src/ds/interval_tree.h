@@ -0,0 +1,133 @@
+/**
+ * @file interval_tree.h
+ * @author Valerio Bellizia
+ *
+ * This file contains the interface to be used with ds_interval_tree. It implements an interval
+ * tree on top of an augmented ds_bst: intervals are sorted by their lower endpoint, and every
+ * node keeps the maximum upper endpoint of its subtree, so that subtrees that cannot hold an
+ * interval overlapping the query are skipped.
+ *
+ * Intervals are closed ([lo, hi] contains both lo and hi) and every interval holds a value of
+ * fixed length, copied into the tree. The same interval can be stored many times (e.g. two bookings of
+ * the same window), its copies are kept in insertion order.
+ */
+
+#ifndef interval_tree_h
+#define interval_tree_h
+
+#include "result.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * This is an opaque structure that represents an interval tree.
+ */
+typedef struct ds_interval_tree ds_interval_tree;
+
+/**
+ * This structure represents a closed interval.
+ */
+typedef struct ds_interval {
+	int64_t lo;
+	int64_t hi;
+} ds_interval;
+
+/**
+ * This function will create an interval tree instance.
+ *
+ * @param value_len This is the length of the value type, it can be 0.
+ *
+ * @return It returns the pointer to a new instance of ds_interval_tree.
+ */
+ds_interval_tree* create_ds_interval_tree(size_t value_len);
+
+/**
+ * This function will release the memory of the tree.
+ *
+ * @param tree The interval tree.
+ */
+void delete_ds_interval_tree(ds_interval_tree* tree);
+
+/**
+ * This function will return the number of intervals stored in the tree.
+ *
+ * @param tree The interval tree.
+ *
+ * @return The number of intervals.
+ */
+size_t ds_interval_tree_size(ds_interval_tree* tree);
+
+/**
+ * This function will insert an interval with its value.
+ *
+ * @param tree The interval tree.
+ * @param lo The lower endpoint.
+ * @param hi The upper endpoint.
+ * @param v The value, if NULL the value is zero-filled.
+ *
+ * @return It returns SUCCESS if the interval is inserted, even if it is already stored, GENERIC_ERROR if lo > hi or if the memory cannot be allocated.
+ */
+ds_result ds_interval_tree_insert(ds_interval_tree* tree, int64_t lo, int64_t hi, const void* v);
+
+/**
+ * This function will remove an interval if it exists. If the interval is stored many times, the oldest copy is removed.
+ *
+ * @param tree The interval tree.
+ * @param lo The lower endpoint.
+ * @param hi The upper endpoint.
+ *
+ * @return It returns SUCCESS if the interval is removed (or does not exist).
+ */
+ds_result ds_interval_tree_remove(ds_interval_tree* tree, int64_t lo, int64_t hi);
+
+/**
+ * This function will return the value of an interval. If the interval is stored many times, the value of the oldest copy is returned.
+ *
+ * @param tree The interval tree.
+ * @param lo The lower endpoint.
+ * @param hi The upper endpoint.
+ *
+ * @return It returns a pointer to the value, valid until the interval is removed, NULL if the interval does not exist.
+ */
+void* ds_interval_tree_get(ds_interval_tree* tree, int64_t lo, int64_t hi);
+
+/**
+ * This function will look for any interval overlapping [lo, hi] in O(log n), e.g. to check for conflicts.
+ *
+ * @param tree The interval tree.
+ * @param lo The lower endpoint of the query.
+ * @param hi The upper endpoint of the query.
+ * @param value If not NULL, it is set to the value of the interval found.
+ *
+ * @return It returns the interval found, valid until it is removed, NULL if no interval overlaps the query.
+ */
+const ds_interval* ds_interval_tree_find_overlap(ds_interval_tree* tree, int64_t lo, int64_t hi, void** value);
+
+/**
+ * This function will visit all the intervals overlapping [lo, hi], sorted by lower endpoint. Subtrees that
+ * cannot hold an overlapping interval are skipped.
+ *
+ * @param tree The interval tree.
+ * @param lo The lower endpoint of the query.
+ * @param hi The upper endpoint of the query.
+ * @param visit_func It is a function like func(const ds_interval*, void* value, void* other_args), it can be NULL to only count the intervals.
+ * @param other_args It is the last argument to pass visit_func.
+ *
+ * @return It returns the number of intervals overlapping [lo, hi].
+ */
+size_t ds_interval_tree_overlaps(ds_interval_tree* tree, int64_t lo, int64_t hi, void (*visit_func)(const ds_interval*, void*, void*), void* other_args);
+
+/**
+ * This function will visit all the intervals containing x (a stabbing query), sorted by lower endpoint.
+ *
+ * @param tree The interval tree.
+ * @param x The point.
+ * @param visit_func It is a function like func(const ds_interval*, void* value, void* other_args), it can be NULL to only count the intervals.
+ * @param other_args It is the last argument to pass visit_func.
+ *
+ * @return It returns the number of intervals containing x.
+ */
+size_t ds_interval_tree_stab(ds_interval_tree* tree, int64_t x, void (*visit_func)(const ds_interval*, void*, void*), void* other_args);
+
+#endif
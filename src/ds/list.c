@@ -4,7 +4,9 @@
  */
 
 #include "list.h"
+#include "cmp.h"
 
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -23,6 +25,7 @@ struct ds_list {
 	size_t element_size;
 
 	ds_cmp compare;
+	ds_cmp_kind compare_kind;
 };
 
 static ds_list_node* create_list_node(void* element, const size_t element_size) {
@@ -73,6 +76,7 @@ ds_list* create_ds_list(ds_cmp cmp_func, const size_t size) {
 	list->size = 0;
 	list->element_size = size;
 	list->compare = cmp_func;
+	list->compare_kind = ds_cmp_kind_of(cmp_func, size);
 
 	return list;
 }
@@ -241,10 +245,42 @@ void ds_list_do(ds_list* this,
 }
 
 
+// it walks the list comparing the values in place, it gives the same results of the library comparison functions
+#define EXISTS_VALUE(TYPE, THIS, ELEMENT) { \
+	TYPE key; \
+	memcpy(&key, ELEMENT, sizeof(TYPE)); \
+	for (ds_list_node* aux = THIS->root; aux != NULL; aux = aux->next) { \
+		TYPE value; \
+		memcpy(&value, aux->data, sizeof(TYPE)); \
+		if (!(value < key) && !(value > key)) \
+			return 1; \
+	} \
+	return 0; \
+}
+
 int ds_list_exists(const ds_list* this, const void* element) {
 	if (this->size == 0)
 		return 0;
 
+	switch (this->compare_kind) {
+	case DS_CMP_INT32:
+		EXISTS_VALUE(int32_t, this, element)
+	case DS_CMP_INT64:
+		EXISTS_VALUE(int64_t, this, element)
+	case DS_CMP_UINT64:
+		EXISTS_VALUE(uint64_t, this, element)
+	case DS_CMP_DOUBLE:
+		EXISTS_VALUE(double, this, element)
+	case DS_CMP_CSTR:
+		for (ds_list_node* aux = this->root; aux != NULL; aux = aux->next) {
+			if (strcmp(*(const char* const*) aux->data, *(const char* const*) element) == 0)
+				return 1;
+		}
+		return 0;
+	default:
+		break;
+	}
+
 	ds_list_node* aux = this->root;
 	while (aux != NULL) {
 		if (this->compare(element, aux->data) == 0)
@@ -0,0 +1,310 @@
+/*
+ * @file lru_cache.c
+ * @author Valerio Bellizia
+ */
+
+#include "lru_cache.h"
+#include "treemap.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define PROBATION 0
+#define PROTECTED 1
+
+// the value of an entry follows the node in the value slot of the treemap
+#define VALUE_OFFSET (((sizeof(struct cache_node) + sizeof(void*) - 1) / sizeof(void*)) * sizeof(void*))
+#define NODE_VALUE(NODE) ((char*)(NODE) + VALUE_OFFSET)
+
+// struct definitions
+
+/*
+ * Nodes live in the treemap next to the values, and elements of the treemap never move,
+ * so nodes can be linked together. The key is the copy owned by the treemap.
+ */
+struct cache_node {
+	struct cache_node* prev;
+	struct cache_node* next;
+	const void* key;
+	size_t weight;
+	int segment;
+};
+
+// the most recently used node is the head
+struct segment {
+	struct cache_node* head;
+	struct cache_node* tail;
+	size_t weight;
+};
+
+/*
+ * With DS_CACHE_LRU only the probation segment is used. With DS_CACHE_SLRU new entries go
+ * to probation, and they are promoted to the protected segment when they are hit; entries
+ * leaving the protected segment go back to probation, and victims come from probation first.
+ */
+struct ds_lru_cache {
+	ds_treemap* map;
+	size_t key_len;
+	size_t value_len;
+
+	ds_cache_policy policy;
+	size_t capacity;
+	size_t protected_capacity;
+	size_t weight;
+	struct segment segments[2];
+
+	ds_lru_cache_stats stats;
+	void (*evict_func)(const void*, void*, void*);
+	void* evict_args;
+
+	// a node is removed from the treemap through a copy of its key, as the key goes away with the node
+	char* scratch_key;
+};
+
+struct found_node {
+	struct cache_node* node;
+	const void* key;
+	int existed;
+};
+
+// helpers
+
+static void capture_node(const void* key, void* value, int existed, void* other_args) {
+	struct found_node* found = (struct found_node*) other_args;
+	found->node = (struct cache_node*) value;
+	found->key = key;
+	found->existed = existed;
+}
+
+static struct cache_node* find_node(ds_lru_cache* cache, const void* k) {
+	const ds_treemap_entry* entry = ds_treemap_get(cache->map, (void*) k);
+	return (entry != NULL) ? (struct cache_node*) entry->value : NULL;
+}
+
+static void unlink_node(ds_lru_cache* cache, struct cache_node* node) {
+	struct segment* s = &cache->segments[node->segment];
+	if (node->prev != NULL)
+		node->prev->next = node->next;
+	else
+		s->head = node->next;
+
+	if (node->next != NULL)
+		node->next->prev = node->prev;
+	else
+		s->tail = node->prev;
+
+	s->weight -= node->weight;
+}
+
+static void push_front(ds_lru_cache* cache, int segment, struct cache_node* node) {
+	struct segment* s = &cache->segments[segment];
+	node->segment = segment;
+	node->prev = NULL;
+	node->next = s->head;
+	if (s->head != NULL)
+		s->head->prev = node;
+	else
+		s->tail = node;
+	s->head = node;
+	s->weight += node->weight;
+}
+
+static void use_node(ds_lru_cache* cache, struct cache_node* node) {
+	unlink_node(cache, node);
+	if (cache->policy == DS_CACHE_LRU) {
+		push_front(cache, PROBATION, node);
+		return;
+	}
+
+	// a hit entry is protected, the coldest protected entries get another chance in probation
+	push_front(cache, PROTECTED, node);
+	struct segment* protected_segment = &cache->segments[PROTECTED];
+	while (protected_segment->weight > cache->protected_capacity && protected_segment->tail != node) {
+		struct cache_node* demoted = protected_segment->tail;
+		unlink_node(cache, demoted);
+		push_front(cache, PROBATION, demoted);
+	}
+}
+
+// the node that must be kept (if any) is the one being stored, it is the head of its segment
+static struct cache_node* pick_victim(ds_lru_cache* cache, struct cache_node* keep) {
+	struct cache_node* victim = cache->segments[PROBATION].tail;
+	if (victim == NULL || victim == keep)
+		victim = cache->segments[PROTECTED].tail;
+
+	return (victim != keep) ? victim : NULL;
+}
+
+static void release_node(ds_lru_cache* cache, struct cache_node* node) {
+	unlink_node(cache, node);
+	cache->weight -= node->weight;
+
+	if (cache->evict_func != NULL)
+		cache->evict_func(node->key, NODE_VALUE(node), cache->evict_args);
+
+	memcpy(cache->scratch_key, node->key, cache->key_len);
+	ds_treemap_remove(cache->map, cache->scratch_key);
+}
+
+// Interface functions
+
+ds_lru_cache* create_ds_lru_cache(ds_cmp key_cmp, size_t key_len, size_t value_len, size_t capacity, ds_cache_policy policy) {
+	if (capacity == 0)
+		return NULL;
+
+	ds_lru_cache* cache = (ds_lru_cache*) malloc(sizeof(ds_lru_cache));
+	if (cache == NULL)
+		return NULL;
+
+	cache->map = create_ds_treemap(key_cmp, key_len, VALUE_OFFSET + value_len);
+	cache->scratch_key = (char*) malloc(key_len);
+	if (cache->map == NULL || cache->scratch_key == NULL) {
+		delete_ds_treemap(cache->map);
+		free(cache->scratch_key);
+		free(cache);
+		return NULL;
+	}
+
+	cache->key_len = key_len;
+	cache->value_len = value_len;
+	cache->policy = policy;
+	cache->capacity = capacity;
+	cache->protected_capacity = capacity / 5 * 4 + (capacity % 5) * 4 / 5;
+	cache->weight = 0;
+	memset(cache->segments, 0, sizeof(cache->segments));
+	memset(&cache->stats, 0, sizeof(ds_lru_cache_stats));
+	cache->evict_func = NULL;
+	cache->evict_args = NULL;
+
+	return cache;
+}
+
+void delete_ds_lru_cache(ds_lru_cache* cache) {
+	if (cache == NULL)
+		return;
+
+	if (cache->evict_func != NULL) {
+		for (int s = PROBATION; s <= PROTECTED; ++s) {
+			for (struct cache_node* n = cache->segments[s].head; n != NULL; n = n->next)
+				cache->evict_func(n->key, NODE_VALUE(n), cache->evict_args);
+		}
+	}
+
+	delete_ds_treemap(cache->map);
+	free(cache->scratch_key);
+	free(cache);
+}
+
+void ds_lru_cache_set_evict_func(ds_lru_cache* cache, void (*evict_func)(const void*, void*, void*), void* other_args) {
+	cache->evict_func = evict_func;
+	cache->evict_args = other_args;
+}
+
+ds_result ds_lru_cache_put(ds_lru_cache* cache, const void* k, const void* v) {
+	return ds_lru_cache_put_weighted(cache, k, v, 1);
+}
+
+ds_result ds_lru_cache_put_weighted(ds_lru_cache* cache, const void* k, const void* v, size_t weight) {
+	if (cache == NULL || k == NULL || v == NULL || weight > cache->capacity)
+		return GENERIC_ERROR;
+
+	// the node is found or inserted with a single walk of the tree
+	struct found_node found;
+	if (ds_treemap_compute(cache->map, k, capture_node, &found) != SUCCESS)
+		return GENERIC_ERROR;
+
+	struct cache_node* node = found.node;
+	if (found.existed) {
+		cache->segments[node->segment].weight += weight - node->weight;
+		cache->weight += weight - node->weight;
+		node->weight = weight;
+		use_node(cache, node);
+	}
+	else {
+		node->key = found.key;
+		node->weight = weight;
+		push_front(cache, PROBATION, node);
+		cache->weight += weight;
+	}
+	memcpy(NODE_VALUE(node), v, cache->value_len);
+
+	while (cache->weight > cache->capacity) {
+		struct cache_node* victim = pick_victim(cache, node);
+		if (victim == NULL)
+			break;
+
+		release_node(cache, victim);
+		cache->stats.evictions++;
+	}
+
+	return SUCCESS;
+}
+
+void* ds_lru_cache_get(ds_lru_cache* cache, const void* k) {
+	struct cache_node* node = find_node(cache, k);
+	if (node == NULL) {
+		cache->stats.misses++;
+		return NULL;
+	}
+
+	cache->stats.hits++;
+	use_node(cache, node);
+
+	return NODE_VALUE(node);
+}
+
+const void* ds_lru_cache_peek(ds_lru_cache* cache, const void* k) {
+	struct cache_node* node = find_node(cache, k);
+	return (node != NULL) ? NODE_VALUE(node) : NULL;
+}
+
+int ds_lru_cache_touch(ds_lru_cache* cache, const void* k) {
+	struct cache_node* node = find_node(cache, k);
+	if (node == NULL)
+		return 0;
+
+	use_node(cache, node);
+	return 1;
+}
+
+ds_result ds_lru_cache_remove(ds_lru_cache* cache, const void* k) {
+	if (cache == NULL)
+		return GENERIC_ERROR;
+
+	struct cache_node* node = find_node(cache, k);
+	if (node != NULL)
+		release_node(cache, node);
+
+	return SUCCESS;
+}
+
+int ds_lru_cache_evict(ds_lru_cache* cache) {
+	struct cache_node* victim = pick_victim(cache, NULL);
+	if (victim == NULL)
+		return 0;
+
+	release_node(cache, victim);
+	cache->stats.evictions++;
+
+	return 1;
+}
+
+size_t ds_lru_cache_size(ds_lru_cache* cache) {
+	return ds_treemap_size(cache->map);
+}
+
+size_t ds_lru_cache_weight(ds_lru_cache* cache) {
+	return cache->weight;
+}
+
+size_t ds_lru_cache_capacity(ds_lru_cache* cache) {
+	return cache->capacity;
+}
+
+ds_lru_cache_stats ds_lru_cache_get_stats(ds_lru_cache* cache) {
+	return cache->stats;
+}
+
+void ds_lru_cache_reset_stats(ds_lru_cache* cache) {
+	memset(&cache->stats, 0, sizeof(ds_lru_cache_stats));
+}
@@ -0,0 +1,196 @@
+/**
+ * @file lru_cache.h
+ * @author Valerio Bellizia
+ *
+ * This file contains the interface to be used with ds_lru_cache. It implements a cache
+ * with a fixed capacity: entries are kept in a ds_treemap, and they are linked together in
+ * recency order by pointers stored next to the values, so that get, put and touch cost
+ * O(log n) (a single walk of the tree) and eviction costs O(log n) as well.
+ *
+ * Every entry has a weight (1 by default), and the capacity bounds the sum of the weights:
+ * it can be a number of entries, or a number of bytes when the weight is the size of the entry.
+ *
+ * Keys and values are copied into the cache. It is not thread-safe.
+ */
+
+#ifndef lru_cache_h
+#define lru_cache_h
+
+#include "result.h"
+#include "defs.h"
+
+#include <stddef.h>
+
+/**
+ * This is an opaque structure that represents a cache.
+ */
+typedef struct ds_lru_cache ds_lru_cache;
+
+/**
+ * This enumeration represents the eviction policies.
+ * DS_CACHE_LRU evicts the least recently used entry.
+ * DS_CACHE_SLRU (segmented LRU) keeps the entries that have been hit since they were inserted in a protected
+ * segment (80% of the capacity), entries used once are evicted first, so a scan cannot flush the hot entries.
+ */
+typedef enum ds_cache_policy {
+	DS_CACHE_LRU,
+	DS_CACHE_SLRU
+} ds_cache_policy;
+
+/**
+ * This structure holds the counters of a cache.
+ */
+typedef struct ds_lru_cache_stats {
+	size_t hits;
+	size_t misses;
+	size_t evictions;
+} ds_lru_cache_stats;
+
+/**
+ * This function will create a cache instance.
+ *
+ * @param key_cmp This is the key comparison function.
+ * @param key_len This is the length of the key type.
+ * @param value_len This is the length of the value type.
+ * @param capacity This is the maximum sum of the weights of the entries.
+ * @param policy This is the eviction policy.
+ *
+ * @return It returns the pointer to a new instance of ds_lru_cache, NULL if capacity is 0 or if the memory cannot be allocated.
+ */
+ds_lru_cache* create_ds_lru_cache(ds_cmp key_cmp, size_t key_len, size_t value_len, size_t capacity, ds_cache_policy policy);
+
+/**
+ * This function will release the memory of the cache. The eviction function is called for every entry.
+ *
+ * @param cache The cache.
+ */
+void delete_ds_lru_cache(ds_lru_cache* cache);
+
+/**
+ * This function will set a function that is called whenever an entry leaves the cache (because it is evicted,
+ * removed or the cache is deleted), e.g. to release memory pointed by the value.
+ *
+ * @param cache The cache.
+ * @param evict_func The function, it is like func(const void* key, void* value, void* other_args).
+ * @param other_args It is the last argument to pass evict_func.
+ */
+void ds_lru_cache_set_evict_func(ds_lru_cache* cache, void (*evict_func)(const void*, void*, void*), void* other_args);
+
+/**
+ * This function will store a <key, value> pair whose weight is 1, evicting entries if needed.
+ * If the key already exists, its value is replaced and the entry is used.
+ *
+ * @param cache The cache.
+ * @param k The key.
+ * @param v The value.
+ *
+ * @return It returns SUCCESS if the pair is stored, GENERIC_ERROR otherwise.
+ */
+ds_result ds_lru_cache_put(ds_lru_cache* cache, const void* k, const void* v);
+
+/**
+ * This function will store a <key, value> pair with the given weight, evicting entries if needed.
+ * If the key already exists, its value and weight are replaced and the entry is used.
+ *
+ * @param cache The cache.
+ * @param k The key.
+ * @param v The value.
+ * @param weight The weight of the entry.
+ *
+ * @return It returns SUCCESS if the pair is stored, GENERIC_ERROR if the weight is greater than the capacity or if the memory cannot be allocated.
+ */
+ds_result ds_lru_cache_put_weighted(ds_lru_cache* cache, const void* k, const void* v, size_t weight);
+
+/**
+ * This function will look for a key and mark its entry as used. Hits and misses are counted.
+ *
+ * @param cache The cache.
+ * @param k The key.
+ *
+ * @return It returns a pointer to the value, valid until the entry leaves the cache, NULL if the key does not exist.
+ */
+void* ds_lru_cache_get(ds_lru_cache* cache, const void* k);
+
+/**
+ * This function will look for a key without marking its entry as used and without counting hits and misses.
+ *
+ * @param cache The cache.
+ * @param k The key.
+ *
+ * @return It returns a pointer to the value, valid until the entry leaves the cache, NULL if the key does not exist.
+ */
+const void* ds_lru_cache_peek(ds_lru_cache* cache, const void* k);
+
+/**
+ * This function will mark the entry of a key as used, without counting hits and misses.
+ *
+ * @param cache The cache.
+ * @param k The key.
+ *
+ * @return It returns 1 if the key exists, 0 otherwise.
+ */
+int ds_lru_cache_touch(ds_lru_cache* cache, const void* k);
+
+/**
+ * This function will remove the entry of a key if it exists.
+ *
+ * @param cache The cache.
+ * @param k The key.
+ *
+ * @return It returns SUCCESS if the entry is removed (or does not exist).
+ */
+ds_result ds_lru_cache_remove(ds_lru_cache* cache, const void* k);
+
+/**
+ * This function will evict the entry chosen by the policy.
+ *
+ * @param cache The cache.
+ *
+ * @return It returns 1 if an entry has been evicted, 0 if the cache is empty.
+ */
+int ds_lru_cache_evict(ds_lru_cache* cache);
+
+/**
+ * This function will return the number of entries in the cache.
+ *
+ * @param cache The cache.
+ *
+ * @return The number of entries.
+ */
+size_t ds_lru_cache_size(ds_lru_cache* cache);
+
+/**
+ * This function will return the sum of the weights of the entries in the cache.
+ *
+ * @param cache The cache.
+ *
+ * @return The weight of the cache.
+ */
+size_t ds_lru_cache_weight(ds_lru_cache* cache);
+
+/**
+ * This function will return the capacity of the cache.
+ *
+ * @param cache The cache.
+ *
+ * @return The capacity.
+ */
+size_t ds_lru_cache_capacity(ds_lru_cache* cache);
+
+/**
+ * This function will return the counters of the cache.
+ *
+ * @param cache The cache.
+ *
+ * @return The hits and misses of ds_lru_cache_get, and the number of evicted entries.
+ */
+ds_lru_cache_stats ds_lru_cache_get_stats(ds_lru_cache* cache);
+
+/**
+ * This function will reset the counters of the cache.
+ *
+ * @param cache The cache.
+ */
+void ds_lru_cache_reset_stats(ds_lru_cache* cache);
+
+#endif
@@ -0,0 +1,486 @@
+/*
+ * @file pbst.c
+ * @author Valerio Bellizia
+ */
+
+#include "pbst.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+
+// the offset of the element within the memory block of a node, it is kept aligned for any type
+#define NODE_INFO_ALIGN 16
+#define NODE_INFO_OFFSET (((sizeof(ds_pbst_node) + NODE_INFO_ALIGN - 1) / NODE_INFO_ALIGN) * NODE_INFO_ALIGN)
+#define NODE_INFO(NODE) ((char*)(NODE) + NODE_INFO_OFFSET)
+
+// struct definitions
+
+/*
+ * spare holds nodes allocated before a change starts (linked through left), so that the copies
+ * made while changing the tree cannot fail halfway and leave the version inconsistent.
+ */
+struct ds_pbst {
+	ds_pbst_node* root;
+	ds_cmp cmp;
+	size_t elements;
+	size_t element_size;
+	int snapshot;
+	ds_pbst_node* spare;
+	size_t spares;
+};
+
+/*
+ * refs counts the references to the node, coming from parent nodes or from versions of the tree
+ * (for roots). A node referenced once belongs to a single version and can be changed in place,
+ * otherwise it has to be copied before being changed. Versions sharing a node may be released
+ * on different threads, so refs is atomic.
+ */
+struct ds_pbst_node {
+	atomic_size_t refs;
+	int height;
+	struct ds_pbst_node* left;
+	struct ds_pbst_node* right;
+};
+
+// The following will make msvc happy
+#ifndef max
+static int max(int i1, int i2) {
+	return (i1 > i2) ? i1 : i2;
+}
+#endif
+
+static int node_height(ds_pbst_node* node) {
+	return node != NULL ? node->height : 0;
+}
+
+static int node_balance(ds_pbst_node* node) {
+	return node != NULL ? node_height(node->left) - node_height(node->right) : 0;
+}
+
+static void node_update(ds_pbst_node* node) {
+	node->height = 1 + max(node_height(node->left), node_height(node->right));
+}
+
+static ds_pbst_node* create_node(const void* element, const size_t size) {
+	ds_pbst_node* node = (ds_pbst_node*) malloc(NODE_INFO_OFFSET + size);
+	if (node != NULL) {
+		atomic_init(&node->refs, 1);
+		node->height = 1;
+		node->left = NULL;
+		node->right = NULL;
+		memcpy(NODE_INFO(node), element, size);
+	}
+
+	return node;
+}
+
+static void acquire(ds_pbst_node* node) {
+	if (node != NULL)
+		atomic_fetch_add_explicit(&node->refs, 1, memory_order_relaxed);
+}
+
+// the last release sees all the reads done through the other references before it frees the node
+static void release(ds_pbst_node* node) {
+	if (node == NULL || atomic_fetch_sub_explicit(&node->refs, 1, memory_order_acq_rel) > 1)
+		return;
+
+	release(node->left);
+	release(node->right);
+	free(node);
+}
+
+// it makes sure that a change can take up to needed nodes from the spare ones, it returns 0 if the memory cannot be allocated
+static int reserve_nodes(ds_pbst* t, size_t needed) {
+	while (t->spares < needed) {
+		ds_pbst_node* node = (ds_pbst_node*) malloc(NODE_INFO_OFFSET + t->element_size);
+		if (node == NULL)
+			return 0;
+
+		node->left = t->spare;
+		t->spare = node;
+		t->spares++;
+	}
+
+	return 1;
+}
+
+// a change copies the nodes on its path and, while rebalancing, at most two more nodes per level
+static size_t nodes_to_reserve(ds_pbst* t) {
+	return 3 * (size_t) node_height(t->root) + 1;
+}
+
+// it returns a node that can be changed in place, it is a copy (taken from the spare nodes) of the given one if it is shared
+static ds_pbst_node* own(ds_pbst* t, ds_pbst_node* node) {
+	if (node == NULL || atomic_load_explicit(&node->refs, memory_order_acquire) == 1)
+		return node;
+
+	ds_pbst_node* copy = t->spare;
+	t->spare = copy->left;
+	t->spares--;
+
+	atomic_init(&copy->refs, 1);
+	memcpy(NODE_INFO(copy), NODE_INFO(node), t->element_size);
+	copy->height = node->height;
+	copy->left = node->left;
+	copy->right = node->right;
+	acquire(copy->left);
+	acquire(copy->right);
+
+	// the reference we are holding now points to the copy, the other versions may have dropped theirs meanwhile
+	release(node);
+	return copy;
+}
+
+/*
+ * In all the following functions the caller passes its own reference to the subtree, and
+ * it gets back the reference to the new version of the subtree. Nodes are made exclusive
+ * with own() before being changed. Since copies are created while going down from the root,
+ * a node referenced once is reachable only through nodes of the version being changed.
+ */
+
+static ds_pbst_node* rotate_right(ds_pbst* t, ds_pbst_node* node) {
+	node->left = own(t, node->left);
+	ds_pbst_node* l = node->left;
+
+	node->left = l->right;
+	l->right = node;
+
+	node_update(node);
+	node_update(l);
+
+	return l;
+}
+
+static ds_pbst_node* rotate_left(ds_pbst* t, ds_pbst_node* node) {
+	node->right = own(t, node->right);
+	ds_pbst_node* r = node->right;
+
+	node->right = r->left;
+	r->left = node;
+
+	node_update(node);
+	node_update(r);
+
+	return r;
+}
+
+static ds_pbst_node* rebalance(ds_pbst* t, ds_pbst_node* node) {
+	node_update(node);
+
+	int balance = node_balance(node);
+	if (balance > 1) {
+		if (node_balance(node->left) < 0) {
+			node->left = own(t, node->left);
+			node->left = rotate_left(t, node->left);
+		}
+		return rotate_right(t, node);
+	}
+
+	if (balance < -1) {
+		if (node_balance(node->right) > 0) {
+			node->right = own(t, node->right);
+			node->right = rotate_right(t, node->right);
+		}
+		return rotate_left(t, node);
+	}
+
+	return node;
+}
+
+// the element must exist, the path to it is copied and the copy of its node takes the new element
+static ds_pbst_node* replace_node(ds_pbst* t, ds_pbst_node* node, const void* element) {
+	node = own(t, node);
+
+	int cmp_res = t->cmp(element, NODE_INFO(node));
+	if (cmp_res == 0)
+		memcpy(NODE_INFO(node), element, t->element_size);
+	else if (cmp_res < 0)
+		node->left = replace_node(t, node->left, element);
+	else
+		node->right = replace_node(t, node->right, element);
+
+	return node;
+}
+
+static ds_pbst_node* insert_node(ds_pbst* t, ds_pbst_node* node, ds_pbst_node* leaf) {
+	if (node == NULL)
+		return leaf;
+
+	node = own(t, node);
+	if (t->cmp(NODE_INFO(leaf), NODE_INFO(node)) < 0)
+		node->left = insert_node(t, node->left, leaf);
+	else
+		node->right = insert_node(t, node->right, leaf);
+
+	return rebalance(t, node);
+}
+
+static ds_pbst_node* delete_node(ds_pbst* t, ds_pbst_node* node, const void* element) {
+	node = own(t, node);
+
+	int cmp_res = t->cmp(element, NODE_INFO(node));
+	if (cmp_res < 0)
+		node->left = delete_node(t, node->left, element);
+	else if (cmp_res > 0)
+		node->right = delete_node(t, node->right, element);
+	else if (node->left != NULL && node->right != NULL) {
+		// the successor takes the place of the element, then it is removed from the right subtree
+		ds_pbst_node* successor = node->right;
+		while (successor->left != NULL)
+			successor = successor->left;
+		memcpy(NODE_INFO(node), NODE_INFO(successor), t->element_size);
+
+		node->right = delete_node(t, node->right, NODE_INFO(node));
+	}
+	else {
+		// the only child (if any) takes the place of the node, the reference to it moves to the caller
+		ds_pbst_node* child = (node->left != NULL) ? node->left : node->right;
+		node->left = NULL;
+		node->right = NULL;
+		release(node);
+
+		return child;
+	}
+
+	return rebalance(t, node);
+}
+
+static ds_pbst_node* search_node(ds_pbst* t, const void* element) {
+	ds_pbst_node* n = t->root;
+	while (n != NULL) {
+		int cmp_res = t->cmp(element, NODE_INFO(n));
+		if (cmp_res == 0)
+			return n;
+		n = (cmp_res < 0) ? n->left : n->right;
+	}
+
+	return NULL;
+}
+
+static ds_pbst* create_version(ds_pbst* t, int snapshot) {
+	if (t == NULL)
+		return NULL;
+
+	ds_pbst* version = (ds_pbst*) malloc(sizeof(ds_pbst));
+	if (version == NULL)
+		return NULL;
+
+	version->root = t->root;
+	version->cmp = t->cmp;
+	version->elements = t->elements;
+	version->element_size = t->element_size;
+	version->snapshot = snapshot;
+	version->spare = NULL;
+	version->spares = 0;
+	acquire(version->root);
+
+	return version;
+}
+
+// iterator helpers
+
+static void push_leftmost(ds_pbst_iterator* it, ds_pbst_node* node) {
+	for (ds_pbst_node* n = node; n != NULL; n = n->left)
+		it->path[it->depth++] = n;
+}
+
+static void push_rightmost(ds_pbst_iterator* it, ds_pbst_node* node) {
+	for (ds_pbst_node* n = node; n != NULL; n = n->right)
+		it->path[it->depth++] = n;
+}
+
+// Interface functions
+
+void ds_pbst_iterator_next(ds_pbst_iterator* it) {
+	ds_pbst_node* current = it->path[it->depth - 1];
+	if (current->right != NULL) {
+		push_leftmost(it, current->right);
+		return;
+	}
+
+	// going up until we come from a left child
+	it->depth--;
+	while (it->depth > 0 && it->path[it->depth - 1]->right == current) {
+		current = it->path[it->depth - 1];
+		it->depth--;
+	}
+}
+
+void ds_pbst_iterator_prev(ds_pbst_iterator* it) {
+	ds_pbst_node* current = it->path[it->depth - 1];
+	if (current->left != NULL) {
+		push_rightmost(it, current->left);
+		return;
+	}
+
+	// going up until we come from a right child
+	it->depth--;
+	while (it->depth > 0 && it->path[it->depth - 1]->left == current) {
+		current = it->path[it->depth - 1];
+		it->depth--;
+	}
+}
+
+int ds_pbst_iterator_is_valid(ds_pbst_iterator* it) {
+	return it->depth > 0;
+}
+
+const void* ds_pbst_iterator_get(ds_pbst_iterator* it) {
+	return NODE_INFO(it->path[it->depth - 1]);
+}
+
+ds_pbst* create_ds_pbst(ds_cmp cmp_func, const size_t size) {
+	ds_pbst* t = (ds_pbst*) malloc(sizeof(ds_pbst));
+	if (t == NULL)
+		return NULL;
+
+	t->root = NULL;
+	t->cmp = cmp_func;
+	t->elements = 0;
+	t->element_size = size;
+	t->snapshot = 0;
+	t->spare = NULL;
+	t->spares = 0;
+
+	return t;
+}
+
+void delete_ds_pbst(ds_pbst* t) {
+	if (t == NULL)
+		return;
+
+	release(t->root);
+	while (t->spare != NULL) {
+		ds_pbst_node* next = t->spare->left;
+		free(t->spare);
+		t->spare = next;
+	}
+	free(t);
+}
+
+ds_pbst* ds_pbst_snapshot(ds_pbst* t) {
+	return create_version(t, 1);
+}
+
+ds_pbst* ds_pbst_clone(ds_pbst* t) {
+	return create_version(t, 0);
+}
+
+int ds_pbst_is_snapshot(const ds_pbst* t) {
+	return t->snapshot;
+}
+
+size_t ds_pbst_size(const ds_pbst* t) {
+	return t->elements;
+}
+
+ds_result ds_pbst_insert(ds_pbst* t, const void* element) {
+	if (t == NULL || element == NULL || t->snapshot)
+		return GENERIC_ERROR;
+
+	if (search_node(t, element) != NULL)
+		return ELEMENT_ALREADY_EXISTS;
+
+	ds_pbst_node* leaf = create_node(element, t->element_size);
+	if (leaf == NULL)
+		return GENERIC_ERROR;
+	if (!reserve_nodes(t, nodes_to_reserve(t))) {
+		free(leaf);
+		return GENERIC_ERROR;
+	}
+
+	t->root = insert_node(t, t->root, leaf);
+	t->elements++;
+
+	return SUCCESS;
+}
+
+ds_result ds_pbst_put(ds_pbst* t, const void* element) {
+	if (t == NULL || element == NULL || t->snapshot)
+		return GENERIC_ERROR;
+
+	if (search_node(t, element) == NULL)
+		return ds_pbst_insert(t, element);
+	if (!reserve_nodes(t, nodes_to_reserve(t)))
+		return GENERIC_ERROR;
+
+	t->root = replace_node(t, t->root, element);
+
+	return SUCCESS;
+}
+
+ds_result ds_pbst_remove(ds_pbst* t, const void* element) {
+	if (t == NULL || t->snapshot)
+		return GENERIC_ERROR;
+
+	if (element == NULL || search_node(t, element) == NULL)
+		return SUCCESS;
+	if (!reserve_nodes(t, nodes_to_reserve(t)))
+		return GENERIC_ERROR;
+
+	t->root = delete_node(t, t->root, element);
+	t->elements--;
+
+	return SUCCESS;
+}
+
+int ds_pbst_search(ds_pbst* t, const void* element) {
+	return ds_pbst_get(t, element) != NULL;
+}
+
+const void* ds_pbst_get(ds_pbst* t, const void* element) {
+	if (t == NULL || element == NULL)
+		return NULL;
+
+	ds_pbst_node* node = search_node(t, element);
+	return (node != NULL) ? NODE_INFO(node) : NULL;
+}
+
+const void* ds_pbst_max(ds_pbst* t) {
+	if (t == NULL || t->root == NULL)
+		return NULL;
+
+	ds_pbst_node* n = t->root;
+	while (n->right != NULL)
+		n = n->right;
+
+	return NODE_INFO(n);
+}
+
+const void* ds_pbst_min(ds_pbst* t) {
+	if (t == NULL || t->root == NULL)
+		return NULL;
+
+	ds_pbst_node* n = t->root;
+	while (n->left != NULL)
+		n = n->left;
+
+	return NODE_INFO(n);
+}
+
+ds_pbst_iterator ds_pbst_first(ds_pbst* t) {
+	ds_pbst_iterator it;
+	it.tree = t;
+	it.depth = 0;
+	push_leftmost(&it, t->root);
+
+	return it;
+}
+
+ds_pbst_iterator ds_pbst_last(ds_pbst* t) {
+	ds_pbst_iterator it;
+	it.tree = t;
+	it.depth = 0;
+	push_rightmost(&it, t->root);
+
+	return it;
+}
+
+void ds_pbst_visit(ds_pbst* t, void (*visit_func)(const void*, void*), void* other_args) {
+	if (t == NULL)
+		return;
+
+	for (ds_pbst_iterator it = ds_pbst_first(t); ds_pbst_iterator_is_valid(&it); ds_pbst_iterator_next(&it))
+		visit_func(ds_pbst_iterator_get(&it), other_args);
+}
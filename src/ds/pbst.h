@@ -0,0 +1,257 @@
+/**
+ * @file pbst.h
+ * @author Valerio Bellizia
+ *
+ * This file contains the interface to be used with ds_pbst. It implements
+ * a persistent binary search tree (an AVL tree) that can take snapshots in O(1).
+ * Nodes are reference counted and shared among the versions of the tree: insert
+ * and remove copy only the path from the root to the changed node when it is shared
+ * with some other version, unchanged subtrees are never copied.
+ * Reference counts are atomic, so versions sharing nodes can be read and released on
+ * different threads. A single version must not be changed while another thread uses it.
+ */
+
+#ifndef pbst_h
+#define pbst_h
+
+#include "result.h"
+#include "defs.h"
+
+#include <stddef.h>
+
+/**
+ * This is the maximum height of a tree that can be walked by an iterator. An AVL tree
+ * of height 64 holds more than 2^44 elements.
+ */
+#define DS_PBST_MAX_HEIGHT 64
+
+/**
+ * This is an opaque structure that represents a version of a persistent binary tree.
+ */
+typedef struct ds_pbst ds_pbst;
+
+/**
+ * This is an opaque structure that represents a persistent binary tree node.
+ */
+typedef struct ds_pbst_node ds_pbst_node;
+
+/**
+ * This is a structure that represents an iterator for a persistent binary tree.
+ * Nodes do not know their parent (they may have many), so the iterator keeps the path from the root.
+ * An iterator stays valid as long as the tree it walks is not changed, iterators on snapshots are always valid.
+ */
+typedef struct ds_pbst_iterator {
+	const ds_pbst* tree;
+	int depth;
+	ds_pbst_node* path[DS_PBST_MAX_HEIGHT];
+} ds_pbst_iterator;
+
+/**
+ * This function will move the iterator forward.
+ *
+ * @param it The iterator.
+ */
+void ds_pbst_iterator_next(ds_pbst_iterator* it);
+
+/**
+ * This function will move the iterator backward.
+ *
+ * @param it The iterator.
+ */
+void ds_pbst_iterator_prev(ds_pbst_iterator* it);
+
+/**
+ * This function can be used to check if the iterator is valid.
+ *
+ * @param it The iterator.
+ *
+ * @return it returns 1 if the iterator is valid, 0 otherwise.
+ */
+int ds_pbst_iterator_is_valid(ds_pbst_iterator* it);
+
+/**
+ * This function will get the element pointed by the iterator as const void*.
+ *
+ * @param it The iterator.
+ *
+ * @return The pointer to the element pointed by the iterator.
+ */
+const void* ds_pbst_iterator_get(ds_pbst_iterator* it);
+
+/**
+ * This function will get the typed pointer to the element pointed by the iterator.
+ *
+ * @param TYPE The type we want as output.
+ * @param IT The iterator.
+ *
+ * @return The pointer to the element stored into the tree casted to the given type.
+ */
+#define ds_pbst_iterator_get_ptr(TYPE, IT) ((TYPE*)ds_pbst_iterator_get(IT))
+
+/**
+ * This function will get the value of the element pointed by the iterator.
+ *
+ * @param TYPE The type we want as output.
+ * @param IT The iterator.
+ *
+ * @return The value to the element stored into the tree casted to the given type.
+ */
+#define ds_pbst_iterator_get_value(TYPE, IT) (*(TYPE*)ds_pbst_iterator_get(IT))
+
+/**
+ * This function will create an instance of ds_pbst.
+ *
+ * @param cmp_func This is the pointer to a function that will be used to compare two elements.
+ * @param size It is the size of the element that the tree is supposed to store.
+ *
+ * @return It returns the pointer to a new instance of ds_pbst.
+ */
+ds_pbst* create_ds_pbst(ds_cmp cmp_func, const size_t size);
+
+/**
+ * This function will release a version of the tree. Nodes shared with other versions are kept alive.
+ *
+ * @param t The persistent binary tree.
+ */
+void delete_ds_pbst(ds_pbst* t);
+
+/**
+ * This function will take an immutable snapshot of the tree in O(1). The snapshot is not affected by
+ * any further change to the tree, and it has to be released with delete_ds_pbst.
+ *
+ * @param t The persistent binary tree.
+ *
+ * @return It returns a new read-only version of the tree, NULL if the memory cannot be allocated.
+ */
+ds_pbst* ds_pbst_snapshot(ds_pbst* t);
+
+/**
+ * This function will create, in O(1), a new writable version of the tree. The new version and the
+ * original one can be changed independently, and it has to be released with delete_ds_pbst.
+ *
+ * @param t The persistent binary tree.
+ *
+ * @return It returns a new writable version of the tree, NULL if the memory cannot be allocated.
+ */
+ds_pbst* ds_pbst_clone(ds_pbst* t);
+
+/**
+ * This function will tell if the given version of the tree is a read-only snapshot.
+ *
+ * @param t The persistent binary tree.
+ *
+ * @return It returns 1 if t has been created by ds_pbst_snapshot, 0 otherwise.
+ */
+int ds_pbst_is_snapshot(const ds_pbst* t);
+
+/**
+ * This function will return the number of elements stored in the tree.
+ *
+ * @param t The persistent binary tree.
+ *
+ * @return The number of elements stored in the tree.
+ */
+size_t ds_pbst_size(const ds_pbst* t);
+
+/**
+ * This function will insert an element into the tree. Only the nodes on the path to the new element
+ * that are shared with other versions are copied.
+ *
+ * @param t The persistent binary tree.
+ * @param element The element.
+ *
+ * @return The result of the operation. It returns ELEMENT_ALREADY_EXISTS when inserting a duplicate, GENERIC_ERROR on snapshots
+ * or if the memory cannot be allocated (the tree is left unchanged).
+ */
+ds_result ds_pbst_insert(ds_pbst* t, const void* element);
+
+/**
+ * This function will insert an element into the tree, or replace the stored element that compares equal to it.
+ * Only the nodes on the path to the element that are shared with other versions are copied, so the other versions
+ * still see the element they hold.
+ *
+ * @param t The persistent binary tree.
+ * @param element The element.
+ *
+ * @return The result of the operation. It returns GENERIC_ERROR on snapshots or if the memory cannot be allocated (the tree is left unchanged).
+ */
+ds_result ds_pbst_put(ds_pbst* t, const void* element);
+
+/**
+ * This function will remove an element from the tree if exists. Only the nodes on the path to the removed
+ * element (and the ones touched by rebalancing) that are shared with other versions are copied.
+ *
+ * @param t The persistent binary tree.
+ * @param element The element.
+ *
+ * @return The result of the operation. It returns GENERIC_ERROR on snapshots or if the memory cannot be allocated (the tree is left unchanged).
+ */
+ds_result ds_pbst_remove(ds_pbst* t, const void* element);
+
+/**
+ * This function will look for an element into the tree.
+ *
+ * @param t The persistent binary tree.
+ * @param element The element.
+ *
+ * @return It returns 1 if the element exists, 0 otherwise.
+ */
+int ds_pbst_search(ds_pbst* t, const void* element);
+
+/**
+ * This function will look for an element into the tree, if exists it will
+ * return a pointer to the element, NULL otherwise.
+ *
+ * @param t The persistent binary tree.
+ * @param element The element we are looking for.
+ *
+ * @return It returns a pointer to the element into the tree if such element exists, NULL otherwise.
+ */
+const void* ds_pbst_get(ds_pbst* t, const void* element);
+
+/**
+ * This function will return the maximum value into the tree.
+ *
+ * @param t The persistent binary tree.
+ *
+ * @return The maximum value stored in the tree, NULL if it is empty.
+ */
+const void* ds_pbst_max(ds_pbst* t);
+
+/**
+ * This function will return the minimum value into the tree.
+ *
+ * @param t The persistent binary tree.
+ *
+ * @return The minimum value stored in the tree, NULL if it is empty.
+ */
+const void* ds_pbst_min(ds_pbst* t);
+
+/**
+ * This function will return an iterator to the first (smallest) element of the tree.
+ *
+ * @param t The persistent binary tree.
+ *
+ * @return The iterator to the smallest element of the tree.
+ */
+ds_pbst_iterator ds_pbst_first(ds_pbst* t);
+
+/**
+ * This function will return an iterator to the last (biggest) element of the tree.
+ *
+ * @param t The persistent binary tree.
+ *
+ * @return The iterator to the biggest element of the tree.
+ */
+ds_pbst_iterator ds_pbst_last(ds_pbst* t);
+
+/**
+ * This function will visit all the elements of the tree in order.
+ *
+ * @param t The persistent binary tree.
+ * @param visit_func The function that will be used to visit the elements. It is a function like func(const void*, void*) where the first argument is the pointer to the element, and the second is an optional argument that may be used with this function to pass data.
+ * @param other_args It is the second argument to pass visit_func.
+ */
+void ds_pbst_visit(ds_pbst* t, void (*visit_func)(const void*, void*), void* other_args);
+
+#endif
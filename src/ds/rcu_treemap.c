@@ -0,0 +1,288 @@
+/*
+ * @file rcu_treemap.c
+ * @author Valerio Bellizia
+ */
+
+#include "rcu_treemap.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+// struct definitions
+
+/*
+ * Every element of a version is laid out as [key | padding | value], so key_cmp can compare
+ * elements and a plain key can be used as a probe.
+ *
+ * Readers announce the epoch they have seen when they pin a version (0 means not reading).
+ * A replaced version is tagged with the epoch that was current when it has been replaced,
+ * and it can be released once every reader is either not reading or has seen a later epoch:
+ * such readers loaded the map after the new version has been published.
+ */
+struct ds_rcu_treemap {
+	_Atomic(ds_pbst*) current;
+	atomic_size_t epoch;
+
+	ds_cmp key_cmp;
+	size_t key_len;
+	size_t value_len;
+	size_t value_offset;
+
+	// everything below is protected by the writer lock
+	pthread_mutex_t write_lock;
+	struct ds_rcu_treemap_reader* readers;
+	struct retired_version* retired;
+	size_t retired_count;
+};
+
+struct ds_rcu_treemap_reader {
+	ds_rcu_treemap* map;
+	atomic_size_t epoch;
+	ds_pbst* version;
+
+	struct ds_rcu_treemap_reader* next;
+};
+
+struct retired_version {
+	ds_pbst* version;
+	size_t epoch;
+
+	struct retired_version* next;
+};
+
+// helpers
+
+static int is_safe_to_release(ds_rcu_treemap* map, size_t epoch) {
+	for (ds_rcu_treemap_reader* r = map->readers; r != NULL; r = r->next) {
+		size_t seen = atomic_load(&r->epoch);
+		if (seen != 0 && seen <= epoch)
+			return 0;
+	}
+
+	return 1;
+}
+
+// it must be called holding the writer lock
+static void reclaim_versions(ds_rcu_treemap* map) {
+	struct retired_version** link = &map->retired;
+	while (*link != NULL) {
+		struct retired_version* r = *link;
+		if (is_safe_to_release(map, r->epoch)) {
+			*link = r->next;
+			delete_ds_pbst(r->version);
+			free(r);
+			map->retired_count--;
+		}
+		else
+			link = &r->next;
+	}
+}
+
+// it must be called holding the writer lock, the new version replaces the current one
+static ds_result publish(ds_rcu_treemap* map, ds_pbst* version) {
+	struct retired_version* r = (struct retired_version*) malloc(sizeof(struct retired_version));
+	if (r == NULL) {
+		delete_ds_pbst(version);
+		return GENERIC_ERROR;
+	}
+
+	r->version = atomic_exchange(&map->current, version);
+	r->epoch = atomic_fetch_add(&map->epoch, 1);
+	r->next = map->retired;
+	map->retired = r;
+	map->retired_count++;
+
+	reclaim_versions(map);
+
+	return SUCCESS;
+}
+
+// it applies op (ds_pbst_insert or ds_pbst_put) to a new version of the map, then it publishes the version
+static ds_result store(ds_rcu_treemap* map, const void* k, const void* v, ds_result (*op)(ds_pbst*, const void*)) {
+	if (map == NULL || k == NULL || v == NULL)
+		return GENERIC_ERROR;
+
+	char* element = (char*) malloc(map->value_offset + map->value_len);
+	if (element == NULL)
+		return GENERIC_ERROR;
+	memcpy(element, k, map->key_len);
+	memcpy(element + map->value_offset, v, map->value_len);
+
+	pthread_mutex_lock(&map->write_lock);
+
+	// the published version is never changed: the new one shares all the nodes but the ones on the changed path
+	ds_result res = GENERIC_ERROR;
+	ds_pbst* version = ds_pbst_clone(atomic_load(&map->current));
+	if (version != NULL) {
+		res = op(version, element);
+		if (res == SUCCESS)
+			res = publish(map, version);
+		else
+			delete_ds_pbst(version);
+	}
+
+	pthread_mutex_unlock(&map->write_lock);
+	free(element);
+
+	return res;
+}
+
+// Interface functions
+
+ds_rcu_treemap* create_ds_rcu_treemap(ds_cmp key_cmp, size_t key_len, size_t value_len) {
+	ds_rcu_treemap* map = (ds_rcu_treemap*) malloc(sizeof(ds_rcu_treemap));
+	if (map == NULL)
+		return NULL;
+
+	size_t align = sizeof(void*);
+	map->key_cmp = key_cmp;
+	map->key_len = key_len;
+	map->value_len = value_len;
+	map->value_offset = ((key_len + align - 1) / align) * align;
+
+	ds_pbst* version = create_ds_pbst(key_cmp, map->value_offset + value_len);
+	if (version == NULL || pthread_mutex_init(&map->write_lock, NULL) != 0) {
+		delete_ds_pbst(version);
+		free(map);
+		return NULL;
+	}
+
+	atomic_init(&map->current, version);
+	atomic_init(&map->epoch, 1);
+	map->readers = NULL;
+	map->retired = NULL;
+	map->retired_count = 0;
+
+	return map;
+}
+
+void delete_ds_rcu_treemap(ds_rcu_treemap* map) {
+	if (map == NULL)
+		return;
+
+	while (map->retired != NULL) {
+		struct retired_version* r = map->retired;
+		map->retired = r->next;
+		delete_ds_pbst(r->version);
+		free(r);
+	}
+
+	delete_ds_pbst(atomic_load(&map->current));
+	pthread_mutex_destroy(&map->write_lock);
+	free(map);
+}
+
+ds_rcu_treemap_reader* ds_rcu_treemap_register_reader(ds_rcu_treemap* map) {
+	ds_rcu_treemap_reader* reader = (ds_rcu_treemap_reader*) malloc(sizeof(ds_rcu_treemap_reader));
+	if (reader == NULL)
+		return NULL;
+
+	reader->map = map;
+	atomic_init(&reader->epoch, 0);
+	reader->version = NULL;
+
+	pthread_mutex_lock(&map->write_lock);
+	reader->next = map->readers;
+	map->readers = reader;
+	pthread_mutex_unlock(&map->write_lock);
+
+	return reader;
+}
+
+void ds_rcu_treemap_unregister_reader(ds_rcu_treemap_reader* reader) {
+	if (reader == NULL)
+		return;
+
+	ds_rcu_treemap* map = reader->map;
+	pthread_mutex_lock(&map->write_lock);
+	ds_rcu_treemap_reader** link = &map->readers;
+	while (*link != reader)
+		link = &(*link)->next;
+	*link = reader->next;
+	pthread_mutex_unlock(&map->write_lock);
+
+	free(reader);
+}
+
+void ds_rcu_treemap_read_lock(ds_rcu_treemap_reader* reader) {
+	// the epoch must be visible before loading the version (both are sequentially consistent)
+	atomic_store(&reader->epoch, atomic_load(&reader->map->epoch));
+	reader->version = atomic_load(&reader->map->current);
+}
+
+void ds_rcu_treemap_read_unlock(ds_rcu_treemap_reader* reader) {
+	reader->version = NULL;
+	atomic_store(&reader->epoch, 0);
+}
+
+const void* ds_rcu_treemap_get(ds_rcu_treemap_reader* reader, const void* k) {
+	const char* element = (const char*) ds_pbst_get(reader->version, k);
+	if (element == NULL)
+		return NULL;
+
+	return element + reader->map->value_offset;
+}
+
+int ds_rcu_treemap_search(ds_rcu_treemap_reader* reader, const void* k) {
+	return ds_pbst_search(reader->version, k);
+}
+
+size_t ds_rcu_treemap_size(ds_rcu_treemap_reader* reader) {
+	return ds_pbst_size(reader->version);
+}
+
+ds_rcu_treemap_iterator ds_rcu_treemap_first(ds_rcu_treemap_reader* reader) {
+	return ds_pbst_first(reader->version);
+}
+
+const void* ds_rcu_treemap_iterator_key(ds_rcu_treemap_iterator* it) {
+	return ds_pbst_iterator_get(it);
+}
+
+const void* ds_rcu_treemap_iterator_value(ds_rcu_treemap* map, ds_rcu_treemap_iterator* it) {
+	return (const char*) ds_pbst_iterator_get(it) + map->value_offset;
+}
+
+ds_result ds_rcu_treemap_insert(ds_rcu_treemap* map, const void* k, const void* v) {
+	return store(map, k, v, ds_pbst_insert);
+}
+
+ds_result ds_rcu_treemap_put(ds_rcu_treemap* map, const void* k, const void* v) {
+	return store(map, k, v, ds_pbst_put);
+}
+
+ds_result ds_rcu_treemap_remove(ds_rcu_treemap* map, const void* k) {
+	if (map == NULL)
+		return GENERIC_ERROR;
+
+	pthread_mutex_lock(&map->write_lock);
+
+	ds_result res = SUCCESS;
+	ds_pbst* current = atomic_load(&map->current);
+	if (ds_pbst_search(current, k)) {
+		ds_pbst* version = ds_pbst_clone(current);
+		res = GENERIC_ERROR;
+		if (version != NULL) {
+			res = ds_pbst_remove(version, k);
+			if (res == SUCCESS)
+				res = publish(map, version);
+			else
+				delete_ds_pbst(version);
+		}
+	}
+
+	pthread_mutex_unlock(&map->write_lock);
+
+	return res;
+}
+
+size_t ds_rcu_treemap_reclaim(ds_rcu_treemap* map) {
+	pthread_mutex_lock(&map->write_lock);
+	reclaim_versions(map);
+	size_t left = map->retired_count;
+	pthread_mutex_unlock(&map->write_lock);
+
+	return left;
+}
@@ -0,0 +1,195 @@
+/**
+ * @file rcu_treemap.h
+ * @author Valerio Bellizia
+ *
+ * This file contains the interface to be used with ds_rcu_treemap. It implements
+ * a treemap for read-mostly workloads: readers never take locks, while writers
+ * (serialised by an internal mutex) publish a new version of the map with an atomic
+ * pointer swap. Versions are ds_pbst instances, so a write copies only O(log n) nodes,
+ * and replaced versions are released with an epoch-based reclamation scheme once no
+ * reader can be using them anymore.
+ *
+ * Keys and values are copied into the map.
+ */
+
+#ifndef rcu_treemap_h
+#define rcu_treemap_h
+
+#include "result.h"
+#include "defs.h"
+#include "pbst.h"
+
+#include <stddef.h>
+
+/**
+ * This is an opaque structure that represents a RCU treemap.
+ */
+typedef struct ds_rcu_treemap ds_rcu_treemap;
+
+/**
+ * This is an opaque structure that represents a reader of a RCU treemap. Every thread reading
+ * the map needs its own reader.
+ */
+typedef struct ds_rcu_treemap_reader ds_rcu_treemap_reader;
+
+/**
+ * This is an iterator on the version of the map pinned by a reader.
+ */
+typedef struct ds_pbst_iterator ds_rcu_treemap_iterator;
+
+/**
+ * This function will create a RCU treemap instance.
+ *
+ * @param key_cmp This is the key comparison function.
+ * @param key_len This is the length of the key type.
+ * @param value_len This is the length of the value type.
+ *
+ * @return It returns the pointer to a new instance of ds_rcu_treemap.
+ */
+ds_rcu_treemap* create_ds_rcu_treemap(ds_cmp key_cmp, size_t key_len, size_t value_len);
+
+/**
+ * This function will release the memory of the map. No reader should be using the map
+ * and all of them should have been unregistered.
+ *
+ * @param map The RCU treemap.
+ */
+void delete_ds_rcu_treemap(ds_rcu_treemap* map);
+
+/**
+ * This function will register a new reader. It takes the writer lock, so it should not be
+ * called on the hot path.
+ *
+ * @param map The RCU treemap.
+ *
+ * @return It returns the reader, NULL if the memory cannot be allocated.
+ */
+ds_rcu_treemap_reader* ds_rcu_treemap_register_reader(ds_rcu_treemap* map);
+
+/**
+ * This function will unregister a reader and release its memory. The reader should not be
+ * within a read-side critical section.
+ *
+ * @param reader The reader.
+ */
+void ds_rcu_treemap_unregister_reader(ds_rcu_treemap_reader* reader);
+
+/**
+ * This function will start a read-side critical section: it pins the current version of the map,
+ * so that every read done through the reader sees the same version. It never blocks.
+ *
+ * @param reader The reader.
+ */
+void ds_rcu_treemap_read_lock(ds_rcu_treemap_reader* reader);
+
+/**
+ * This function will end a read-side critical section. Pointers and iterators obtained within
+ * the critical section must not be used after this call.
+ *
+ * @param reader The reader.
+ */
+void ds_rcu_treemap_read_unlock(ds_rcu_treemap_reader* reader);
+
+/**
+ * This function will get the value associated to a key in the version pinned by the reader.
+ *
+ * @param reader The reader, it must be within a read-side critical section.
+ * @param k The key.
+ *
+ * @return It returns a pointer to the value, valid until ds_rcu_treemap_read_unlock, NULL if the key does not exist.
+ */
+const void* ds_rcu_treemap_get(ds_rcu_treemap_reader* reader, const void* k);
+
+/**
+ * This function will look for a key in the version pinned by the reader.
+ *
+ * @param reader The reader, it must be within a read-side critical section.
+ * @param k The key.
+ *
+ * @return It returns 1 if the key is found, 0 otherwise.
+ */
+int ds_rcu_treemap_search(ds_rcu_treemap_reader* reader, const void* k);
+
+/**
+ * This function will return the number of elements in the version pinned by the reader.
+ *
+ * @param reader The reader, it must be within a read-side critical section.
+ *
+ * @return It returns the number of elements.
+ */
+size_t ds_rcu_treemap_size(ds_rcu_treemap_reader* reader);
+
+/**
+ * This function will return an iterator to the first element of the version pinned by the reader.
+ * Use the ds_pbst_iterator functions to move it.
+ *
+ * @param reader The reader, it must be within a read-side critical section.
+ *
+ * @return It returns an iterator to the first element.
+ */
+ds_rcu_treemap_iterator ds_rcu_treemap_first(ds_rcu_treemap_reader* reader);
+
+/**
+ * This function will return the key of the element pointed by the iterator.
+ *
+ * @param it The iterator.
+ *
+ * @return It returns a pointer to the key.
+ */
+const void* ds_rcu_treemap_iterator_key(ds_rcu_treemap_iterator* it);
+
+/**
+ * This function will return the value of the element pointed by the iterator.
+ *
+ * @param map The RCU treemap.
+ * @param it The iterator.
+ *
+ * @return It returns a pointer to the value.
+ */
+const void* ds_rcu_treemap_iterator_value(ds_rcu_treemap* map, ds_rcu_treemap_iterator* it);
+
+/**
+ * This function will insert a <key, value> pair in the map and publish the new version.
+ *
+ * @param map The RCU treemap.
+ * @param k The key.
+ * @param v The value.
+ *
+ * @return It returns SUCCESS if the element is inserted properly. It returns ELEMENT_ALREADY_EXISTS when adding an element whose key already exists.
+ */
+ds_result ds_rcu_treemap_insert(ds_rcu_treemap* map, const void* k, const void* v);
+
+/**
+ * This function will insert a <key, value> pair in the map, or replace the value if the key already exists,
+ * and publish the new version. Readers see either the old or the new value, the key is never missing.
+ *
+ * @param map The RCU treemap.
+ * @param k The key.
+ * @param v The value.
+ *
+ * @return It returns SUCCESS if the pair is stored, GENERIC_ERROR if the memory cannot be allocated.
+ */
+ds_result ds_rcu_treemap_put(ds_rcu_treemap* map, const void* k, const void* v);
+
+/**
+ * This function will remove the element whose key is provided as argument and publish the new version.
+ *
+ * @param map The RCU treemap.
+ * @param k The key.
+ *
+ * @return It returns SUCCESS if the element is removed (or does not exist), GENERIC_ERROR if the memory cannot be allocated
+ * (no new version is published).
+ */
+ds_result ds_rcu_treemap_remove(ds_rcu_treemap* map, const void* k);
+
+/**
+ * This function will release the replaced versions that no reader is using anymore. This is done
+ * by writers as well, it is useful to release memory when there are no more writes.
+ *
+ * @param map The RCU treemap.
+ *
+ * @return It returns the number of versions still waiting to be released.
+ */
+size_t ds_rcu_treemap_reclaim(ds_rcu_treemap* map);
+
+#endif
@@ -0,0 +1,365 @@
+/*
+ * @file splay.c
+ * @author Valerio Bellizia
+ */
+
+#include "splay.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// the offset of the element within the memory block of a node, it is kept aligned for any type
+#define NODE_INFO_ALIGN 16
+#define NODE_INFO_OFFSET (((sizeof(ds_splay_node) + NODE_INFO_ALIGN - 1) / NODE_INFO_ALIGN) * NODE_INFO_ALIGN)
+#define NODE_INFO(NODE) ((char*)(NODE) + NODE_INFO_OFFSET)
+
+// struct definitions
+
+struct ds_splay {
+	ds_splay_node* root;
+	ds_cmp cmp;
+	size_t elements;
+	size_t element_size;
+};
+
+struct ds_splay_node {
+	struct ds_splay_node* parent;
+	struct ds_splay_node* left;
+	struct ds_splay_node* right;
+};
+
+/*
+ * A splay tree has no balance condition, a path can be as long as the number of elements,
+ * so none of the following functions is recursive.
+ */
+
+static ds_splay_node* create_node(const void* element, const size_t size) {
+	ds_splay_node* node = (ds_splay_node*) malloc(NODE_INFO_OFFSET + size);
+	if (node != NULL) {
+		node->parent = NULL;
+		node->left = NULL;
+		node->right = NULL;
+		memcpy(NODE_INFO(node), element, size);
+	}
+
+	return node;
+}
+
+static void free_nodes(ds_splay_node* root) {
+	// children are detached while going down, so that a node is freed once it has no children left
+	ds_splay_node* n = root;
+	while (n != NULL) {
+		if (n->left != NULL) {
+			ds_splay_node* l = n->left;
+			n->left = NULL;
+			n = l;
+		}
+		else if (n->right != NULL) {
+			ds_splay_node* r = n->right;
+			n->right = NULL;
+			n = r;
+		}
+		else {
+			ds_splay_node* parent = n->parent;
+			free(n);
+			n = parent;
+		}
+	}
+}
+
+static ds_splay_node* get_max(ds_splay_node* n) {
+	if (n != NULL)
+		while (n->right != NULL)
+			n = n->right;
+
+	return n;
+}
+
+static ds_splay_node* get_min(ds_splay_node* n) {
+	if (n != NULL)
+		while (n->left != NULL)
+			n = n->left;
+
+	return n;
+}
+
+// it moves x one level up, above its parent
+static void rotate(ds_splay* t, ds_splay_node* x) {
+	ds_splay_node* p = x->parent;
+	ds_splay_node* g = p->parent;
+
+	if (x == p->left) {
+		p->left = x->right;
+		if (x->right != NULL)
+			x->right->parent = p;
+		x->right = p;
+	}
+	else {
+		p->right = x->left;
+		if (x->left != NULL)
+			x->left->parent = p;
+		x->left = p;
+	}
+
+	p->parent = x;
+	x->parent = g;
+	if (g == NULL)
+		t->root = x;
+	else if (g->left == p)
+		g->left = x;
+	else
+		g->right = x;
+}
+
+// it moves x to the root: zig-zig steps rotate the parent first, this is what halves the depth of the path
+static void splay(ds_splay* t, ds_splay_node* x) {
+	while (x->parent != NULL) {
+		ds_splay_node* p = x->parent;
+		ds_splay_node* g = p->parent;
+		if (g == NULL)
+			rotate(t, x);
+		else if ((x == p->left) == (p == g->left)) {
+			rotate(t, p);
+			rotate(t, x);
+		}
+		else {
+			rotate(t, x);
+			rotate(t, x);
+		}
+	}
+}
+
+// it returns the node holding element, NULL if it does not exist; last is the last node met by the search
+static ds_splay_node* find(ds_splay* t, const void* element, ds_splay_node** last) {
+	ds_splay_node* n = t->root;
+	*last = NULL;
+	while (n != NULL) {
+		*last = n;
+		int cmp_res = t->cmp(element, NODE_INFO(n));
+		if (cmp_res == 0)
+			return n;
+		n = (cmp_res < 0) ? n->left : n->right;
+	}
+
+	return NULL;
+}
+
+static ds_splay_node* in_order_successor(ds_splay_node* node) {
+	if (node->right != NULL)
+		return get_min(node->right);
+
+	ds_splay_node* n = node;
+	while (n->parent != NULL && n == n->parent->right)
+		n = n->parent;
+
+	return n->parent;
+}
+
+static ds_splay_node* in_order_predecessor(ds_splay_node* node) {
+	if (node->left != NULL)
+		return get_max(node->left);
+
+	ds_splay_node* n = node;
+	while (n->parent != NULL && n == n->parent->left)
+		n = n->parent;
+
+	return n->parent;
+}
+
+// Interface functions
+
+void ds_splay_iterator_next(ds_splay_iterator* it) {
+	it->current = in_order_successor(it->current);
+}
+
+void ds_splay_iterator_prev(ds_splay_iterator* it) {
+	it->current = in_order_predecessor(it->current);
+}
+
+int ds_splay_iterator_is_valid(ds_splay_iterator* it) {
+	return it->current != NULL;
+}
+
+const void* ds_splay_iterator_get(ds_splay_iterator* it) {
+	return NODE_INFO(it->current);
+}
+
+ds_splay* create_ds_splay(ds_cmp cmp_func, const size_t size) {
+	ds_splay* t = (ds_splay*) malloc(sizeof(ds_splay));
+	if (t == NULL)
+		return NULL;
+
+	t->root = NULL;
+	t->cmp = cmp_func;
+	t->elements = 0;
+	t->element_size = size;
+
+	return t;
+}
+
+void delete_ds_splay(ds_splay* t) {
+	if (t == NULL)
+		return;
+
+	free_nodes(t->root);
+	free(t);
+}
+
+ds_cmp ds_splay_cmp(ds_splay* t) {
+	return t->cmp;
+}
+
+size_t ds_splay_size(const ds_splay* t) {
+	return t->elements;
+}
+
+size_t ds_splay_element_size(const ds_splay* t) {
+	return t->element_size;
+}
+
+ds_result ds_splay_insert(ds_splay* t, const void* element) {
+	if (t == NULL || element == NULL)
+		return GENERIC_ERROR;
+
+	ds_splay_node* parent;
+	ds_splay_node* node = find(t, element, &parent);
+	if (node != NULL) {
+		splay(t, node);
+		return ELEMENT_ALREADY_EXISTS;
+	}
+
+	node = create_node(element, t->element_size);
+	if (node == NULL)
+		return GENERIC_ERROR;
+
+	node->parent = parent;
+	if (parent == NULL)
+		t->root = node;
+	else if (t->cmp(element, NODE_INFO(parent)) < 0)
+		parent->left = node;
+	else
+		parent->right = node;
+
+	splay(t, node);
+	t->elements++;
+
+	return SUCCESS;
+}
+
+ds_result ds_splay_remove(ds_splay* t, const void* element) {
+	if (t == NULL)
+		return GENERIC_ERROR;
+
+	if (element == NULL || t->root == NULL)
+		return SUCCESS;
+
+	ds_splay_node* last;
+	ds_splay_node* node = find(t, element, &last);
+	if (node == NULL) {
+		splay(t, last);
+		return SUCCESS;
+	}
+
+	splay(t, node);
+
+	// the maximum of the left subtree becomes the root of it, it has no right child and the right subtree goes there
+	ds_splay_node* l = node->left;
+	ds_splay_node* r = node->right;
+	if (l == NULL) {
+		t->root = r;
+		if (r != NULL)
+			r->parent = NULL;
+	}
+	else {
+		l->parent = NULL;
+		t->root = l;
+		splay(t, get_max(l));
+		t->root->right = r;
+		if (r != NULL)
+			r->parent = t->root;
+	}
+
+	free(node);
+	t->elements--;
+
+	return SUCCESS;
+}
+
+int ds_splay_search(ds_splay* t, const void* element) {
+	return ds_splay_get(t, element) != NULL;
+}
+
+const void* ds_splay_get(ds_splay* t, const void* element) {
+	if (t == NULL || element == NULL || t->root == NULL)
+		return NULL;
+
+	ds_splay_node* last;
+	ds_splay_node* node = find(t, element, &last);
+	splay(t, last);
+
+	return (node != NULL) ? NODE_INFO(node) : NULL;
+}
+
+const void* ds_splay_max(ds_splay* t) {
+	if (t == NULL || t->root == NULL)
+		return NULL;
+
+	return NODE_INFO(get_max(t->root));
+}
+
+const void* ds_splay_min(ds_splay* t) {
+	if (t == NULL || t->root == NULL)
+		return NULL;
+
+	return NODE_INFO(get_min(t->root));
+}
+
+ds_splay_iterator ds_splay_first(ds_splay* t) {
+	ds_splay_iterator it;
+	it.tree = t;
+	it.current = get_min(t->root);
+
+	return it;
+}
+
+ds_splay_iterator ds_splay_last(ds_splay* t) {
+	ds_splay_iterator it;
+	it.tree = t;
+	it.current = get_max(t->root);
+
+	return it;
+}
+
+ds_splay_iterator ds_splay_lower_bound(ds_splay* t, const void* element) {
+	ds_splay_iterator it;
+	it.tree = t;
+	it.current = NULL;
+
+	// looking for the first node that is not smaller than element
+	ds_splay_node* last = NULL;
+	ds_splay_node* n = t->root;
+	while (n != NULL) {
+		last = n;
+		if (t->cmp(element, NODE_INFO(n)) <= 0) {
+			it.current = n;
+			n = n->left;
+		}
+		else
+			n = n->right;
+	}
+
+	if (it.current != NULL)
+		splay(t, it.current);
+	else if (last != NULL)
+		splay(t, last);
+
+	return it;
+}
+
+void ds_splay_visit(ds_splay* t, void (*visit_func)(const void*, void*), void* other_args) {
+	if (t == NULL)
+		return;
+
+	for (ds_splay_iterator it = ds_splay_first(t); ds_splay_iterator_is_valid(&it); ds_splay_iterator_next(&it))
+		visit_func(ds_splay_iterator_get(&it), other_args);
+}
@@ -0,0 +1,237 @@
+/**
+ * @file splay.h
+ * @author Valerio Bellizia
+ *
+ * This file contains the interface to be used with ds_splay. It implements
+ * a self-adjusting binary search tree (a splay tree): every lookup moves the
+ * element it finds to the root, so elements that are accessed often stay close
+ * to the root. On skewed workloads (a few keys getting most of the hits) the hot
+ * elements are found with a handful of comparisons, while the cost of any sequence
+ * of operations stays O(log n) amortized per operation.
+ * The interface mirrors the one of ds_bst, but lookups change the shape of the tree.
+ */
+
+#ifndef splay_h
+#define splay_h
+
+#include "result.h"
+#include "defs.h"
+
+#include <stddef.h>
+
+/**
+ * This is an opaque structure that represents a splay tree.
+ */
+typedef struct ds_splay ds_splay;
+
+/**
+ * This is an opaque structure that represents a splay tree node.
+ */
+typedef struct ds_splay_node ds_splay_node;
+
+/**
+ * This is a structure that represents an iterator for a splay tree.
+ * Lookups move nodes around but never free them, so an iterator stays valid until
+ * the element it points to is removed.
+ */
+typedef struct ds_splay_iterator {
+	const ds_splay* tree;
+	ds_splay_node* current;
+} ds_splay_iterator;
+
+/**
+ * This function will move the iterator forward.
+ *
+ * @param it The iterator.
+ */
+void ds_splay_iterator_next(ds_splay_iterator* it);
+
+/**
+ * This function will move the iterator backward.
+ *
+ * @param it The iterator.
+ */
+void ds_splay_iterator_prev(ds_splay_iterator* it);
+
+/**
+ * This function can be used to check if the iterator is valid.
+ *
+ * @param it The iterator.
+ *
+ * @return it returns 1 if the iterator is valid, 0 otherwise.
+ */
+int ds_splay_iterator_is_valid(ds_splay_iterator* it);
+
+/**
+ * This function will get the element pointed by the iterator as const void*.
+ *
+ * @param it The iterator.
+ *
+ * @return The pointer to the element pointed by the iterator.
+ */
+const void* ds_splay_iterator_get(ds_splay_iterator* it);
+
+/**
+ * This function will get the typed pointer to the element pointed by the iterator.
+ *
+ * @param TYPE The type we want as output.
+ * @param IT The iterator.
+ *
+ * @return The pointer to the element stored into the tree casted to the given type.
+ */
+#define ds_splay_iterator_get_ptr(TYPE, IT) ((TYPE*)ds_splay_iterator_get(IT))
+
+/**
+ * This function will get the value of the element pointed by the iterator.
+ *
+ * @param TYPE The type we want as output.
+ * @param IT The iterator.
+ *
+ * @return The value to the element stored into the tree casted to the given type.
+ */
+#define ds_splay_iterator_get_value(TYPE, IT) (*(TYPE*)ds_splay_iterator_get(IT))
+
+/**
+ * This function will create an instance of ds_splay.
+ *
+ * @param cmp_func This is the pointer to a function that will be used to compare two elements.
+ * @param size It is the size of the element that the tree is supposed to store.
+ *
+ * @return It returns the pointer to a new instance of ds_splay.
+ */
+ds_splay* create_ds_splay(ds_cmp cmp_func, const size_t size);
+
+/**
+ * This function will release the memory used by the tree.
+ *
+ * @param t The splay tree.
+ */
+void delete_ds_splay(ds_splay* t);
+
+/**
+ * This function will return the comparison function.
+ *
+ * @param t The splay tree.
+ *
+ * @return It returns the comparison function.
+ */
+ds_cmp ds_splay_cmp(ds_splay* t);
+
+/**
+ * This function will return the number of elements stored in the tree.
+ *
+ * @param t The splay tree.
+ *
+ * @return The number of elements stored in the tree.
+ */
+size_t ds_splay_size(const ds_splay* t);
+
+/**
+ * This function will return the size of the elements stored in the tree.
+ *
+ * @param t The splay tree.
+ *
+ * @return The size of a single element.
+ */
+size_t ds_splay_element_size(const ds_splay* t);
+
+/**
+ * This function will insert an element into the tree, the new element becomes the root.
+ *
+ * @param t The splay tree.
+ * @param element The element.
+ *
+ * @return The result of the operation. It returns ELEMENT_ALREADY_EXISTS when inserting a duplicate.
+ */
+ds_result ds_splay_insert(ds_splay* t, const void* element);
+
+/**
+ * This function will remove an element from the tree if exists.
+ *
+ * @param t The splay tree.
+ * @param element The element.
+ *
+ * @return The result of the operation.
+ */
+ds_result ds_splay_remove(ds_splay* t, const void* element);
+
+/**
+ * This function will look for an element into the tree. The last element met by
+ * the search is moved to the root.
+ *
+ * @param t The splay tree.
+ * @param element The element.
+ *
+ * @return It returns 1 if the element exists, 0 otherwise.
+ */
+int ds_splay_search(ds_splay* t, const void* element);
+
+/**
+ * This function will look for an element into the tree, if exists it will
+ * return a pointer to the element, NULL otherwise. The last element met by
+ * the search is moved to the root.
+ *
+ * @param t The splay tree.
+ * @param element The element we are looking for.
+ *
+ * @return It returns a pointer to the element into the tree if such element exists, NULL otherwise.
+ */
+const void* ds_splay_get(ds_splay* t, const void* element);
+
+/**
+ * This function will return the maximum value into the tree. The tree is not changed.
+ *
+ * @param t The splay tree.
+ *
+ * @return The maximum value stored in the tree, NULL if it is empty.
+ */
+const void* ds_splay_max(ds_splay* t);
+
+/**
+ * This function will return the minimum value into the tree. The tree is not changed.
+ *
+ * @param t The splay tree.
+ *
+ * @return The minimum value stored in the tree, NULL if it is empty.
+ */
+const void* ds_splay_min(ds_splay* t);
+
+/**
+ * This function will return an iterator to the first (smallest) element of the tree.
+ *
+ * @param t The splay tree.
+ *
+ * @return The iterator to the smallest element of the tree.
+ */
+ds_splay_iterator ds_splay_first(ds_splay* t);
+
+/**
+ * This function will return an iterator to the last (biggest) element of the tree.
+ *
+ * @param t The splay tree.
+ *
+ * @return The iterator to the biggest element of the tree.
+ */
+ds_splay_iterator ds_splay_last(ds_splay* t);
+
+/**
+ * This function will return an iterator to the first element that is not less than the given one.
+ * The element found is moved to the root.
+ *
+ * @param t The splay tree.
+ * @param element The element.
+ *
+ * @return The iterator to the first element not less than element, it is not valid if such element does not exist.
+ */
+ds_splay_iterator ds_splay_lower_bound(ds_splay* t, const void* element);
+
+/**
+ * This function will visit all the elements of the tree in order. The tree is not changed.
+ *
+ * @param t The splay tree.
+ * @param visit_func The function that will be used to visit the elements. It is a function like func(const void*, void*) where the first argument is the pointer to the element, and the second is an optional argument that may be used with this function to pass data.
+ * @param other_args It is the second argument to pass visit_func.
+ */
+void ds_splay_visit(ds_splay* t, void (*visit_func)(const void*, void*), void* other_args);
+
+#endif
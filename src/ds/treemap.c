@@ -6,19 +6,64 @@
 #include "treemap.h"
 #include "bst.h"
 
+#include <limits.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(_WIN32)
+#include <io.h>
+#define read _read
+#define write _write
+#else
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define TREEMAP_HAS_MMAP
+#endif
+
 // ds_treemap struct definition...
 
+/*
+ * Every element stored in the underlying ds_bst is laid out as [key | padding | value | padding | ds_treemap_entry]:
+ * keys and values are owned by the map and stored inline in the node of the tree.
+ * Since the key sits at the beginning of the element, key_cmp can be used directly to compare elements,
+ * and a plain key can be used as a probe while looking for something in the tree.
+ * The entry points to the key and the value within the same element. ds_bst never moves an element
+ * once it has been inserted, so the entry is set once, right after the insertion.
+ */
 struct ds_treemap {
 	ds_bst* bst;
 	size_t num_el;
 	size_t key_len;
 	size_t value_len;
+	size_t value_offset;
+	size_t entry_offset;
 };
 
-ds_treemap* create_ds_treemap(ds_cmp key_cmp, size_t key_len, size_t value_len) {
+static size_t align_offset(size_t offset) {
+	size_t align = sizeof(void*);
+	return ((offset + align - 1) / align) * align;
+}
+
+static ds_treemap_entry* element_entry(const ds_treemap* map, const void* element) {
+	if (element == NULL)
+		return NULL;
+
+	return (ds_treemap_entry*)((char*)element + map->entry_offset);
+}
+
+// it points the entry of an element stored in the tree to the key and the value next to it
+static ds_treemap_entry* bind_entry(const ds_treemap* map, const void* element) {
+	ds_treemap_entry* entry = element_entry(map, element);
+	entry->key = (char*)element;
+	entry->value = (char*)element + map->value_offset;
+
+	return entry;
+}
+
+static ds_treemap* create_map(ds_cmp key_cmp, size_t key_len, size_t value_len, int multi) {
 	ds_treemap* map = (ds_treemap*) malloc(sizeof(ds_treemap));
 	if (map == NULL)
 		return map;
@@ -26,11 +71,24 @@ ds_treemap* create_ds_treemap(ds_cmp key_cmp, size_t key_len, size_t value_len)
 	map->num_el = 0;
 	map->key_len = key_len;
 	map->value_len = value_len;
-	map->bst = create_ds_bst(key_cmp, sizeof(ds_treemap_entry));
+	map->value_offset = align_offset(key_len);
+	map->entry_offset = align_offset(map->value_offset + value_len);
+	if (multi)
+		map->bst = create_ds_bst_multi(key_cmp, map->entry_offset + sizeof(ds_treemap_entry));
+	else
+		map->bst = create_ds_bst(key_cmp, map->entry_offset + sizeof(ds_treemap_entry));
 
 	return map;
 }
 
+ds_treemap* create_ds_treemap(ds_cmp key_cmp, size_t key_len, size_t value_len) {
+	return create_map(key_cmp, key_len, value_len, 0);
+}
+
+ds_treemap* create_ds_treemap_multi(ds_cmp key_cmp, size_t key_len, size_t value_len) {
+	return create_map(key_cmp, key_len, value_len, 1);
+}
+
 void delete_ds_treemap(ds_treemap* map) {
 	if (map == NULL)
 		return;
@@ -39,18 +97,130 @@ void delete_ds_treemap(ds_treemap* map) {
 	free(map);
 }
 
-ds_result ds_treemap_insert(ds_treemap* map, void* k, void* v) {
-	ds_treemap_entry entry;
-	entry.key = k;
-	entry.value = v;
+// elements up to this size are built on the stack before being copied into the tree
+#define STACK_ELEMENT_SIZE 256
+
+typedef union element_buffer {
+	char bytes[STACK_ELEMENT_SIZE];
+	void* align_ptr;
+	long long align_int;
+	double align_double;
+} element_buffer;
+
+// it returns a zero-filled element, it uses the buffer when it is big enough
+static char* alloc_element(const ds_treemap* map, element_buffer* buffer) {
+	size_t size = ds_bst_element_size(map->bst);
+	char* element = (size <= sizeof(element_buffer)) ? buffer->bytes : (char*) malloc(size);
+	if (element != NULL)
+		memset(element, 0, size);
+
+	return element;
+}
+
+// it builds the element holding the given key and value
+static char* build_element(const ds_treemap* map, element_buffer* buffer, const void* k, const void* v) {
+	char* element = alloc_element(map, buffer);
+	if (element == NULL)
+		return NULL;
+
+	memcpy(element, k, map->key_len);
+	if (v != NULL)
+		memcpy(element + map->value_offset, v, map->value_len);
+
+	return element;
+}
+
+static void release_element(element_buffer* buffer, char* element) {
+	if (element != buffer->bytes)
+		free(element);
+}
+
+// it returns the element holding the key, the value is zero-filled when it is inserted
+static char* get_or_insert(ds_treemap* map, const void* k, int* inserted) {
+	// a multimap would always add a new entry
+	if (ds_bst_is_multi(map->bst))
+		return NULL;
+
+	element_buffer buffer;
+	char* element = build_element(map, &buffer, k, NULL);
+	if (element == NULL)
+		return NULL;
+
+	char* stored = (char*) ds_bst_get_or_insert(map->bst, element, inserted);
+	release_element(&buffer, element);
+	if (stored != NULL && *inserted)
+		bind_entry(map, stored);
+
+	return stored;
+}
+
+ds_result ds_treemap_insert(ds_treemap* map, const void* k, const void* v) {
+	if (k == NULL)
+		return GENERIC_ERROR;
+
+	element_buffer buffer;
+	char* element = build_element(map, &buffer, k, v);
+	if (element == NULL)
+		return GENERIC_ERROR;
+
+	int inserted;
+	char* stored = (char*) ds_bst_get_or_insert(map->bst, element, &inserted);
+	release_element(&buffer, element);
+	if (stored == NULL)
+		return GENERIC_ERROR;
+	if (!inserted)
+		return ELEMENT_ALREADY_EXISTS;
+
+	bind_entry(map, stored);
+	return SUCCESS;
+}
+
+ds_result ds_treemap_put(ds_treemap* map, const void* k, const void* v) {
+	if (map == NULL || k == NULL)
+		return GENERIC_ERROR;
+
+	int inserted;
+	char* stored = get_or_insert(map, k, &inserted);
+	if (stored == NULL)
+		return GENERIC_ERROR;
+
+	if (v != NULL)
+		memcpy(stored + map->value_offset, v, map->value_len);
+	else
+		memset(stored + map->value_offset, 0, map->value_len);
+
+	return SUCCESS;
+}
+
+void* ds_treemap_get_or_insert(ds_treemap* map, const void* k, int* inserted) {
+	if (map == NULL || k == NULL)
+		return NULL;
+
+	int added;
+	char* stored = get_or_insert(map, k, &added);
+	if (inserted != NULL)
+		*inserted = added;
 
-	return ds_bst_insert(map->bst, &entry);
+	return (stored != NULL) ? stored + map->value_offset : NULL;
+}
+
+ds_result ds_treemap_compute(ds_treemap* map, const void* k, void (*compute_func)(const void*, void*, int, void*), void* other_args) {
+	if (map == NULL || k == NULL || compute_func == NULL)
+		return GENERIC_ERROR;
+
+	int inserted;
+	char* stored = get_or_insert(map, k, &inserted);
+	if (stored == NULL)
+		return GENERIC_ERROR;
+
+	compute_func(stored, stored + map->value_offset, !inserted, other_args);
+
+	return SUCCESS;
 }
 
 const ds_treemap_entry* ds_treemap_get(ds_treemap* map, void* k) {
-	ds_treemap_entry aux;
-	aux.key = k;
-	return (const ds_treemap_entry*) ds_bst_get(map->bst, &aux);
+	// the key is a valid probe as it is what key_cmp expects at the beginning of an element
+	return element_entry(map, ds_bst_get(map->bst, k));
 }
 
 int ds_treemap_search(ds_treemap* map, void* k) {
@@ -58,27 +228,74 @@ int ds_treemap_search(ds_treemap* map, void* k) {
 }
 
 ds_result ds_treemap_remove(ds_treemap* map, void* k) {
-	ds_treemap_entry aux;
-	aux.key = k;
+	return ds_bst_remove(map->bst, k);
+}
 
-	return ds_bst_remove(map->bst, &aux);
+ds_result ds_treemap_remove_all(ds_treemap* map, const void* k) {
+	return ds_bst_remove_all(map->bst, k);
 }
 
-static void visit_bst(const void* el, void* aux) {
-	ds_treemap_entry* entry = (ds_treemap_entry*) el;
-	ds_vect* vect = (ds_vect*) aux;
+void ds_treemap_erase(ds_treemap* map, ds_treemap_iterator* it) {
+	ds_bst_erase(map->bst, it);
+}
 
-	ds_vect_push_back(vect, entry->key);
+size_t ds_treemap_count(ds_treemap* map, const void* k) {
+	return ds_bst_count(map->bst, k);
 }
 
-ds_vect* ds_treemap_keys(ds_treemap* map) {
-	ds_vect* vect = create_ds_vect(ds_bst_cmp(map->bst), map->key_len);
+// it copies the part of every element starting at offset into a vector sized once for all the elements
+static ds_vect* export_elements(ds_treemap* map, ds_cmp cmp, size_t offset, size_t size) {
+	ds_vect* vect = create_ds_vect(cmp, size);
+	if (vect == NULL)
+		return NULL;
 
-	ds_bst_visit(map->bst, visit_bst, vect, DFS_IN_ORDER);
+	if (ds_vect_reserve(vect, ds_bst_size(map->bst)) != SUCCESS) {
+		delete_ds_vect(vect);
+		return NULL;
+	}
+
+	for (ds_bst_iterator it = ds_bst_first(map->bst); ds_bst_iterator_is_valid(&it); ds_bst_iterator_next(&it))
+		ds_vect_push_back(vect, (const char*) ds_bst_iterator_get(&it) + offset);
 
 	return vect;
 }
 
+ds_vect* ds_treemap_keys(ds_treemap* map) {
+	return export_elements(map, ds_bst_cmp(map->bst), 0, map->key_len);
+}
+
+ds_vect* ds_treemap_values_vect(ds_treemap* map, ds_cmp value_cmp) {
+	return export_elements(map, value_cmp, map->value_offset, map->value_len);
+}
+
+static ds_treemap_cursor create_cursor(ds_treemap* map, size_t offset) {
+	ds_treemap_cursor cursor;
+	cursor.it = ds_bst_first(map->bst);
+	cursor.offset = offset;
+
+	return cursor;
+}
+
+ds_treemap_cursor ds_treemap_values(ds_treemap* map) {
+	return create_cursor(map, map->value_offset);
+}
+
+ds_treemap_cursor ds_treemap_entries(ds_treemap* map) {
+	return create_cursor(map, map->entry_offset);
+}
+
+int ds_treemap_cursor_is_valid(ds_treemap_cursor* cursor) {
+	return ds_bst_iterator_is_valid(&cursor->it);
+}
+
+void ds_treemap_cursor_next(ds_treemap_cursor* cursor) {
+	ds_bst_iterator_next(&cursor->it);
+}
+
+const void* ds_treemap_cursor_get(ds_treemap_cursor* cursor) {
+	return (const char*) ds_bst_iterator_get(&cursor->it) + cursor->offset;
+}
+
 ds_treemap_iterator ds_treemap_first(ds_treemap* map) {
 	return ds_bst_first(map->bst);
 }
@@ -87,6 +304,95 @@ ds_treemap_iterator ds_treemap_last(ds_treemap* map) {
 	return ds_bst_last(map->bst);
 }
 
+ds_treemap_iterator ds_treemap_floor(ds_treemap* map, const void* k) {
+	return ds_bst_floor(map->bst, k);
+}
+
+ds_treemap_iterator ds_treemap_ceiling(ds_treemap* map, const void* k) {
+	return ds_bst_ceiling(map->bst, k);
+}
+
+ds_treemap_iterator ds_treemap_higher(ds_treemap* map, const void* k) {
+	return ds_bst_upper_bound(map->bst, k);
+}
+
+ds_treemap_iterator ds_treemap_lower(ds_treemap* map, const void* k) {
+	// the entry right before the first one that is not smaller than k
+	ds_treemap_iterator it = ds_bst_lower_bound(map->bst, k);
+	if (!ds_bst_iterator_is_valid(&it))
+		return ds_bst_last(map->bst);
+
+	ds_bst_iterator_prev(&it);
+	return it;
+}
+
+ds_treemap_range ds_treemap_range_of(ds_treemap* map, const void* lo, const void* hi) {
+	ds_treemap_range range;
+	range.begin = ds_bst_lower_bound(map->bst, lo);
+	range.end = ds_bst_lower_bound(map->bst, hi);
+
+	// an empty or reversed interval
+	if (ds_bst_cmp(map->bst)(lo, hi) >= 0)
+		range.begin = range.end;
+
+	return range;
+}
+
+ds_treemap_range ds_treemap_equal_range(ds_treemap* map, const void* k) {
+	ds_treemap_range range;
+	range.begin = ds_bst_lower_bound(map->bst, k);
+	range.end = ds_bst_upper_bound(map->bst, k);
+
+	return range;
+}
+
+ds_treemap_range ds_treemap_prefix(ds_treemap* map, const void* prefix, size_t prefix_len) {
+	ds_treemap_range range;
+	range.begin.bst = map->bst;
+	range.begin.current = NULL;
+	range.end = range.begin;
+	if (prefix_len > map->key_len)
+		return range;
+
+	// the keys starting with the prefix are within [prefix 00..00, prefix + 1 00..00)
+	element_buffer lo;
+	element_buffer hi;
+	char* lo_key = alloc_element(map, &lo);
+	char* hi_key = alloc_element(map, &hi);
+	if (lo_key != NULL && hi_key != NULL) {
+		memcpy(lo_key, prefix, prefix_len);
+		memcpy(hi_key, prefix, prefix_len);
+
+		size_t i = prefix_len;
+		while (i > 0 && (unsigned char) hi_key[i - 1] == 0xFF)
+			hi_key[--i] = 0;
+
+		range.begin = ds_bst_lower_bound(map->bst, lo_key);
+		// if the prefix is made of 0xFF bytes only, the range goes up to the last entry
+		if (i > 0) {
+			hi_key[i - 1]++;
+			range.end = ds_bst_lower_bound(map->bst, hi_key);
+		}
+	}
+
+	release_element(&lo, lo_key);
+	release_element(&hi, hi_key);
+
+	return range;
+}
+
+int ds_treemap_range_is_valid(ds_treemap_range* range) {
+	return ds_bst_iterator_is_valid(&range->begin) && range->begin.current != range->end.current;
+}
+
+void ds_treemap_range_next(ds_treemap_range* range) {
+	ds_bst_iterator_next(&range->begin);
+}
+
+const ds_treemap_entry* ds_treemap_range_get(ds_treemap_range* range) {
+	return ds_treemap_iterator_get(&range->begin);
+}
+
 void ds_treemap_iterator_next(ds_treemap_iterator* it) {
 	ds_bst_iterator_next(it);
 }
@@ -100,9 +406,268 @@ int ds_treemap_iterator_is_valid(ds_treemap_iterator* it) {
 }
 
 const ds_treemap_entry* ds_treemap_iterator_get(ds_treemap_iterator* it) {
-	return (const ds_treemap_entry*)ds_bst_iterator_get(it);
+	// the entry is the last thing in the element, the iterator knows only the tree
+	const char* element = (const char*) ds_bst_iterator_get(it);
+	return (const ds_treemap_entry*)(element + ds_bst_element_size(it->bst) - sizeof(ds_treemap_entry));
 }
 
 size_t ds_treemap_size(ds_treemap* map) {
 	return ds_bst_size(map->bst);
-}
\ No newline at end of file
+}
+
+size_t ds_treemap_rank(ds_treemap* map, void* k) {
+	return ds_bst_rank(map->bst, k);
+}
+
+const ds_treemap_entry* ds_treemap_select(ds_treemap* map, size_t k) {
+	return element_entry(map, ds_bst_select(map->bst, k));
+}
+
+size_t ds_treemap_count_range(ds_treemap* map, void* lo, void* hi) {
+	return ds_bst_count_range(map->bst, lo, hi);
+}
+// snapshot files
+
+#define SNAPSHOT_MAGIC "DSTM"
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_BYTE_ORDER 0x01020304
+#define SNAPSHOT_WRITE_BUFFER 65536
+#define SNAPSHOT_FLAG_MULTI 0x1
+
+/*
+ * A snapshot is a header followed by count records laid out as [key | value], sorted by key.
+ * flags tells if the map was a multimap, whose records may share a key. Numbers are stored in the byte order of the machine that wrote the file, byte_order tells
+ * if the file can be read on the current machine.
+ */
+typedef struct snapshot_header {
+	char magic[4];
+	uint32_t byte_order;
+	uint32_t version;
+	uint32_t flags;
+	uint64_t key_len;
+	uint64_t value_len;
+	uint64_t count;
+} snapshot_header;
+
+// a single read or write moves at most CHUNK_MAX bytes, since the length is an unsigned int on Windows
+#define CHUNK_MAX ((size_t) INT_MAX)
+
+static int write_all(int fd, const char* data, size_t size) {
+	while (size > 0) {
+		long written = (long) write(fd, data, (unsigned int) ((size > CHUNK_MAX) ? CHUNK_MAX : size));
+		if (written < 0) {
+#ifndef _WIN32
+			if (errno == EINTR)
+				continue;
+#endif
+			return 0;
+		}
+
+		data += written;
+		size -= (size_t) written;
+	}
+
+	return 1;
+}
+
+static int read_all(int fd, char* data, size_t size) {
+	while (size > 0) {
+		long got = (long) read(fd, data, (unsigned int) ((size > CHUNK_MAX) ? CHUNK_MAX : size));
+		if (got < 0) {
+#ifndef _WIN32
+			if (errno == EINTR)
+				continue;
+#endif
+			return 0;
+		}
+		if (got == 0)
+			return 0;
+
+		data += got;
+		size -= (size_t) got;
+	}
+
+	return 1;
+}
+
+ds_result ds_treemap_save(ds_treemap* map, int fd) {
+	if (map == NULL)
+		return GENERIC_ERROR;
+
+	snapshot_header header;
+	memset(&header, 0, sizeof(snapshot_header));
+	memcpy(header.magic, SNAPSHOT_MAGIC, 4);
+	header.byte_order = SNAPSHOT_BYTE_ORDER;
+	header.version = SNAPSHOT_VERSION;
+	header.key_len = map->key_len;
+	header.value_len = map->value_len;
+	header.count = ds_bst_size(map->bst);
+	header.flags = ds_bst_is_multi(map->bst) ? SNAPSHOT_FLAG_MULTI : 0;
+
+	if (!write_all(fd, (const char*) &header, sizeof(snapshot_header)))
+		return GENERIC_ERROR;
+
+	// records are packed into a buffer, so that there is a write every few thousands of them
+	size_t record_size = map->key_len + map->value_len;
+	size_t buffer_size = (record_size > SNAPSHOT_WRITE_BUFFER) ? record_size : SNAPSHOT_WRITE_BUFFER;
+	char* buffer = (char*) malloc(buffer_size);
+	if (buffer == NULL)
+		return GENERIC_ERROR;
+
+	size_t used = 0;
+	int ok = 1;
+	for (ds_bst_iterator it = ds_bst_first(map->bst); ok && ds_bst_iterator_is_valid(&it); ds_bst_iterator_next(&it)) {
+		if (used + record_size > buffer_size) {
+			ok = write_all(fd, buffer, used);
+			used = 0;
+		}
+
+		const char* element = (const char*) ds_bst_iterator_get(&it);
+		memcpy(buffer + used, element, map->key_len);
+		memcpy(buffer + used + map->key_len, element + map->value_offset, map->value_len);
+		used += record_size;
+	}
+
+	if (ok && used > 0)
+		ok = write_all(fd, buffer, used);
+	free(buffer);
+
+	return ok ? SUCCESS : GENERIC_ERROR;
+}
+
+struct snapshot_reader {
+	const ds_treemap* map;
+	const char* records;
+	char* element;
+};
+
+// it turns the i-th record into an element of the tree, the padding and the entry stay zero-filled
+static const void* snapshot_element_at(size_t i, void* other_args) {
+	struct snapshot_reader* reader = (struct snapshot_reader*) other_args;
+	const ds_treemap* map = reader->map;
+	const char* record = reader->records + i * (map->key_len + map->value_len);
+
+	memcpy(reader->element, record, map->key_len);
+	memcpy(reader->element + map->value_offset, record + map->key_len, map->value_len);
+
+	return reader->element;
+}
+
+// keys are copied before being compared, records are packed and may not be aligned; equal keys are allowed only in a multimap
+static int snapshot_is_sorted(ds_cmp key_cmp, const char* records, size_t count, size_t key_len, size_t record_size, int multi) {
+	if (count < 2)
+		return 1;
+
+	char* keys = (char*) malloc(2 * align_offset(key_len));
+	if (keys == NULL)
+		return 0;
+
+	char* previous = keys;
+	char* current = keys + align_offset(key_len);
+	memcpy(previous, records, key_len);
+
+	int sorted = 1;
+	for (size_t i = 1; sorted && i < count; ++i) {
+		memcpy(current, records + i * record_size, key_len);
+		int cmp_res = key_cmp(previous, current);
+		sorted = cmp_res < 0 || (cmp_res == 0 && multi);
+
+		char* aux = previous;
+		previous = current;
+		current = aux;
+	}
+
+	free(keys);
+	return sorted;
+}
+
+static ds_treemap* build_from_records(ds_cmp key_cmp, const snapshot_header* header, const char* records) {
+	int multi = (header->flags & SNAPSHOT_FLAG_MULTI) != 0;
+	size_t record_size = (size_t) (header->key_len + header->value_len);
+	if (!snapshot_is_sorted(key_cmp, records, (size_t) header->count, (size_t) header->key_len, record_size, multi))
+		return NULL;
+
+	ds_treemap* map = create_map(key_cmp, (size_t) header->key_len, (size_t) header->value_len, multi);
+	if (map == NULL || map->bst == NULL) {
+		delete_ds_treemap(map);
+		return NULL;
+	}
+
+	struct snapshot_reader reader;
+	reader.map = map;
+	reader.records = records;
+	reader.element = (char*) calloc(1, ds_bst_element_size(map->bst));
+	if (reader.element == NULL) {
+		delete_ds_treemap(map);
+		return NULL;
+	}
+
+	// records are already sorted, so the tree is built in O(n) instead of inserting them one by one
+	ds_bst* bst;
+	if (multi)
+		bst = ds_bst_build_sorted_multi_from(key_cmp, ds_bst_element_size(map->bst), (size_t) header->count, snapshot_element_at, &reader);
+	else
+		bst = ds_bst_build_sorted_from(key_cmp, ds_bst_element_size(map->bst), (size_t) header->count, snapshot_element_at, &reader);
+	free(reader.element);
+	if (bst == NULL) {
+		delete_ds_treemap(map);
+		return NULL;
+	}
+
+	delete_ds_bst(map->bst);
+	map->bst = bst;
+	for (ds_bst_iterator it = ds_bst_first(bst); ds_bst_iterator_is_valid(&it); ds_bst_iterator_next(&it))
+		bind_entry(map, ds_bst_iterator_get(&it));
+
+	return map;
+}
+
+ds_treemap* ds_treemap_load(int fd, ds_cmp key_cmp) {
+	snapshot_header header;
+	if (key_cmp == NULL || !read_all(fd, (char*) &header, sizeof(snapshot_header)))
+		return NULL;
+
+	if (memcmp(header.magic, SNAPSHOT_MAGIC, 4) != 0 || header.byte_order != SNAPSHOT_BYTE_ORDER || header.version != SNAPSHOT_VERSION)
+		return NULL;
+	if ((header.flags & ~SNAPSHOT_FLAG_MULTI) != 0)
+		return NULL;
+
+	uint64_t record_size = header.key_len + header.value_len;
+	if (header.key_len == 0 || header.key_len > SIZE_MAX || header.value_len > SIZE_MAX || record_size < header.key_len)
+		return NULL;
+	if (header.count > 0 && record_size > SIZE_MAX / header.count)
+		return NULL;
+	size_t data_size = (size_t) (record_size * header.count);
+
+	ds_treemap* map = NULL;
+	int loaded = 0;
+
+#ifdef TREEMAP_HAS_MMAP
+	// regular files are mapped, the mapping starts at the beginning of the file as offsets must be page aligned
+	off_t pos = lseek(fd, 0, SEEK_CUR);
+	struct stat st;
+	if (data_size > 0 && pos >= 0 && fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && (uint64_t) (st.st_size - pos) >= data_size) {
+		size_t mapping_size = (size_t) pos + data_size;
+		void* mapping = mmap(NULL, mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapping != MAP_FAILED) {
+			madvise(mapping, mapping_size, MADV_WILLNEED);
+			map = build_from_records(key_cmp, &header, (const char*) mapping + pos);
+			munmap(mapping, mapping_size);
+			lseek(fd, pos + (off_t) data_size, SEEK_SET);
+			loaded = 1;
+		}
+	}
+#endif
+
+	if (!loaded) {
+		char* records = (char*) malloc(data_size > 0 ? data_size : 1);
+		if (records == NULL)
+			return NULL;
+
+		if (read_all(fd, records, data_size))
+			map = build_from_records(key_cmp, &header, records);
+		free(records);
+	}
+
+	return map;
+}
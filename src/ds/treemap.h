@@ -5,6 +5,7 @@
  * This file contains the interface to be used with ds_treemap. It implements 
  * a treemap using a ds_bst as base. It is basically a map, therefore the structure
  * contains <key, value> pairs sorted by key.
+ * Keys and values are copied into the map, they are stored next to each other in the nodes of the tree.
  */
 
 #ifndef treemap_h
@@ -13,6 +14,7 @@
 #include "result.h"
 #include "defs.h"
 #include "vect.h"
+#include "bst.h"
 
 #include <stddef.h>
 
@@ -23,6 +25,7 @@ typedef struct ds_treemap ds_treemap;
 
 /**
  * This structure represents an entry of the treemap. This is basically a <key, value> pair.
+ * Both pointers refer to the copies owned by the map, they are valid until the entry is removed.
  */
 typedef struct ds_treemap_entry {
 	void* key;
@@ -34,6 +37,25 @@ typedef struct ds_treemap_entry {
  */
 typedef struct ds_bst_iterator ds_treemap_iterator;
 
+/**
+ * This structure represents a range of entries of the treemap, walked in key order.
+ * The range starts from begin and stops right before end (end is not valid when the range goes up to the last entry).
+ * A range stays valid as long as its entries are not removed.
+ */
+typedef struct ds_treemap_range {
+	ds_treemap_iterator begin;
+	ds_treemap_iterator end;
+} ds_treemap_range;
+
+/**
+ * This structure represents a cursor that walks the values or the entries of the map in key order,
+ * without allocating anything. A cursor stays valid as long as its current entry is not removed.
+ */
+typedef struct ds_treemap_cursor {
+	ds_treemap_iterator it;
+	size_t offset;
+} ds_treemap_cursor;
+
 /**
  * This function will move the iterator forward.
  * 
@@ -77,6 +99,20 @@ const ds_treemap_entry* ds_treemap_iterator_get(ds_treemap_iterator* it);
  */
 ds_treemap* create_ds_treemap(ds_cmp key_cmp, size_t key_len, size_t value_len);
 
+/**
+ * This function will create a treemap instance that accepts many entries with the same key (a multimap).
+ * Entries with the same key are kept in insertion order: ds_treemap_insert always adds a new entry, while
+ * ds_treemap_get and ds_treemap_remove work on the first one. ds_treemap_put, ds_treemap_get_or_insert and
+ * ds_treemap_compute need unique keys, they fail on a multimap.
+ * 
+ * @param key_cmp This is the key comparison function.
+ * @param key_len This is the length of the key type.
+ * @param value_len This is the length of the value type.
+ * 
+ * @return It returns the pointer to a new instance of ds_treemap.
+ */
+ds_treemap* create_ds_treemap_multi(ds_cmp key_cmp, size_t key_len, size_t value_len);
+
 /**
  * This function will release the memory of the treemap instance passed as argument.
  * 
@@ -85,15 +121,52 @@ ds_treemap* create_ds_treemap(ds_cmp key_cmp, size_t key_len, size_t value_len);
 void delete_ds_treemap(ds_treemap* map);
 
 /**
- * This function will insert a <key, value> pair in the map.
+ * This function will insert a <key, value> pair in the map. Both the key and the value are copied.
  * 
  * @param map The treemap.
  * @param k The key.
- * @param v The value.
+ * @param v The value, if NULL the value is zero-filled.
  * 
  * @return It returns SUCCESS if the element is inserted properly. It returns ELEMENT_ALREADY_EXISTS when adding an element whose key already exists.
  */
-ds_result ds_treemap_insert(ds_treemap* map, void* k, void* v);
+ds_result ds_treemap_insert(ds_treemap* map, const void* k, const void* v);
+
+/**
+ * This function will insert a <key, value> pair in the map, or overwrite the value if the key already exists.
+ * The tree is walked only once.
+ * 
+ * @param map The treemap.
+ * @param k The key.
+ * @param v The value, if NULL the value is zero-filled.
+ * 
+ * @return It returns SUCCESS if the pair is stored, GENERIC_ERROR if the memory cannot be allocated.
+ */
+ds_result ds_treemap_put(ds_treemap* map, const void* k, const void* v);
+
+/**
+ * This function will return the value associated to a key, inserting the key with a zero-filled value if it
+ * does not exist. The tree is walked only once, and the value can be changed in place (e.g. to update a counter).
+ * 
+ * @param map The treemap.
+ * @param k The key.
+ * @param inserted If not NULL, it is set to 1 if the key has been inserted, 0 if it already existed.
+ * 
+ * @return It returns a pointer to the value owned by the map, NULL if the memory cannot be allocated.
+ */
+void* ds_treemap_get_or_insert(ds_treemap* map, const void* k, int* inserted);
+
+/**
+ * This function will compute the value associated to a key in place, inserting the key with a zero-filled value
+ * if it does not exist. The tree is walked only once.
+ * 
+ * @param map The treemap.
+ * @param k The key.
+ * @param compute_func The function that updates the value. It is a function like func(const void*, void*, int, void*) where the first argument is the key, the second is the value to update, the third is 1 if the key already existed (0 if the value has just been zero-filled) and the last one is other_args.
+ * @param other_args It is the last argument to pass compute_func.
+ * 
+ * @return It returns SUCCESS if the value is computed, GENERIC_ERROR if the memory cannot be allocated.
+ */
+ds_result ds_treemap_compute(ds_treemap* map, const void* k, void (*compute_func)(const void*, void*, int, void*), void* other_args);
 
 /**
  * This function will look for a key in the map.
@@ -123,6 +196,105 @@ ds_treemap_iterator ds_treemap_first(ds_treemap* map);
  */
 ds_treemap_iterator ds_treemap_last(ds_treemap* map);
 
+/**
+ * This function will return an iterator to the entry with the greatest key less than or equal to the given one.
+ * 
+ * @param map The treemap.
+ * @param k The key.
+ * 
+ * @return The iterator to the entry, it is not valid if such entry does not exist.
+ */
+ds_treemap_iterator ds_treemap_floor(ds_treemap* map, const void* k);
+
+/**
+ * This function will return an iterator to the entry with the smallest key greater than or equal to the given one.
+ * 
+ * @param map The treemap.
+ * @param k The key.
+ * 
+ * @return The iterator to the entry, it is not valid if such entry does not exist.
+ */
+ds_treemap_iterator ds_treemap_ceiling(ds_treemap* map, const void* k);
+
+/**
+ * This function will return an iterator to the entry with the smallest key strictly greater than the given one.
+ * 
+ * @param map The treemap.
+ * @param k The key.
+ * 
+ * @return The iterator to the entry, it is not valid if such entry does not exist.
+ */
+ds_treemap_iterator ds_treemap_higher(ds_treemap* map, const void* k);
+
+/**
+ * This function will return an iterator to the entry with the greatest key strictly less than the given one.
+ * 
+ * @param map The treemap.
+ * @param k The key.
+ * 
+ * @return The iterator to the entry, it is not valid if such entry does not exist.
+ */
+ds_treemap_iterator ds_treemap_lower(ds_treemap* map, const void* k);
+
+/**
+ * This function will return the range of the entries whose keys fall within [lo, hi). It takes O(log n),
+ * the entries are not copied.
+ * 
+ * @param map The treemap.
+ * @param lo The lower bound of the range (included).
+ * @param hi The upper bound of the range (excluded).
+ * 
+ * @return It returns the range of the entries.
+ */
+ds_treemap_range ds_treemap_range_of(ds_treemap* map, const void* lo, const void* hi);
+
+/**
+ * This function will return the range of the entries whose keys start with the given bytes. It works
+ * for maps whose keys are ordered as byte strings of key_len bytes (e.g. by memcmp, or by strcmp on char arrays).
+ * 
+ * @param map The treemap.
+ * @param prefix The prefix.
+ * @param prefix_len The length of the prefix, it cannot be bigger than key_len.
+ * 
+ * @return It returns the range of the entries, it is empty if prefix_len is bigger than key_len.
+ */
+ds_treemap_range ds_treemap_prefix(ds_treemap* map, const void* prefix, size_t prefix_len);
+
+/**
+ * This function will return the range of the entries whose key is equal to k, in insertion order on a multimap.
+ * 
+ * @param map The treemap.
+ * @param k The key.
+ * 
+ * @return It returns the range of the entries with key k, it is empty if the key does not exist.
+ */
+ds_treemap_range ds_treemap_equal_range(ds_treemap* map, const void* k);
+
+/**
+ * This function can be used to check if a range still has entries to walk.
+ * 
+ * @param range The range.
+ * 
+ * @return it returns 1 if the range has entries left, 0 otherwise.
+ */
+int ds_treemap_range_is_valid(ds_treemap_range* range);
+
+/**
+ * This function will move the range to its next entry.
+ * 
+ * @param range The range.
+ */
+void ds_treemap_range_next(ds_treemap_range* range);
+
+/**
+ * This function will get the current entry of the range.
+ * 
+ * @param range The range.
+ * 
+ * @return The pointer to the current entry.
+ */
+const ds_treemap_entry* ds_treemap_range_get(ds_treemap_range* range);
+
 /**
  * This function will get an element on the map based on its key.
  * 
@@ -134,7 +306,7 @@ ds_treemap_iterator ds_treemap_last(ds_treemap* map);
 const ds_treemap_entry* ds_treemap_get(ds_treemap* map, void* k);
 
 /**
- * This function will remove an element whose key is provided as argument.
+ * This function will remove an element whose key is provided as argument. On a multimap the first entry with the key is removed.
  * 
  * @param map The treemap.
  * @param k The key.
@@ -144,7 +316,37 @@ const ds_treemap_entry* ds_treemap_get(ds_treemap* map, void* k);
 ds_result ds_treemap_remove(ds_treemap* map, void* k);
 
 /**
- * This function will return a vector filled with keys in the map.
+ * This function will remove all the entries whose key is provided as argument, in O(log n + k) where k is
+ * the number of removed entries.
+ * 
+ * @param map The treemap.
+ * @param k The key.
+ * 
+ * @return It returns SUCCESS if the entries are removed (or do not exist).
+ */
+ds_result ds_treemap_remove_all(ds_treemap* map, const void* k);
+
+/**
+ * This function will remove the entry pointed by the iterator, which is moved to the next entry.
+ * 
+ * @param map The treemap.
+ * @param it The iterator.
+ */
+void ds_treemap_erase(ds_treemap* map, ds_treemap_iterator* it);
+
+/**
+ * This function will count the entries whose key is equal to k in O(log n).
+ * 
+ * @param map The treemap.
+ * @param k The key.
+ * 
+ * @return It returns the number of entries with key k.
+ */
+size_t ds_treemap_count(ds_treemap* map, const void* k);
+
+/**
+ * This function will return a vector filled with keys in the map, in key order.
+ * The vector is sized once to hold all the keys.
  * 
  * @param map The treemap.
  * 
@@ -152,6 +354,60 @@ ds_result ds_treemap_remove(ds_treemap* map, void* k);
  */
 ds_vect* ds_treemap_keys(ds_treemap* map);
 
+/**
+ * This function will return a vector filled with the values in the map, in key order.
+ * The vector is sized once to hold all the values.
+ * 
+ * @param map The treemap.
+ * @param value_cmp The comparison function of the vector, it is used to look for values (e.g. by ds_vect_exists).
+ * 
+ * @return It returns a ds_vect with all the values in the map.
+ */
+ds_vect* ds_treemap_values_vect(ds_treemap* map, ds_cmp value_cmp);
+
+/**
+ * This function will return a cursor on the values of the map, starting from the one with the smallest key.
+ * 
+ * @param map The treemap.
+ * 
+ * @return It returns a cursor whose elements are the values of the map.
+ */
+ds_treemap_cursor ds_treemap_values(ds_treemap* map);
+
+/**
+ * This function will return a cursor on the entries of the map, starting from the one with the smallest key.
+ * 
+ * @param map The treemap.
+ * 
+ * @return It returns a cursor whose elements are the ds_treemap_entry of the map.
+ */
+ds_treemap_cursor ds_treemap_entries(ds_treemap* map);
+
+/**
+ * This function can be used to check if the cursor is valid.
+ * 
+ * @param cursor The cursor.
+ * 
+ * @return it returns 1 if the cursor is valid, 0 otherwise.
+ */
+int ds_treemap_cursor_is_valid(ds_treemap_cursor* cursor);
+
+/**
+ * This function will move the cursor forward.
+ * 
+ * @param cursor The cursor.
+ */
+void ds_treemap_cursor_next(ds_treemap_cursor* cursor);
+
+/**
+ * This function will get the element pointed by the cursor: a value or a ds_treemap_entry, depending on how the cursor has been created.
+ * 
+ * @param cursor The cursor.
+ * 
+ * @return The pointer to the element pointed by the cursor.
+ */
+const void* ds_treemap_cursor_get(ds_treemap_cursor* cursor);
+
 /**
  * This function will return the number of elements in the map.
  * 
@@ -161,4 +417,60 @@ ds_vect* ds_treemap_keys(ds_treemap* map);
  */
 size_t ds_treemap_size(ds_treemap* map);
 
+/**
+ * This function will return the rank of a key, i.e. the number of keys in the map that are smaller than the given one.
+ * The key does not need to be in the map. It takes O(log n).
+ * 
+ * @param map The treemap.
+ * @param k The key.
+ * 
+ * @return It returns the number of keys smaller than k.
+ */
+size_t ds_treemap_rank(ds_treemap* map, void* k);
+
+/**
+ * This function will return the entry with the k-th smallest key (k starts from 0).
+ * 
+ * @param map The treemap.
+ * @param k The position of the entry in key order.
+ * 
+ * @return The ds_treemap_entry pointer to the k-th entry, NULL if k is not smaller than the size of the map.
+ */
+const ds_treemap_entry* ds_treemap_select(ds_treemap* map, size_t k);
+
+/**
+ * This function will count the entries whose keys fall within the range [lo, hi).
+ * 
+ * @param map The treemap.
+ * @param lo The lower bound of the range (included).
+ * @param hi The upper bound of the range (excluded).
+ * 
+ * @return It returns the number of keys k such that lo <= k < hi.
+ */
+size_t ds_treemap_count_range(ds_treemap* map, void* lo, void* hi);
+
+/**
+ * This function will write the map to a file descriptor, starting from its current position. The snapshot
+ * is made of a header (carrying a version, key_len, value_len, the number of entries and whether the map is a
+ * multimap) followed by the <key, value> pairs sorted by key. Numbers are written in the byte order of the machine.
+ * 
+ * @param map The treemap.
+ * @param fd The file descriptor, it must be open for writing.
+ * 
+ * @return It returns SUCCESS if the snapshot is written, GENERIC_ERROR otherwise.
+ */
+ds_result ds_treemap_save(ds_treemap* map, int fd);
+
+/**
+ * This function will read a snapshot written by ds_treemap_save, starting from the current position of the
+ * file descriptor. The entries are already sorted, so the map is built in O(n). Regular files are mapped in
+ * memory (where mmap is available) instead of being read. A snapshot of a multimap is loaded as a multimap.
+ * 
+ * @param fd The file descriptor, it must be open for reading.
+ * @param key_cmp This is the key comparison function, it must order keys as the map that has been saved.
+ * 
+ * @return It returns a new instance of ds_treemap, NULL if the snapshot is not valid (or not sorted according to key_cmp) or if the memory cannot be allocated.
+ */
+ds_treemap* ds_treemap_load(int fd, ds_cmp key_cmp);
+
 #endif
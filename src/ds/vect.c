@@ -4,7 +4,9 @@
  */
 
 #include "vect.h"
+#include "cmp.h"
 
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -23,6 +25,7 @@ struct ds_vect {
 	size_t element_size;
 
 	ds_cmp compare;
+	ds_cmp_kind compare_kind;
 };
 
 // Some helpers
@@ -92,6 +95,7 @@ ds_vect* create_ds_vect(ds_cmp func, const size_t element_size) {
 		v->size = 0;
 		v->factor = LOAD_FACTOR;
 		v->compare = func;
+		v->compare_kind = ds_cmp_kind_of(func, element_size);
 		v->element_size = element_size;
 
 		v->store = malloc(v->capacity * element_size);
@@ -111,7 +115,39 @@ void delete_ds_vect(ds_vect* this) {
 	free(this);
 }
 
+// it scans the store comparing the values in place, it gives the same results of the library comparison functions
+#define EXISTS_VALUE(TYPE, THIS, ELEMENT) { \
+	TYPE key; \
+	memcpy(&key, ELEMENT, sizeof(TYPE)); \
+	for (size_t i = 0; i < THIS->size; ++i) { \
+		TYPE value; \
+		memcpy(&value, VECT_AT(THIS, i), sizeof(TYPE)); \
+		if (!(value < key) && !(value > key)) \
+			return 1; \
+	} \
+	return 0; \
+}
+
 int ds_vect_exists(const ds_vect* this, const void* element) {
+	switch (this->compare_kind) {
+	case DS_CMP_INT32:
+		EXISTS_VALUE(int32_t, this, element)
+	case DS_CMP_INT64:
+		EXISTS_VALUE(int64_t, this, element)
+	case DS_CMP_UINT64:
+		EXISTS_VALUE(uint64_t, this, element)
+	case DS_CMP_DOUBLE:
+		EXISTS_VALUE(double, this, element)
+	case DS_CMP_CSTR:
+		for (size_t i = 0; i < this->size; ++i) {
+			if (strcmp(*(const char* const*) (VECT_AT(this, i)), *(const char* const*) element) == 0)
+				return 1;
+		}
+		return 0;
+	default:
+		break;
+	}
+
 	for (size_t i = 0; i < this->size; ++i) {
 		if (this->compare(VECT_AT(this, i), element) == 0)
 			return 1;
@@ -143,10 +179,28 @@ ds_result ds_vect_push_back(ds_vect* this, const void* element) {
 	return SUCCESS;
 }
 
+ds_result ds_vect_reserve(ds_vect* this, const size_t capacity) {
+	if (capacity <= this->capacity)
+		return SUCCESS;
+
+	char* data = realloc(this->store, capacity * this->element_size);
+	if (data == NULL)
+		return GENERIC_ERROR;
+
+	this->store = data;
+	this->capacity = capacity;
+
+	return SUCCESS;
+}
+
 size_t ds_vect_length(const ds_vect* this) {
 	return this->size;
 }
 
+size_t ds_vect_element_size(const ds_vect* this) {
+	return this->element_size;
+}
+
 ds_result ds_vect_set(ds_vect* this, const void* element, const size_t pos) {
 	if (pos >= this->size)
 		return OUT_OF_BOUND;
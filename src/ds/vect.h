@@ -111,6 +111,15 @@ void delete_ds_vect(ds_vect* v);
  */
 size_t ds_vect_length(const ds_vect* v);
 
+/**
+ * This function will return the size of the elements stored in the vector.
+ *
+ * @param v The vector.
+ * 
+ * @return the size of a single element, as given when the vector has been created.
+ */
+size_t ds_vect_element_size(const ds_vect* v);
+
 /**
  * This function returns an iterator to the element in the given position.
  *
@@ -160,6 +169,17 @@ int ds_vect_exists(const ds_vect* v, const void* element);
  */
 ds_result ds_vect_push_back(ds_vect* v, const void* element);
 
+/**
+ * This function will make room for at least capacity elements, so that adding elements up to
+ * that number does not need any further allocation.
+ *
+ * @param v The vector.
+ * @param capacity The number of elements the vector should be able to hold.
+ * 
+ * @return It returns SUCCESS if the memory is allocated (or it was already there), GENERIC_ERROR otherwise.
+ */
+ds_result ds_vect_reserve(ds_vect* v, const size_t capacity);
+
 /**
  * This function will remove the element from a given position (if the position is valid).
  * All the elements that follow, will be shifted by one position if the position is valid.
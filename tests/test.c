@@ -8,6 +8,16 @@
 #include "test_list.h"
 #include "test_vector.h"
 #include "test_bin_tree.h"
+#include "test_frozen_bst.h"
+#include "test_splay.h"
+#include "test_treemap.h"
+#include "test_btree.h"
+#include "test_pbst.h"
+#include "test_rcu_treemap.h"
+#include "test_concurrent_treemap.h"
+#include "test_lru_cache.h"
+#include "test_interval_tree.h"
+#include "test_art.h"
 #include "test_heap.h"
 
 #include <stdio.h>
@@ -16,19 +26,59 @@ int main() {
 	int res = 0;
 	printf("Test Vector\n");
 	printf("**************\n");
-	res = test_vector();
+	res |= test_vector();
 
 	printf("Test List\n");
 	printf("**************\n");
-	res = test_list();
+	res |= test_list();
 
 	printf("Test Binary Search Tree\n");
 	printf("**************\n");
-	res = test_binary_tree();
+	res |= test_binary_tree();
+
+	printf("Test Frozen Binary Search Tree\n");
+	printf("**************\n");
+	res |= test_frozen_bst();
+
+	printf("Test Splay Tree\n");
+	printf("**************\n");
+	res |= test_splay();
+
+	printf("Test Treemap\n");
+	printf("**************\n");
+	res |= test_treemap();
+
+	printf("Test B+Tree\n");
+	printf("**************\n");
+	res |= test_btree();
+
+	printf("Test Persistent Binary Search Tree\n");
+	printf("**************\n");
+	res |= test_pbst();
+
+	printf("Test RCU Treemap\n");
+	printf("**************\n");
+	res |= test_rcu_treemap();
+
+	printf("Test Concurrent Treemap\n");
+	printf("**************\n");
+	res |= test_concurrent_treemap();
+
+	printf("Test LRU Cache\n");
+	printf("**************\n");
+	res |= test_lru_cache();
+
+	printf("Test Interval Tree\n");
+	printf("**************\n");
+	res |= test_interval_tree();
+
+	printf("Test Adaptive Radix Tree\n");
+	printf("**************\n");
+	res |= test_art();
 
 	printf("Test Heap\n");
 	printf("**************\n");
-	res = test_heap();
+	res |= test_heap();
 
 	printf("**************\n");
 	if (res == 0)
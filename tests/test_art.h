@@ -0,0 +1,277 @@
+/*
+ * @file test_art.h
+ * @author Valerio Bellizia
+ *
+ * This file contains adaptive radix tree specific tests.
+ */
+
+#ifndef test_art_h
+#define test_art_h
+
+#include "common_stuff.h"
+#include "vb_test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <ds/art.h>
+
+#define ART_TEST_KEYS 3000
+#define ART_TEST_KEY_LEN 24
+
+struct art_walk {
+	char previous[64];
+	size_t previous_len;
+	int unordered;
+	int count;
+};
+
+static int art_key_cmp(const void* k1, size_t len1, const void* k2, size_t len2) {
+	int res = memcmp(k1, k2, (len1 < len2) ? len1 : len2);
+	if (res != 0)
+		return res;
+
+	return (len1 < len2) ? -1 : (len1 > len2);
+}
+
+static void check_art_order(const void* key, size_t key_len, void* value, void* other_args) {
+	struct art_walk* walk = (struct art_walk*) other_args;
+	(void) value;
+
+	if (walk->count > 0 && art_key_cmp(walk->previous, walk->previous_len, key, key_len) >= 0)
+		walk->unordered++;
+	memcpy(walk->previous, key, key_len);
+	walk->previous_len = key_len;
+	walk->count++;
+}
+
+static int count_art_iterator(ds_art_iterator* it, int* unordered) {
+	struct art_walk walk;
+	walk.previous_len = 0;
+	walk.unordered = 0;
+	walk.count = 0;
+	for (; ds_art_iterator_is_valid(it); ds_art_iterator_next(it)) {
+		size_t len;
+		const void* key = ds_art_iterator_key(it, &len);
+		check_art_order(key, len, NULL, &walk);
+	}
+	delete_ds_art_iterator(it);
+
+	*unordered += walk.unordered;
+	return walk.count;
+}
+
+int test_art() {
+	ds_art* art = create_ds_art(sizeof(int));
+
+	vb_infoln("test inserting keys that are prefixes of other keys");
+	const char* words[] = { "romane", "romanus", "romulus", "rubens", "ruber", "rubicon", "rubicundus", "a", "ab", "abc", "" };
+	int n_words = sizeof(words) / sizeof(words[0]);
+	for (int i = 0; i < n_words; ++i)
+		vb_check_equals_int("insert should succeed", ds_art_insert(art, words[i], strlen(words[i]), &i), SUCCESS);
+	vb_check_equals_int("a key should be stored once", ds_art_insert(art, "rubens", 6, NULL), ELEMENT_ALREADY_EXISTS);
+	vb_check_equals_int("check the size", ds_art_size(art), n_words);
+
+	int found = 0;
+	for (int i = 0; i < n_words; ++i) {
+		int* v = (int*) ds_art_get(art, words[i], strlen(words[i]));
+		if (v != NULL && *v == i)
+			found++;
+	}
+	vb_check_equals_int("every key should be found with its value", found, n_words);
+	vb_check_equals_int("a prefix of a key should not be found", ds_art_search(art, "rom", 3), 0);
+	vb_check_equals_int("a key longer than any key should not be found", ds_art_search(art, "abcd", 4), 0);
+
+	int v = 42;
+	vb_check_equals_int("put should overwrite", ds_art_put(art, "ab", 2, &v), SUCCESS);
+	vb_check_equals_int("check the overwritten value", ds_get_value(int, ds_art_get(art, "ab", 2)), 42);
+	vb_check_equals_int("put should not change the size", ds_art_size(art), n_words);
+
+	vb_infoln("test the order of the keys");
+	struct art_walk walk;
+	memset(&walk, 0, sizeof(walk));
+	ds_art_visit(art, check_art_order, &walk);
+	vb_check_equals_int("every key should be visited", walk.count, n_words);
+	vb_check_equals_int("keys should be visited in order", walk.unordered, 0);
+
+	ds_art_iterator* it = ds_art_first(art);
+	size_t len = 1;
+	ds_art_iterator_key(it, &len);
+	vb_check_equals_int("the empty key should come first", len, 0);
+	delete_ds_art_iterator(it);
+
+	vb_infoln("test prefix scans");
+	int unordered = 0;
+	vb_check_equals_int("four keys start with rub", count_art_iterator(ds_art_prefix(art, "rub", 3), &unordered), 4);
+	vb_check_equals_int("three keys start with a", count_art_iterator(ds_art_prefix(art, "a", 1), &unordered), 3);
+	vb_check_equals_int("two keys start with roman", count_art_iterator(ds_art_prefix(art, "roman", 5), &unordered), 2);
+	vb_check_equals_int("a whole key is a prefix of itself", count_art_iterator(ds_art_prefix(art, "romulus", 7), &unordered), 1);
+	vb_check_equals_int("no key starts with rx", count_art_iterator(ds_art_prefix(art, "rx", 2), &unordered), 0);
+	vb_check_equals_int("an empty prefix visits every key", count_art_iterator(ds_art_prefix(art, "", 0), &unordered), n_words);
+	vb_check_equals_int("prefix scans should be sorted", unordered, 0);
+
+	vb_infoln("test lower bounds and ranges");
+	it = ds_art_lower_bound(art, "rubi", 4);
+	vb_check_equals_int("the lower bound of rubi should be rubicon", ds_get_value(int, ds_art_iterator_value(it)), 5);
+	delete_ds_art_iterator(it);
+	it = ds_art_lower_bound(art, "ruber", 5);
+	vb_check_equals_int("an existing key should be its own lower bound", ds_get_value(int, ds_art_iterator_value(it)), 4);
+	delete_ds_art_iterator(it);
+	it = ds_art_lower_bound(art, "romanz", 6);
+	vb_check_equals_int("the lower bound of romanz should be romulus", ds_get_value(int, ds_art_iterator_value(it)), 2);
+	delete_ds_art_iterator(it);
+	it = ds_art_lower_bound(art, "b", 1);
+	vb_check_equals_int("the lower bound of b should be romane", ds_get_value(int, ds_art_iterator_value(it)), 0);
+	delete_ds_art_iterator(it);
+	it = ds_art_lower_bound(art, "s", 1);
+	vb_check_equals_int("no key should follow s", ds_art_iterator_is_valid(it), 0);
+	vb_check_equals_int("the end of the keys is not a failure", ds_art_iterator_failed(it), 0);
+	delete_ds_art_iterator(it);
+	vb_check_equals_int("the empty key bounds every key", count_art_iterator(ds_art_lower_bound(art, "", 0), &unordered), n_words);
+	vb_check_equals_int("four keys are in [romane, ruber)", count_art_iterator(ds_art_range(art, "romane", 6, "ruber", 5), &unordered), 4);
+	vb_check_equals_int("three keys are in [a, abd)", count_art_iterator(ds_art_range(art, "a", 1, "abd", 3), &unordered), 3);
+	vb_check_equals_int("an empty range has no keys", count_art_iterator(ds_art_range(art, "ruber", 5, "ruber", 5), &unordered), 0);
+	vb_check_equals_int("ranges should be sorted", unordered, 0);
+
+	vb_infoln("test removing keys");
+	ds_art_remove(art, "a", 1);
+	ds_art_remove(art, "abc", 3);
+	ds_art_remove(art, "rubicon", 7);
+	ds_art_remove(art, "missing", 7);
+	vb_check_equals_int("check the size after removals", ds_art_size(art), n_words - 3);
+	vb_check_equals_int("ab should survive its neighbours", ds_get_value(int, ds_art_get(art, "ab", 2)), 42);
+	vb_check_equals_int("rubicundus should survive", ds_art_search(art, "rubicundus", 10), 1);
+	vb_check_equals_int("a removed key should not be found", ds_art_search(art, "rubicon", 7), 0);
+	vb_check_equals_int("three keys start with rub", count_art_iterator(ds_art_prefix(art, "rub", 3), &unordered), 3);
+	delete_ds_art(art);
+
+	vb_infoln("test random keys against a linear scan");
+	art = create_ds_art(sizeof(int));
+	char (*keys)[ART_TEST_KEY_LEN] = malloc(ART_TEST_KEYS * ART_TEST_KEY_LEN);
+	size_t* lens = (size_t*) malloc(ART_TEST_KEYS * sizeof(size_t));
+	int* stored = (int*) calloc(ART_TEST_KEYS, sizeof(int));
+	srand(46);
+	for (int i = 0; i < ART_TEST_KEYS; ++i) {
+		// a long shared head gives prefixes longer than the ones stored in a node, a small alphabet gives every node size
+		lens[i] = 12 + rand() % (ART_TEST_KEY_LEN - 12);
+		memcpy(keys[i], "shared-head-", 12);
+		for (size_t b = 12; b < lens[i]; ++b)
+			keys[i][b] = (char) ((b < 14) ? rand() % 256 : 'a' + rand() % 3);
+		if (rand() % 4 == 0)
+			lens[i] = 12 + rand() % (lens[i] - 11);
+		stored[i] = ds_art_put(art, keys[i], lens[i], &i) == SUCCESS;
+	}
+	for (int i = 0; i < ART_TEST_KEYS; ++i) {
+		for (int j = i + 1; j < ART_TEST_KEYS && stored[i]; ++j) {
+			if (lens[i] == lens[j] && memcmp(keys[i], keys[j], lens[i]) == 0)
+				stored[i] = 0;
+		}
+	}
+	// two keys every three go away, so that nodes shrink and collapse
+	for (int i = 0; i < ART_TEST_KEYS; i += 3) {
+		ds_art_remove(art, keys[i], lens[i]);
+		ds_art_remove(art, keys[i + 1], lens[i + 1]);
+	}
+
+	size_t expected = 0;
+	int mismatches = 0;
+	for (int i = 0; i < ART_TEST_KEYS; ++i) {
+		int removed = (i % 3) != 2;
+		for (int j = 0; j < ART_TEST_KEYS && !removed; ++j) {
+			if ((j % 3) != 2 && lens[i] == lens[j] && memcmp(keys[i], keys[j], lens[i]) == 0)
+				removed = 1;
+		}
+
+		int* value = (int*) ds_art_get(art, keys[i], lens[i]);
+		if (removed != (value == NULL))
+			mismatches++;
+		if (!removed && stored[i]) {
+			expected++;
+			if (*value != i)
+				mismatches++;
+		}
+	}
+	vb_check_equals_int("lookups should match the linear scan", mismatches, 0);
+	vb_check_equals_int("check the size", ds_art_size(art), expected);
+
+	memset(&walk, 0, sizeof(walk));
+	ds_art_visit(art, check_art_order, &walk);
+	vb_check_equals_int("every key should be visited", walk.count, expected);
+	vb_check_equals_int("keys should be visited in order", walk.unordered, 0);
+
+	int prefix_mismatches = 0;
+	for (int i = 2; i < ART_TEST_KEYS; i += 97) {
+		size_t prefix_len = 12 + (size_t) (i % 4);
+		if (prefix_len > lens[i])
+			prefix_len = lens[i];
+
+		size_t with_prefix = 0;
+		for (int j = 0; j < ART_TEST_KEYS; ++j) {
+			if (ds_art_get(art, keys[j], lens[j]) == NULL || lens[j] < prefix_len || memcmp(keys[j], keys[i], prefix_len) != 0)
+				continue;
+
+			// duplicates are counted once
+			int first = 1;
+			for (int k = 0; k < j && first; ++k) {
+				if (lens[k] == lens[j] && memcmp(keys[k], keys[j], lens[j]) == 0)
+					first = 0;
+			}
+			with_prefix += first;
+		}
+
+		if ((size_t) count_art_iterator(ds_art_prefix(art, keys[i], prefix_len), &unordered) != with_prefix)
+			prefix_mismatches++;
+	}
+	vb_check_equals_int("prefix scans should match the linear scan", prefix_mismatches, 0);
+	vb_check_equals_int("prefix scans should be sorted", unordered, 0);
+
+	int range_mismatches = 0;
+	for (int i = 0; i + 1 < ART_TEST_KEYS; i += 89) {
+		// the bounds are random keys cut short, so that most of them are not stored
+		size_t lo_len = 12 + (lens[i] - 12) / 2;
+		size_t hi_len = lens[i + 1];
+		size_t in_range = 0;
+		for (int j = 0; j < ART_TEST_KEYS; ++j) {
+			if (ds_art_get(art, keys[j], lens[j]) == NULL || art_key_cmp(keys[j], lens[j], keys[i], lo_len) < 0 || art_key_cmp(keys[j], lens[j], keys[i + 1], hi_len) >= 0)
+				continue;
+
+			int first = 1;
+			for (int k = 0; k < j && first; ++k) {
+				if (lens[k] == lens[j] && memcmp(keys[k], keys[j], lens[j]) == 0)
+					first = 0;
+			}
+			in_range += first;
+		}
+
+		if ((size_t) count_art_iterator(ds_art_range(art, keys[i], lo_len, keys[i + 1], hi_len), &unordered) != in_range)
+			range_mismatches++;
+
+		it = ds_art_lower_bound(art, keys[i], lo_len);
+		if (ds_art_iterator_is_valid(it)) {
+			size_t found_len;
+			const void* found_key = ds_art_iterator_key(it, &found_len);
+			if (art_key_cmp(found_key, found_len, keys[i], lo_len) < 0)
+				range_mismatches++;
+		}
+		delete_ds_art_iterator(it);
+	}
+	vb_check_equals_int("ranges should match the linear scan", range_mismatches, 0);
+	vb_check_equals_int("ranges should be sorted", unordered, 0);
+
+	for (int i = 0; i < ART_TEST_KEYS; ++i)
+		ds_art_remove(art, keys[i], lens[i]);
+	vb_check_equals_int("the tree should be empty", ds_art_size(art), 0);
+	it = ds_art_first(art);
+	vb_check_equals_int("an empty tree has no first key", ds_art_iterator_is_valid(it), 0);
+	delete_ds_art_iterator(it);
+
+	free(keys);
+	free(lens);
+	free(stored);
+	delete_ds_art(art);
+
+	return 0;
+}
+
+#endif
@@ -14,8 +14,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include <stdint.h>
 
 #include <ds/bst.h>
+#include <ds/cmp.h>
 
 void print_element(const void* element, void* func_aux) {
 	printf("%d ", ds_get_value(int, element));
@@ -47,6 +49,462 @@ void visit_test(const void* element, void* func_aux) {
 	test->number++;
 }
 
+// it stops when an element not smaller than test->accumulator is found
+int visit_until_test(const void* element, void* func_aux) {
+	struct visit_test* test = (struct visit_test*) func_aux;
+	test->number++;
+
+	return ds_get_value(int, element) >= test->accumulator;
+}
+
+int test_bst_order_statistics() {
+	ds_bst* tree = create_ds_bst(int_cmp, sizeof(int));
+
+	vb_infoln("test rank and select while inserting and removing elements");
+	// inserting 0, 2, 4, ..., 198 in a scrambled order
+	for (int i = 0; i < 100; ++i) {
+		int value = ((i * 37) % 100) * 2;
+		ds_bst_insert(tree, &value);
+	}
+
+	for (int i = 0; i < 100; ++i) {
+		int value = i * 2;
+		int odd = value + 1;
+		if (ds_bst_rank(tree, &value) != (size_t) i || ds_bst_rank(tree, &odd) != (size_t) i + 1) {
+			vb_infoln("wrong rank for %d", value);
+			return 1;
+		}
+		if (ds_bst_select(tree, i) == NULL || ds_get_value(int, ds_bst_select(tree, i)) != value) {
+			vb_infoln("wrong select for position %d", i);
+			return 1;
+		}
+	}
+	vb_check_equals_int("select out of bound should return NULL", ds_bst_select(tree, 100) == NULL, 1);
+
+	int lo = 10;
+	int hi = 21;
+	vb_check_equals_int("count elements within [10, 21)", ds_bst_count_range(tree, &lo, &hi), 6);
+	vb_check_equals_int("an empty range should count 0", ds_bst_count_range(tree, &hi, &lo), 0);
+
+	// removing multiples of 4: only 2, 6, 10, ... are left
+	for (int i = 0; i < 200; i += 4)
+		ds_bst_remove(tree, &i);
+
+	vb_check_equals_int("size should be 50", ds_bst_size(tree), 50);
+	for (int i = 0; i < 50; ++i) {
+		int value = i * 4 + 2;
+		if (ds_bst_rank(tree, &value) != (size_t) i || ds_get_value(int, ds_bst_select(tree, i)) != value) {
+			vb_infoln("wrong rank or select for %d after remove", value);
+			return 1;
+		}
+	}
+	vb_check_equals_int("count elements within [10, 21) after remove", ds_bst_count_range(tree, &lo, &hi), 3);
+
+	delete_ds_bst(tree);
+
+	return 0;
+}
+
+static void sum_elements(const void* element, void* func_aux) {
+	*((int*)func_aux) += ds_get_value(int, element);
+}
+
+int test_bst_range_queries() {
+	ds_bst* tree = create_ds_bst(int_cmp, sizeof(int));
+
+	// 0, 10, 20, ..., 90
+	for (int i = 9; i >= 0; --i) {
+		int value = i * 10;
+		ds_bst_insert(tree, &value);
+	}
+
+	vb_infoln("test lower bound, upper bound, floor and ceiling");
+	int twenty = 20;
+	int twenty_five = 25;
+	int minus_one = -1;
+	int hundred = 100;
+
+	ds_bst_iterator it = ds_bst_lower_bound(tree, &twenty);
+	vb_check_equals_int("lower bound of an existing element", ds_bst_iterator_get_value(int, &it), 20);
+	it = ds_bst_lower_bound(tree, &twenty_five);
+	vb_check_equals_int("lower bound of a missing element", ds_bst_iterator_get_value(int, &it), 30);
+	it = ds_bst_upper_bound(tree, &twenty);
+	vb_check_equals_int("upper bound of an existing element", ds_bst_iterator_get_value(int, &it), 30);
+	it = ds_bst_floor(tree, &twenty_five);
+	vb_check_equals_int("floor of a missing element", ds_bst_iterator_get_value(int, &it), 20);
+	it = ds_bst_floor(tree, &twenty);
+	vb_check_equals_int("floor of an existing element", ds_bst_iterator_get_value(int, &it), 20);
+	it = ds_bst_ceiling(tree, &twenty_five);
+	vb_check_equals_int("ceiling of a missing element", ds_bst_iterator_get_value(int, &it), 30);
+	it = ds_bst_floor(tree, &minus_one);
+	vb_check_equals_int("floor below the minimum is not valid", ds_bst_iterator_is_valid(&it), 0);
+	it = ds_bst_lower_bound(tree, &hundred);
+	vb_check_equals_int("lower bound above the maximum is not valid", ds_bst_iterator_is_valid(&it), 0);
+
+	it = ds_bst_lower_bound(tree, &twenty_five);
+	ds_bst_iterator_prev(&it);
+	vb_check_equals_int("iterators returned by bounds can be moved", ds_bst_iterator_get_value(int, &it), 20);
+
+	vb_infoln("test range visit");
+	int sum = 0;
+	ds_bst_range_visit(tree, &twenty, &hundred, sum_elements, &sum);
+	vb_check_equals_int("sum of elements in [20, 100)", sum, 20 + 30 + 40 + 50 + 60 + 70 + 80 + 90);
+	sum = 0;
+	ds_bst_range_visit(tree, &minus_one, &twenty_five, sum_elements, &sum);
+	vb_check_equals_int("sum of elements in [-1, 25)", sum, 0 + 10 + 20);
+	sum = 0;
+	ds_bst_range_visit(tree, &twenty_five, &twenty, sum_elements, &sum);
+	vb_check_equals_int("an empty range visits nothing", sum, 0);
+
+	delete_ds_bst(tree);
+
+	return 0;
+}
+
+int test_bst_build_sorted() {
+	int data[1000];
+	for (int i = 0; i < 1000; ++i)
+		data[i] = i * 3;
+
+	vb_infoln("test building a tree from a sorted array");
+	ds_bst* tree = ds_bst_build_sorted(int_cmp, sizeof(int), data, 1000);
+	vb_check_equals_int("tree should be created", tree != NULL, 1);
+	vb_check_equals_int("size should be 1000", ds_bst_size(tree), 1000);
+
+	int i = 0;
+	for (ds_bst_iterator it = ds_bst_first(tree); ds_bst_iterator_is_valid(&it); ds_bst_iterator_next(&it), ++i) {
+		if (ds_bst_iterator_get_value(int, &it) != data[i]) {
+			vb_infoln("wrong element at position %d", i);
+			return 1;
+		}
+	}
+	vb_check_equals_int("forward iteration should visit all elements", i, 1000);
+
+	for (ds_bst_iterator it = ds_bst_last(tree); ds_bst_iterator_is_valid(&it); ds_bst_iterator_prev(&it))
+		--i;
+	vb_check_equals_int("backward iteration should visit all elements", i, 0);
+
+	vb_check_equals_int("select should work on a built tree", ds_get_value(int, ds_bst_select(tree, 500)), 1500);
+
+	// the tree should keep working as an AVL tree
+	for (int j = 0; j < 3000; j += 2)
+		ds_bst_remove(tree, &j);
+	for (int j = 1; j < 3000; j += 6)
+		ds_bst_insert(tree, &j);
+	vb_check_equals_int("size after changes", ds_bst_size(tree), 500 + 500);
+	vb_check_equals_int("check element after changes", ds_get_value(int, ds_bst_select(tree, 1)), 3);
+
+	delete_ds_bst(tree);
+
+	int unsorted[] = { 1, 3, 2 };
+	vb_check_equals_int("unsorted input should be rejected", ds_bst_build_sorted(int_cmp, sizeof(int), unsorted, 3) == NULL, 1);
+
+	vb_infoln("test building a tree from a sorted vector");
+	ds_vect* v = create_ds_vect(int_cmp, sizeof(int));
+	for (int j = 0; j < 10; ++j)
+		ds_vect_push_back(v, &data[j]);
+
+	tree = ds_bst_build_sorted_vect(int_cmp, v);
+	vb_check_equals_int("size should be 10", ds_bst_size(tree), 10);
+	vb_check_equals_int("check minimum", ds_get_value(int, ds_bst_min(tree)), 0);
+	vb_check_equals_int("check maximum", ds_get_value(int, ds_bst_max(tree)), 27);
+	delete_ds_bst(tree);
+	delete_ds_vect(v);
+
+	return 0;
+}
+
+static int check_tree_elements(ds_bst* tree, int* expected, int n) {
+	if (ds_bst_size(tree) != (size_t) n)
+		return 0;
+
+	int i = 0;
+	for (ds_bst_iterator it = ds_bst_first(tree); ds_bst_iterator_is_valid(&it); ds_bst_iterator_next(&it), ++i) {
+		if (ds_bst_iterator_get_value(int, &it) != expected[i])
+			return 0;
+	}
+
+	return 1;
+}
+
+// it returns 1 if the two trees hold the same elements, in the same order
+static int same_tree_elements(ds_bst* t1, ds_bst* t2) {
+	if (ds_bst_size(t1) != ds_bst_size(t2))
+		return 0;
+
+	ds_bst_iterator it2 = ds_bst_first(t2);
+	for (ds_bst_iterator it1 = ds_bst_first(t1); ds_bst_iterator_is_valid(&it1); ds_bst_iterator_next(&it1), ds_bst_iterator_next(&it2)) {
+		if (ds_bst_iterator_get_value(int, &it1) != ds_bst_iterator_get_value(int, &it2))
+			return 0;
+	}
+
+	return 1;
+}
+
+static int check_parallel_set_operation(ds_result (*op)(ds_bst*, const ds_bst*), ds_result (*parallel_op)(ds_bst*, const ds_bst*, unsigned), int* a_data, int a_n, ds_bst* b) {
+	ds_bst* sequential = ds_bst_build_sorted(int_cmp, sizeof(int), a_data, a_n);
+	ds_bst* parallel = ds_bst_build_sorted(int_cmp, sizeof(int), a_data, a_n);
+	int res = op(sequential, b) == SUCCESS && parallel_op(parallel, b, 8) == SUCCESS && same_tree_elements(sequential, parallel);
+
+	// order statistics need the subtree sizes rebuilt by the joins
+	size_t half = ds_bst_size(parallel) / 2;
+	if (res && half > 0)
+		res = ds_get_value(int, ds_bst_select(parallel, half)) == ds_get_value(int, ds_bst_select(sequential, half));
+
+	delete_ds_bst(sequential);
+	delete_ds_bst(parallel);
+
+	return res;
+}
+
+int test_bst_set_operations() {
+	int evens[] = { 0, 2, 4, 6, 8, 10, 12, 14, 16, 18 };
+	int threes[] = { 0, 3, 6, 9, 12, 15, 18 };
+
+	ds_bst* a = ds_bst_build_sorted(int_cmp, sizeof(int), evens, 10);
+	ds_bst* b = ds_bst_build_sorted(int_cmp, sizeof(int), threes, 7);
+
+	vb_infoln("test union");
+	int union_expected[] = { 0, 2, 3, 4, 6, 8, 9, 10, 12, 14, 15, 16, 18 };
+	vb_check_equals_int("union should succeed", ds_bst_union(a, b), SUCCESS);
+	vb_check_equals_int("check union", check_tree_elements(a, union_expected, 13), 1);
+	vb_check_equals_int("the second tree should be untouched", check_tree_elements(b, threes, 7), 1);
+	delete_ds_bst(a);
+
+	vb_infoln("test intersection");
+	int intersection_expected[] = { 0, 6, 12, 18 };
+	a = ds_bst_build_sorted(int_cmp, sizeof(int), evens, 10);
+	vb_check_equals_int("intersection should succeed", ds_bst_intersection(a, b), SUCCESS);
+	vb_check_equals_int("check intersection", check_tree_elements(a, intersection_expected, 4), 1);
+	delete_ds_bst(a);
+
+	vb_infoln("test difference");
+	int difference_expected[] = { 2, 4, 8, 10, 14, 16 };
+	a = ds_bst_build_sorted(int_cmp, sizeof(int), evens, 10);
+	vb_check_equals_int("difference should succeed", ds_bst_difference(a, b), SUCCESS);
+	vb_check_equals_int("check difference", check_tree_elements(a, difference_expected, 6), 1);
+
+	vb_infoln("test split and join");
+	ds_bst* lt = NULL;
+	ds_bst* gt = NULL;
+	int eight = 8;
+	int lt_expected[] = { 2, 4 };
+	int gt_expected[] = { 10, 14, 16 };
+	vb_check_equals_int("split should succeed", ds_bst_split(a, &eight, &lt, &gt), SUCCESS);
+	vb_check_equals_int("check smaller elements", check_tree_elements(lt, lt_expected, 2), 1);
+	vb_check_equals_int("check bigger elements", check_tree_elements(gt, gt_expected, 3), 1);
+	vb_check_equals_int("only the split element is left", check_tree_elements(a, &eight, 1), 1);
+
+	vb_check_equals_int("join should fail if elements are not ordered", ds_bst_join(gt, lt), GENERIC_ERROR);
+	vb_check_equals_int("join should succeed", ds_bst_join(lt, a), SUCCESS);
+	vb_check_equals_int("join should succeed", ds_bst_join(lt, gt), SUCCESS);
+	vb_check_equals_int("check joined tree", check_tree_elements(lt, difference_expected, 6), 1);
+	vb_check_equals_int("joined tree should be empty", ds_bst_size(gt), 0);
+
+	delete_ds_bst(a);
+	delete_ds_bst(b);
+	delete_ds_bst(lt);
+	delete_ds_bst(gt);
+
+	vb_infoln("test parallel set operations");
+	// the trees are big enough to be split among threads
+	int* big_evens = (int*) malloc(60000 * sizeof(int));
+	int* big_threes = (int*) malloc(40000 * sizeof(int));
+	for (int i = 0; i < 60000; ++i)
+		big_evens[i] = i * 2;
+	for (int i = 0; i < 40000; ++i)
+		big_threes[i] = i * 3;
+
+	b = ds_bst_build_sorted(int_cmp, sizeof(int), big_threes, 40000);
+	vb_check_equals_int("parallel union should match the sequential one", check_parallel_set_operation(ds_bst_union, ds_bst_union_parallel, big_evens, 60000, b), 1);
+	vb_check_equals_int("parallel intersection should match the sequential one", check_parallel_set_operation(ds_bst_intersection, ds_bst_intersection_parallel, big_evens, 60000, b), 1);
+	vb_check_equals_int("parallel difference should match the sequential one", check_parallel_set_operation(ds_bst_difference, ds_bst_difference_parallel, big_evens, 60000, b), 1);
+	vb_check_equals_int("the second tree should be untouched", check_tree_elements(b, big_threes, 40000), 1);
+	delete_ds_bst(b);
+
+	free(big_evens);
+	free(big_threes);
+
+	return 0;
+}
+
+int test_bst_library_comparators() {
+	vb_infoln("test search with library comparison functions");
+	ds_bst* tree = create_ds_bst(ds_cmp_int64, sizeof(int64_t));
+	for (int64_t i = -50; i < 50; ++i) {
+		int64_t value = i * 100000000000LL;
+		ds_bst_insert(tree, &value);
+	}
+	int64_t big = -4900000000000LL;
+	int64_t missing = 1;
+	vb_check_equals_int("int64 should exist", ds_bst_search(tree, &big), 1);
+	vb_check_equals_int("int64 should not exist", ds_bst_search(tree, &missing), 0);
+	vb_check_equals_int("check the extracted int64", ds_get_value(int64_t, ds_bst_get(tree, &big)) == big, 1);
+	delete_ds_bst(tree);
+
+	tree = create_ds_bst(ds_cmp_uint64, sizeof(uint64_t));
+	uint64_t values[] = { 0, 1, 0x8000000000000000ULL, 0xFFFFFFFFFFFFFFFFULL };
+	for (int i = 0; i < 4; ++i)
+		ds_bst_insert(tree, &values[i]);
+	uint64_t two = 2;
+	vb_check_equals_int("uint64 should exist", ds_bst_search(tree, &values[2]), 1);
+	vb_check_equals_int("uint64 should not exist", ds_bst_search(tree, &two), 0);
+	vb_check_equals_int("unsigned values should be ordered as unsigned", ds_get_value(uint64_t, ds_bst_max(tree)) == values[3], 1);
+	delete_ds_bst(tree);
+
+	tree = create_ds_bst(ds_cmp_double, sizeof(double));
+	for (int i = 0; i < 20; ++i) {
+		double d = i * 0.25;
+		ds_bst_insert(tree, &d);
+	}
+	double quarter = 0.25;
+	double third = 1.0 / 3.0;
+	vb_check_equals_int("double should exist", ds_bst_search(tree, &quarter), 1);
+	vb_check_equals_int("double should not exist", ds_bst_search(tree, &third), 0);
+	delete_ds_bst(tree);
+
+	tree = create_ds_bst(ds_cmp_cstr, sizeof(const char*));
+	const char* words[] = { "delta", "alpha", "echo", "charlie", "bravo" };
+	for (int i = 0; i < 5; ++i)
+		ds_bst_insert(tree, &words[i]);
+	char probe[] = "charlie";
+	const char* p = probe;
+	const char* other = "foxtrot";
+	vb_check_equals_int("string should exist", ds_bst_search(tree, &p), 1);
+	vb_check_equals_int("string should not exist", ds_bst_search(tree, &other), 0);
+	vb_check_equals_int("the stored pointer should be returned", ds_get_value(const char*, ds_bst_get(tree, &p)) == words[3], 1);
+	delete_ds_bst(tree);
+
+	return 0;
+}
+
+struct multi_element {
+	int key;
+	int seq;
+};
+
+static int multi_element_cmp(const void* e1, const void* e2) {
+	return int_cmp(&((const struct multi_element*) e1)->key, &((const struct multi_element*) e2)->key);
+}
+
+// it counts the elements out of order: keys must not decrease, and equal keys must be in insertion order
+static int multi_order_errors(ds_bst* tree) {
+	int errors = 0;
+	struct multi_element previous = { -1, -1 };
+	for (ds_bst_iterator it = ds_bst_first(tree); ds_bst_iterator_is_valid(&it); ds_bst_iterator_next(&it)) {
+		struct multi_element e = ds_bst_iterator_get_value(struct multi_element, &it);
+		if (e.key < previous.key || (e.key == previous.key && e.seq <= previous.seq))
+			errors++;
+		previous = e;
+	}
+
+	return errors;
+}
+
+int test_bst_multi() {
+	ds_bst* tree = create_ds_bst_multi(multi_element_cmp, sizeof(struct multi_element));
+	int counts[50] = { 0 };
+
+	vb_infoln("test inserting duplicates");
+	srand(45);
+	for (int i = 0; i < 2000; ++i) {
+		struct multi_element e = { rand() % 50, i };
+		vb_check_equals_int("duplicates should be accepted", ds_bst_insert(tree, &e) == SUCCESS, 1);
+		counts[e.key]++;
+	}
+	vb_check_equals_int("size should be 2000", ds_bst_size(tree), 2000);
+	vb_check_equals_int("equal elements should be in insertion order", multi_order_errors(tree), 0);
+
+	int mismatches = 0;
+	for (int k = 0; k < 50; ++k) {
+		struct multi_element probe = { k, 0 };
+		if (ds_bst_count(tree, &probe) != (size_t) counts[k])
+			mismatches++;
+	}
+	vb_check_equals_int("check the counts", mismatches, 0);
+
+	vb_infoln("test removing one element and all the equal ones");
+	struct multi_element probe = { 7, 0 };
+	const struct multi_element* first = (const struct multi_element*) ds_bst_get(tree, &probe);
+	int first_seq = first->seq;
+	ds_bst_remove(tree, &probe);
+	first = (const struct multi_element*) ds_bst_get(tree, &probe);
+	vb_check_equals_int("the first equal element should be removed", first->seq > first_seq, 1);
+	vb_check_equals_int("check the count after remove", ds_bst_count(tree, &probe), counts[7] - 1);
+
+	ds_bst_remove_all(tree, &probe);
+	vb_check_equals_int("no element should be left", ds_bst_count(tree, &probe), 0);
+	vb_check_equals_int("check the size after remove all", ds_bst_size(tree), 2000 - counts[7]);
+	vb_check_equals_int("elements should still be in order", multi_order_errors(tree), 0);
+
+	vb_infoln("test erasing through an iterator");
+	probe.key = 20;
+	size_t erased = 0;
+	ds_bst_iterator it = ds_bst_lower_bound(tree, &probe);
+	while (ds_bst_iterator_is_valid(&it) && ds_bst_iterator_get_ptr(struct multi_element, &it)->key == 20) {
+		if (ds_bst_iterator_get_ptr(struct multi_element, &it)->seq % 2 == 0) {
+			ds_bst_erase(tree, &it);
+			erased++;
+		}
+		else
+			ds_bst_iterator_next(&it);
+	}
+	vb_check_equals_int("check the count after erase", ds_bst_count(tree, &probe), counts[20] - erased);
+	vb_check_equals_int("check the size after erase", ds_bst_size(tree), 2000 - counts[7] - erased);
+	vb_check_equals_int("elements should still be in order", multi_order_errors(tree), 0);
+
+	size_t visited = 0;
+	for (it = ds_bst_first(tree); ds_bst_iterator_is_valid(&it); ds_bst_iterator_next(&it))
+		visited++;
+	vb_check_equals_int("every element should be reachable", visited, ds_bst_size(tree));
+
+	delete_ds_bst(tree);
+
+	vb_infoln("test splitting and joining trees with duplicates");
+	int sorted[] = { 1, 5, 5, 5, 5, 5, 5, 5, 9 };
+	tree = ds_bst_build_sorted_multi(int_cmp, sizeof(int), sorted, 9);
+	vb_check_equals_int("equal neighbours should be accepted", tree != NULL && ds_bst_is_multi(tree), 1);
+	vb_check_equals_int("a plain tree should reject equal neighbours", ds_bst_build_sorted(int_cmp, sizeof(int), sorted, 9) == NULL, 1);
+
+	int five = 5;
+	ds_bst* lt;
+	ds_bst* gt;
+	vb_check_equals_int("split should succeed", ds_bst_split(tree, &five, &lt, &gt), SUCCESS);
+	vb_check_equals_int("only smaller elements should go to lt", check_tree_elements(lt, sorted, 1), 1);
+	vb_check_equals_int("every equal element should stay", check_tree_elements(tree, sorted + 1, 7), 1);
+	vb_check_equals_int("only bigger elements should go to gt", check_tree_elements(gt, sorted + 8, 1), 1);
+
+	vb_check_equals_int("join should succeed", ds_bst_join(lt, tree), SUCCESS);
+	vb_check_equals_int("join should succeed", ds_bst_join(lt, gt), SUCCESS);
+	ds_bst* other = ds_bst_build_sorted_multi(int_cmp, sizeof(int), sorted + 8, 1);
+	vb_check_equals_int("equal elements may be joined", ds_bst_join(lt, other), SUCCESS);
+	vb_check_equals_int("check the size after join", ds_bst_size(lt), 10);
+	vb_check_equals_int("check the count after join", ds_bst_count(lt, &sorted[8]), 2);
+
+	ds_bst* set = create_ds_bst(int_cmp, sizeof(int));
+	ds_bst_insert(set, &five);
+	ds_bst_insert(other, &five);
+	vb_check_equals_int("a set should reject equal elements", ds_bst_join(set, other), GENERIC_ERROR);
+	int one = 1;
+	ds_bst* small_set = create_ds_bst(int_cmp, sizeof(int));
+	ds_bst_insert(small_set, &one);
+	vb_check_equals_int("a set should not take a tree with duplicates", ds_bst_join(small_set, other), GENERIC_ERROR);
+	vb_check_equals_int("the set should be untouched", ds_bst_size(small_set), 1);
+	delete_ds_bst(small_set);
+	vb_check_equals_int("union needs sets", ds_bst_union(lt, set), GENERIC_ERROR);
+	vb_check_equals_int("intersection needs sets", ds_bst_intersection(set, lt), GENERIC_ERROR);
+	vb_check_equals_int("difference needs sets", ds_bst_difference(lt, set), GENERIC_ERROR);
+	vb_check_equals_int("the trees should be untouched", ds_bst_size(lt) + ds_bst_size(set), 11);
+
+	delete_ds_bst(set);
+	delete_ds_bst(other);
+	delete_ds_bst(lt);
+	delete_ds_bst(gt);
+	delete_ds_bst(tree);
+
+	return 0;
+}
+
 int test_binary_tree() {
 	ds_bst* tree = create_ds_bst(int_cmp, sizeof(int));
 	ds_result res = GENERIC_ERROR;
@@ -107,6 +565,24 @@ int test_binary_tree() {
 	ds_bst_visit(tree, visit_test, &test, DFS_POST_ORDER);
 	vb_check_equals_int("check the post order visit", test.accumulator, post_order_expected);
 
+	int level_order_expected = 12 + (pow(31, 1) * 5) + (pow(31, 2) * 13) + (pow(31, 3) * 0) + (pow(31, 4) * 10) + (pow(31, 5) * 15);
+
+	vb_infoln("LEVEL-ORDER");
+	reset_test(&test);
+	print_tree(tree, BFS_LEVEL_ORDER);
+	ds_bst_visit(tree, visit_test, &test, BFS_LEVEL_ORDER);
+	vb_check_equals_int("check the level order visit", test.accumulator, level_order_expected);
+
+	vb_infoln("test visit with early termination");
+	reset_test(&test);
+	test.accumulator = 10;
+	vb_check_equals_int("visit should stop on the first element not smaller than 10", ds_bst_visit_until(tree, visit_until_test, &test, DFS_IN_ORDER), 1);
+	vb_check_equals_int("check the number of visited elements", test.number, 3);
+	reset_test(&test);
+	test.accumulator = 100;
+	vb_check_equals_int("visit should not stop if no element matches", ds_bst_visit_until(tree, visit_until_test, &test, BFS_LEVEL_ORDER), 0);
+	vb_check_equals_int("check the number of visited elements", test.number, 6);
+
 	ds_bst_iterator it = ds_bst_first(tree);
 	int n = 0;
 	int p = 0;
@@ -137,13 +613,32 @@ int test_binary_tree() {
 	vb_check_equals_int("check if element is extracted properly", *((int*)ds_bst_get(tree, &fifteen)), fifteen);
 	vb_check_equals_int("check what happens if I try to add a duplicate element", ds_bst_insert(tree, &fifteen), ELEMENT_ALREADY_EXISTS);
 
+	int inserted = -1;
+	vb_check_equals_int("get or insert should return the existing element", *((int*)ds_bst_get_or_insert(tree, &fifteen, &inserted)), fifteen);
+	vb_check_equals_int("existing element should not be inserted", inserted, 0);
+
 	int twenty = 20;
 	res = ds_bst_remove(tree, &twenty);
 	vb_check_equals_int("check that the tree still has the same number of elements than before (5)", ds_bst_size(tree), 5);
 
 	delete_ds_bst(tree);
 
-	return 0;
+	if (test_bst_order_statistics() != 0)
+		return 1;
+
+	if (test_bst_range_queries() != 0)
+		return 1;
+
+	if (test_bst_build_sorted() != 0)
+		return 1;
+
+	if (test_bst_library_comparators() != 0)
+		return 1;
+
+	if (test_bst_multi() != 0)
+		return 1;
+
+	return test_bst_set_operations();
 }
 
 #endif
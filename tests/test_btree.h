@@ -0,0 +1,131 @@
+/*
+ * @file test_btree.h
+ * @author Valerio Bellizia
+ *
+ * This file contains B+tree specific tests.
+ */
+
+#ifndef test_btree_h
+#define test_btree_h
+
+#include "common_stuff.h"
+#include "vb_test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <ds/btree.h>
+
+static void sum_btree_elements(const void* element, void* func_aux) {
+	*((int*)func_aux) += ds_get_value(int, element);
+}
+
+// it stops the visit at the first element bigger than 100
+static int sum_btree_until(const void* element, void* func_aux) {
+	if (ds_get_value(int, element) > 100)
+		return 1;
+
+	*((int*)func_aux) += ds_get_value(int, element);
+	return 0;
+}
+
+int test_btree() {
+	ds_btree* tree = create_ds_btree(int_cmp, sizeof(int));
+
+	vb_infoln("test inserting enough elements to split nodes");
+	// inserting 0, 3, 6, ..., 2997 in a scrambled order
+	for (int i = 0; i < 1000; ++i) {
+		int value = ((i * 7) % 1000) * 3;
+		if (ds_btree_insert(tree, &value) != SUCCESS) {
+			vb_infoln("insert of %d failed", value);
+			return 1;
+		}
+	}
+	vb_check_equals_int("size should be 1000", ds_btree_size(tree), 1000);
+
+	int three = 3;
+	int four = 4;
+	vb_check_equals_int("element should exist", ds_btree_search(tree, &three), 1);
+	vb_check_equals_int("element should not exist", ds_btree_search(tree, &four), 0);
+	vb_check_equals_int("check if element is extracted properly", ds_get_value(int, ds_btree_get(tree, &three)), 3);
+	vb_check_equals_int("check what happens if I try to add a duplicate element", ds_btree_insert(tree, &three), ELEMENT_ALREADY_EXISTS);
+	vb_check_equals_int("check minimum", ds_get_value(int, ds_btree_min(tree)), 0);
+	vb_check_equals_int("check maximum", ds_get_value(int, ds_btree_max(tree)), 2997);
+
+	vb_infoln("test iterating forward and backward");
+	int expected = 0;
+	for (ds_btree_iterator it = ds_btree_first(tree); ds_btree_iterator_is_valid(&it); ds_btree_iterator_next(&it)) {
+		if (ds_btree_iterator_get_value(int, &it) != expected) {
+			vb_infoln("wrong element, expected %d", expected);
+			return 1;
+		}
+		expected += 3;
+	}
+	vb_check_equals_int("forward iteration should visit all elements", expected, 3000);
+
+	for (ds_btree_iterator it = ds_btree_last(tree); ds_btree_iterator_is_valid(&it); ds_btree_iterator_prev(&it)) {
+		expected -= 3;
+		if (ds_btree_iterator_get_value(int, &it) != expected) {
+			vb_infoln("wrong element, expected %d", expected);
+			return 1;
+		}
+	}
+	vb_check_equals_int("backward iteration should visit all elements", expected, 0);
+
+	ds_btree_iterator lb = ds_btree_lower_bound(tree, &four);
+	vb_check_equals_int("check lower bound", ds_btree_iterator_get_value(int, &lb), 6);
+
+	vb_infoln("test the bounds shared with ds_bst");
+	int six = 6;
+	int max = 2997;
+	int minus_one = -1;
+	ds_btree_iterator bound = ds_btree_upper_bound(tree, &six);
+	vb_check_equals_int("check upper bound", ds_btree_iterator_get_value(int, &bound), 9);
+	bound = ds_btree_upper_bound(tree, &max);
+	vb_check_equals_int("nothing is bigger than the maximum", ds_btree_iterator_is_valid(&bound), 0);
+	bound = ds_btree_floor(tree, &four);
+	vb_check_equals_int("check floor", ds_btree_iterator_get_value(int, &bound), 3);
+	bound = ds_btree_floor(tree, &six);
+	vb_check_equals_int("the floor of an element is itself", ds_btree_iterator_get_value(int, &bound), 6);
+	bound = ds_btree_floor(tree, &minus_one);
+	vb_check_equals_int("nothing is smaller than the minimum", ds_btree_iterator_is_valid(&bound), 0);
+	bound = ds_btree_ceiling(tree, &four);
+	vb_check_equals_int("check ceiling", ds_btree_iterator_get_value(int, &bound), 6);
+
+	int sum = 0;
+	int lo = 100;
+	int hi = 200;
+	ds_btree_range_visit(tree, &lo, &hi, sum_btree_elements, &sum);
+	// 102, 105, ..., 198
+	vb_check_equals_int("check the range visit", sum, (102 + 198) * 33 / 2);
+
+	sum = 0;
+	vb_check_equals_int("the visit should be stopped", ds_btree_visit_until(tree, sum_btree_until, &sum, BFS_LEVEL_ORDER), 1);
+	vb_check_equals_int("elements should be visited in order", sum, (0 + 99) * 34 / 2);
+
+	vb_infoln("test removing elements");
+	// removing everything but multiples of 9
+	for (int i = 0; i < 3000; i += 3) {
+		if (i % 9 != 0)
+			ds_btree_remove(tree, &i);
+	}
+	vb_check_equals_int("size after remove", ds_btree_size(tree), 334);
+	vb_check_equals_int("removed element should not exist", ds_btree_search(tree, &three), 0);
+
+	sum = 0;
+	ds_btree_visit(tree, sum_btree_elements, &sum, DFS_IN_ORDER);
+	vb_check_equals_int("check the visit after remove", sum, 9 * (333 * 334 / 2));
+
+	for (int i = 0; i < 3000; i += 9)
+		ds_btree_remove(tree, &i);
+	vb_check_equals_int("tree should be empty", ds_btree_size(tree), 0);
+	ds_btree_iterator first = ds_btree_first(tree);
+	vb_check_equals_int("first should not be valid on an empty tree", ds_btree_iterator_is_valid(&first), 0);
+	vb_check_equals_int("tree can be filled again", ds_btree_insert(tree, &four), SUCCESS);
+
+	delete_ds_btree(tree);
+
+	return 0;
+}
+
+#endif
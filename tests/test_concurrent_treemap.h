@@ -0,0 +1,142 @@
+/*
+ * @file test_concurrent_treemap.h
+ * @author Valerio Bellizia
+ *
+ * This file contains concurrent treemap specific tests.
+ */
+
+#ifndef test_concurrent_treemap_h
+#define test_concurrent_treemap_h
+
+#include "common_stuff.h"
+#include "vb_test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include <ds/concurrent_treemap.h>
+
+struct concurrent_writer_test {
+	ds_concurrent_treemap* map;
+	int first;
+	int count;
+};
+
+static void increment_counter(const void* key, void* value, int existed, void* other_args) {
+	(void) key;
+	(void) existed;
+	(void) other_args;
+	(*(int*)value)++;
+}
+
+// every writer inserts its own keys and increments a set of counters shared with the other writers
+static void* concurrent_writer_thread(void* arg) {
+	struct concurrent_writer_test* test = (struct concurrent_writer_test*) arg;
+	for (int i = test->first; i < test->first + test->count; ++i) {
+		int v = i * 2;
+		ds_concurrent_treemap_insert(test->map, &i, &v);
+
+		int counter = -(i % 10) - 1;
+		ds_concurrent_treemap_compute(test->map, &counter, increment_counter, NULL);
+	}
+
+	return NULL;
+}
+
+// it checks that the iterator walks keys in order and that every value is twice its key (negative keys are counters)
+static int check_ordered_walk(ds_concurrent_treemap* map) {
+	int errors = 0;
+	int previous = -1000;
+	ds_concurrent_treemap_iterator* it = ds_concurrent_treemap_first(map);
+	for (; ds_concurrent_treemap_iterator_is_valid(it); ds_concurrent_treemap_iterator_next(it)) {
+		const ds_treemap_entry* entry = ds_concurrent_treemap_iterator_get(it);
+		int k = ds_get_value(int, entry->key);
+		if (k <= previous || (k >= 0 && ds_get_value(int, entry->value) != k * 2))
+			errors++;
+		previous = k;
+	}
+	delete_ds_concurrent_treemap_iterator(it);
+
+	return errors;
+}
+
+int test_concurrent_treemap() {
+	ds_concurrent_treemap* map = create_ds_concurrent_treemap(int_cmp, sizeof(int), sizeof(int), 8);
+	vb_check_equals_int("shards cannot be 0", create_ds_concurrent_treemap(int_cmp, sizeof(int), sizeof(int), 0) == NULL, 1);
+
+	vb_infoln("test inserting and reading elements");
+	for (int i = 0; i < 100; ++i) {
+		int v = i * 2;
+		ds_concurrent_treemap_insert(map, &i, &v);
+	}
+	int key = 21;
+	int value = 0;
+	vb_check_equals_int("size should be 100", ds_concurrent_treemap_size(map), 100);
+	vb_check_equals_int("key should exist", ds_concurrent_treemap_get(map, &key, &value), 1);
+	vb_check_equals_int("check the value", value, 42);
+	vb_check_equals_int("duplicate keys should be rejected", ds_concurrent_treemap_insert(map, &key, &key), ELEMENT_ALREADY_EXISTS);
+	vb_check_equals_int("put should replace the value", ds_concurrent_treemap_put(map, &key, &key), SUCCESS);
+	ds_concurrent_treemap_get(map, &key, &value);
+	vb_check_equals_int("check the replaced value", value, 21);
+	vb_check_equals_int("remove should succeed", ds_concurrent_treemap_remove(map, &key), SUCCESS);
+	vb_check_equals_int("key should not exist anymore", ds_concurrent_treemap_search(map, &key), 0);
+	vb_check_equals_int("size should be 99", ds_concurrent_treemap_size(map), 99);
+
+	vb_infoln("test the merged iterator");
+	vb_check_equals_int("keys should be visited in order", check_ordered_walk(map), 0);
+	int visited = 0;
+	ds_concurrent_treemap_iterator* it = ds_concurrent_treemap_first(map);
+	for (; ds_concurrent_treemap_iterator_is_valid(it); ds_concurrent_treemap_iterator_next(it))
+		visited++;
+	delete_ds_concurrent_treemap_iterator(it);
+	vb_check_equals_int("every key should be visited", visited, 99);
+	delete_ds_concurrent_treemap(map);
+
+	vb_infoln("test concurrent writers");
+	map = create_ds_concurrent_treemap(int_cmp, sizeof(int), sizeof(int), 16);
+	struct concurrent_writer_test tests[4];
+	pthread_t threads[4];
+	for (int i = 0; i < 4; ++i) {
+		tests[i].map = map;
+		tests[i].first = i * 2500;
+		tests[i].count = 2500;
+		pthread_create(&threads[i], NULL, concurrent_writer_thread, &tests[i]);
+	}
+	for (int i = 0; i < 4; ++i)
+		pthread_join(threads[i], NULL);
+
+	vb_check_equals_int("size should be 10010", ds_concurrent_treemap_size(map), 10010);
+	int total = 0;
+	for (int counter = -10; counter < 0; ++counter) {
+		ds_concurrent_treemap_get(map, &counter, &value);
+		total += value;
+	}
+	vb_check_equals_int("no increment should be lost", total, 10000);
+	vb_check_equals_int("keys should be visited in order", check_ordered_walk(map), 0);
+	delete_ds_concurrent_treemap(map);
+
+	vb_infoln("test range partitioning");
+	int bounds[] = { 10, 20, 30 };
+	int unsorted[] = { 20, 10 };
+	vb_check_equals_int("bounds should be sorted", create_ds_concurrent_treemap_ranged(int_cmp, sizeof(int), sizeof(int), unsorted, 2) == NULL, 1);
+	map = create_ds_concurrent_treemap_ranged(int_cmp, sizeof(int), sizeof(int), bounds, 3);
+	vb_check_equals_int("there should be 4 shards", ds_concurrent_treemap_shards(map), 4);
+	for (int i = 0; i < 40; ++i) {
+		// the range [10, 20) stays empty
+		if (i >= 10 && i < 20)
+			continue;
+		int v = i * 2;
+		ds_concurrent_treemap_insert(map, &i, &v);
+	}
+	vb_check_equals_int("size should be 30", ds_concurrent_treemap_size(map), 30);
+	vb_check_equals_int("keys should be visited in order", check_ordered_walk(map), 0);
+	key = 30;
+	vb_check_equals_int("a bound should belong to its own shard", ds_concurrent_treemap_get(map, &key, &value), 1);
+	vb_check_equals_int("check the value of a bound", value, 60);
+	delete_ds_concurrent_treemap(map);
+
+	return 0;
+}
+
+#endif
@@ -0,0 +1,86 @@
+/*
+ * @file test_frozen_bst.h
+ * @author Valerio Bellizia
+ *
+ * This file contains frozen binary tree specific tests.
+ */
+
+#ifndef test_frozen_bst_h
+#define test_frozen_bst_h
+
+#include "common_stuff.h"
+#include "vb_test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <ds/bst.h>
+#include <ds/frozen_bst.h>
+
+int test_frozen_bst() {
+	ds_bst* tree = create_ds_bst(int_cmp, sizeof(int));
+	for (int i = 0; i < 1000; i += 3)
+		ds_bst_insert(tree, &i);
+
+	vb_infoln("test freezing a tree");
+	ds_frozen_bst* frozen = ds_bst_freeze(tree);
+	vb_check_equals_int("sizes should match", ds_frozen_bst_size(frozen), ds_bst_size(tree));
+
+	int present = 300;
+	int missing = 301;
+	vb_check_equals_int("element should exist", ds_frozen_bst_search(frozen, &present), 1);
+	vb_check_equals_int("element should not exist", ds_frozen_bst_search(frozen, &missing), 0);
+	vb_check_equals_int("check the element", ds_get_value(int, ds_frozen_bst_get(frozen, &present)), 300);
+
+	vb_infoln("test that elements are visited in order");
+	int errors = 0;
+	int count = 0;
+	int expected = 0;
+	for (ds_frozen_bst_iterator it = ds_frozen_bst_first(frozen); ds_frozen_bst_iterator_is_valid(&it); ds_frozen_bst_iterator_next(&it)) {
+		if (ds_frozen_bst_iterator_get_value(int, &it) != expected)
+			errors++;
+		expected += 3;
+		count++;
+	}
+	vb_check_equals_int("all the elements should be in order", errors, 0);
+	vb_check_equals_int("all the elements should be visited", count, 334);
+
+	for (ds_frozen_bst_iterator it = ds_frozen_bst_last(frozen); ds_frozen_bst_iterator_is_valid(&it); ds_frozen_bst_iterator_prev(&it)) {
+		expected -= 3;
+		if (ds_frozen_bst_iterator_get_value(int, &it) != expected)
+			errors++;
+		count--;
+	}
+	vb_check_equals_int("all the elements should be in reverse order", errors, 0);
+	vb_check_equals_int("all the elements should be visited backward", count, 0);
+
+	vb_infoln("test lower bound against the binary search tree");
+	for (int i = -1; i <= 1000; ++i) {
+		ds_frozen_bst_iterator fit = ds_frozen_bst_lower_bound(frozen, &i);
+		ds_bst_iterator bit = ds_bst_lower_bound(tree, &i);
+		if (ds_frozen_bst_iterator_is_valid(&fit) != ds_bst_iterator_is_valid(&bit))
+			errors++;
+		else if (ds_bst_iterator_is_valid(&bit) && ds_frozen_bst_iterator_get_value(int, &fit) != ds_bst_iterator_get_value(int, &bit))
+			errors++;
+	}
+	vb_check_equals_int("lower bounds should match", errors, 0);
+
+	vb_infoln("test that the frozen tree does not depend on the original one");
+	delete_ds_bst(tree);
+	vb_check_equals_int("element should still exist", ds_frozen_bst_search(frozen, &present), 1);
+	delete_ds_frozen_bst(frozen);
+
+	vb_infoln("test freezing an empty tree");
+	tree = create_ds_bst(int_cmp, sizeof(int));
+	frozen = ds_bst_freeze(tree);
+	ds_frozen_bst_iterator it = ds_frozen_bst_first(frozen);
+	vb_check_equals_int("size should be 0", ds_frozen_bst_size(frozen), 0);
+	vb_check_equals_int("iterator should not be valid", ds_frozen_bst_iterator_is_valid(&it), 0);
+	vb_check_equals_int("element should not exist", ds_frozen_bst_search(frozen, &present), 0);
+	delete_ds_frozen_bst(frozen);
+	delete_ds_bst(tree);
+
+	return 0;
+}
+
+#endif
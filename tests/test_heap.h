@@ -11,6 +11,10 @@
 #include "common_stuff.h"
 #include "vb_test.h"
 
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+
 #include <ds/heap.h>
 
 int run_test_min_heap(ds_heap* heap) {
@@ -84,14 +88,239 @@ int run_test_max_heap(ds_heap* heap) {
 	return 0;
 }
 
+struct heap_task {
+	int id;
+	double deadline;
+	char name[12];
+};
+
+int run_test_heap_inline() {
+	ds_heap* heap = create_ds_heap(MIN_HEAP, sizeof(struct heap_task));
+
+	vb_infoln("test that elements are copied into the heap");
+	struct heap_task task;
+	memset(&task, 0, sizeof(task));
+	for (int i = 0; i < 200; ++i) {
+		// the same buffer is reused for every push
+		task.id = i;
+		task.deadline = i * 0.5;
+		snprintf(task.name, sizeof(task.name), "task-%d", i);
+		ds_heap_push(heap, &task, (i * 37) % 200);
+	}
+	vb_check_equals_int("check the size", ds_heap_size(heap), 200);
+
+	int priority = -1;
+	const struct heap_task* top = (const struct heap_task*) ds_heap_peek(heap, &priority);
+	vb_check_equals_int("peek should return the first priority", priority, 0);
+	vb_check_equals_int("peek should return the first element", top->id, 0);
+	vb_check_equals_int("peek should not remove the element", ds_heap_size(heap), 200);
+
+	vb_infoln("test popping into a buffer of the caller");
+	int unordered = 0;
+	int corrupted = 0;
+	int previous = -1;
+	while (ds_heap_pop_into(heap, &task, &priority) == SUCCESS) {
+		if (priority < previous)
+			unordered++;
+		previous = priority;
+
+		char name[12];
+		snprintf(name, sizeof(name), "task-%d", task.id);
+		if ((task.id * 37) % 200 != priority || task.deadline != task.id * 0.5 || strcmp(task.name, name) != 0)
+			corrupted++;
+	}
+	vb_check_equals_int("elements should be popped by priority", unordered, 0);
+	vb_check_equals_int("elements should be popped intact", corrupted, 0);
+	vb_check_equals_int("the heap should be empty", ds_heap_size(heap), 0);
+	vb_check_equals_int("peek on an empty heap", ds_heap_peek(heap, NULL) == NULL, 1);
+	vb_check_equals_int("pop_into on an empty heap", ds_heap_pop_into(heap, &task, NULL), GENERIC_ERROR);
+
+	delete_ds_heap(heap);
+	return 0;
+}
+
+int run_test_heap_random(ds_heap_type type, size_t arity) {
+	ds_heap* heap = create_ds_dary_heap(type, sizeof(int), arity);
+	vb_check_equals_int("check the arity", ds_heap_arity(heap), arity);
+
+	vb_infoln("test interleaved pushes and pops against a counting table (arity %zu)", arity);
+	// priorities are small, so that many entries share the same priority
+	int counts[64];
+	memset(counts, 0, sizeof(counts));
+	size_t size = 0;
+	int mismatches = 0;
+	srand(48);
+	for (int op = 0; op < 20000; ++op) {
+		if (size == 0 || rand() % 3 != 0) {
+			int priority = rand() % 64;
+			ds_heap_push(heap, &priority, priority);
+			counts[priority]++;
+			size++;
+			continue;
+		}
+
+		int expected = (type == MIN_HEAP) ? 0 : 63;
+		while (counts[expected] == 0)
+			expected += (type == MIN_HEAP) ? 1 : -1;
+
+		int element = -1;
+		int priority = -1;
+		ds_heap_pop_into(heap, &element, &priority);
+		if (priority != expected || element != expected)
+			mismatches++;
+		counts[expected]--;
+		size--;
+	}
+	vb_check_equals_int("pops should follow the priorities", mismatches, 0);
+	vb_check_equals_int("check the size", ds_heap_size(heap), size);
+
+	delete_ds_heap(heap);
+	return 0;
+}
+
+#define HEAP_TEST_ITEMS 500
+
+int run_test_heap_handles(ds_heap_type type, size_t arity) {
+	ds_heap* heap = create_ds_dary_heap(type, sizeof(int), arity);
+
+	vb_infoln("test updates and removals by handle against a table (arity %zu)", arity);
+	// every item is in the heap at most once, its element is its id
+	ds_heap_handle handles[HEAP_TEST_ITEMS];
+	int priorities[HEAP_TEST_ITEMS];
+	int present[HEAP_TEST_ITEMS];
+	memset(present, 0, sizeof(present));
+	memset(handles, 0xff, sizeof(handles));
+	size_t size = 0;
+	int mismatches = 0;
+	srand(50);
+	for (int op = 0; op < 30000; ++op) {
+		int id = rand() % HEAP_TEST_ITEMS;
+		int action = rand() % 4;
+		if (!present[id] && action != 3) {
+			priorities[id] = rand() % 1000;
+			ds_heap_push_handle(heap, &id, priorities[id], &handles[id]);
+			present[id] = 1;
+			size++;
+		}
+		else if (action == 0 || action == 1) {
+			priorities[id] = rand() % 1000;
+			if (ds_heap_update_priority(heap, handles[id], priorities[id]) != SUCCESS)
+				mismatches++;
+		}
+		else if (action == 2) {
+			ds_heap_remove(heap, handles[id]);
+			if (ds_heap_contains(heap, handles[id]))
+				mismatches++;
+			present[id] = 0;
+			size--;
+		}
+		else if (size > 0) {
+			int best = -1;
+			for (int i = 0; i < HEAP_TEST_ITEMS; ++i) {
+				if (present[i] && (best == -1 || (type == MIN_HEAP ? priorities[i] < priorities[best] : priorities[i] > priorities[best])))
+					best = i;
+			}
+
+			int popped = -1;
+			int priority = -1;
+			ds_heap_pop_into(heap, &popped, &priority);
+			if (priority != priorities[best] || !present[popped] || priorities[popped] != priority)
+				mismatches++;
+			present[popped] = 0;
+			size--;
+		}
+	}
+
+	for (int i = 0; i < HEAP_TEST_ITEMS; ++i) {
+		int priority = -1;
+		int* element = (int*) ds_heap_get(heap, handles[i], &priority);
+		if (present[i] && (!ds_heap_contains(heap, handles[i]) || element == NULL || *element != i || priority != priorities[i]))
+			mismatches++;
+	}
+	vb_check_equals_int("the heap should match the table", mismatches, 0);
+	vb_check_equals_int("check the size", ds_heap_size(heap), size);
+
+	delete_ds_heap(heap);
+	return 0;
+}
+
+int run_test_heap_late_handles() {
+	ds_heap* heap = create_ds_heap(MAX_HEAP, sizeof(int));
+
+	vb_infoln("test handles asked for after entries without one");
+	for (int i = 0; i < 10; ++i)
+		ds_heap_push(heap, &i, i);
+
+	int v = 100;
+	ds_heap_handle handle;
+	vb_check_equals_int("push with a handle should succeed", ds_heap_push_handle(heap, &v, -5, &handle), SUCCESS);
+	vb_check_equals_int("the entry should be in the heap", ds_heap_contains(heap, handle), 1);
+	vb_check_equals_int("raise the entry to the top", ds_heap_update_priority(heap, handle, INT_MAX), SUCCESS);
+
+	int priority = 0;
+	vb_check_equals_int("the entry should be the top", ds_get_value(int, ds_heap_peek(heap, &priority)), 100);
+	vb_check_equals_int("check the top priority", priority, INT_MAX);
+	vb_check_equals_int("lower the entry to the bottom", ds_heap_update_priority(heap, handle, INT_MIN), SUCCESS);
+	vb_check_equals_int("check the new top", ds_get_value(int, ds_heap_peek(heap, NULL)), 9);
+	ds_heap_get(heap, handle, &priority);
+	vb_check_equals_int("check the priority of the entry", priority, INT_MIN);
+
+	ds_heap_remove(heap, handle);
+	vb_check_equals_int("the entry should be removed", ds_heap_contains(heap, handle), 0);
+	vb_check_equals_int("updating a removed entry fails", ds_heap_update_priority(heap, handle, 0), GENERIC_ERROR);
+
+	vb_infoln("test handles of popped entries after their place is reused");
+	int fired = 200;
+	ds_heap_handle fired_handle;
+	ds_heap_push_handle(heap, &fired, INT_MAX, &fired_handle);
+	ds_heap_pop_into(heap, NULL, NULL);
+	int next = 300;
+	ds_heap_handle next_handle;
+	ds_heap_push_handle(heap, &next, INT_MAX, &next_handle);
+	vb_check_equals_int("the new entry should get a new handle", next_handle != fired_handle, 1);
+	vb_check_equals_int("a popped entry should not be in the heap", ds_heap_contains(heap, fired_handle), 0);
+	vb_check_equals_int("a popped entry cannot be read", ds_heap_get(heap, fired_handle, NULL) == NULL, 1);
+	vb_check_equals_int("a popped entry cannot be updated", ds_heap_update_priority(heap, fired_handle, 0), GENERIC_ERROR);
+	ds_heap_remove(heap, fired_handle);
+	vb_check_equals_int("the new entry should be left alone", ds_heap_contains(heap, next_handle), 1);
+	vb_check_equals_int("the new entry should still be the top", ds_get_value(int, ds_heap_peek(heap, NULL)), 300);
+	ds_heap_remove(heap, next_handle);
+
+	int unordered = 0;
+	int expected = 9;
+	int element;
+	while (ds_heap_pop_into(heap, &element, NULL) == SUCCESS) {
+		if (element != expected--)
+			unordered++;
+	}
+	vb_check_equals_int("older entries should be popped in order", unordered, 0);
+	vb_check_equals_int("every older entry should be popped", expected, -1);
+
+	delete_ds_heap(heap);
+	return 0;
+}
+
 int test_heap() {
 	ds_heap* min_heap = create_ds_heap(MIN_HEAP, sizeof(int));
 	int rc = run_test_min_heap(min_heap);
 	delete_ds_heap(min_heap);
 
 	ds_heap* max_heap = create_ds_heap(MAX_HEAP, sizeof(int));
-	rc = run_test_max_heap(max_heap);
+	rc |= run_test_max_heap(max_heap);
 	delete_ds_heap(max_heap);
+
+	rc |= run_test_heap_inline();
+	// 4 and 8 pick the best child with SIMD when it is available, 3 does not
+	size_t arities[] = { 2, 3, 4, 8 };
+	for (int i = 0; i < 4; ++i) {
+		rc |= run_test_heap_random(MIN_HEAP, arities[i]);
+		rc |= run_test_heap_random(MAX_HEAP, arities[i]);
+	}
+	rc |= run_test_heap_handles(MIN_HEAP, 2);
+	rc |= run_test_heap_handles(MAX_HEAP, 4);
+	rc |= run_test_heap_handles(MIN_HEAP, 8);
+	rc |= run_test_heap_late_handles();
+	vb_check_equals_int("an arity less than 2 is rejected", create_ds_dary_heap(MIN_HEAP, sizeof(int), 1) == NULL, 1);
 	return rc;
 }
 
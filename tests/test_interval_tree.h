@@ -0,0 +1,130 @@
+/*
+ * @file test_interval_tree.h
+ * @author Valerio Bellizia
+ *
+ * This file contains interval tree specific tests.
+ */
+
+#ifndef test_interval_tree_h
+#define test_interval_tree_h
+
+#include "common_stuff.h"
+#include "vb_test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include <ds/interval_tree.h>
+
+struct interval_walk {
+	int64_t previous_lo;
+	int unordered;
+	int sum;
+};
+
+static void sum_values(const ds_interval* interval, void* value, void* other_args) {
+	struct interval_walk* walk = (struct interval_walk*) other_args;
+	if (interval->lo < walk->previous_lo)
+		walk->unordered++;
+	walk->previous_lo = interval->lo;
+	walk->sum += ds_get_value(int, value);
+}
+
+int test_interval_tree() {
+	ds_interval_tree* tree = create_ds_interval_tree(sizeof(int));
+
+	vb_infoln("test inserting intervals");
+	int v = 1;
+	vb_check_equals_int("insert should succeed", ds_interval_tree_insert(tree, 10, 20, &v), SUCCESS);
+	v = 2;
+	vb_check_equals_int("insert should succeed", ds_interval_tree_insert(tree, 15, 25, &v), SUCCESS);
+	v = 4;
+	vb_check_equals_int("insert should succeed", ds_interval_tree_insert(tree, 30, 40, &v), SUCCESS);
+	v = 8;
+	vb_check_equals_int("insert should succeed", ds_interval_tree_insert(tree, 0, 100, &v), SUCCESS);
+	vb_check_equals_int("an empty interval should be rejected", ds_interval_tree_insert(tree, 20, 10, &v), GENERIC_ERROR);
+	vb_check_equals_int("size should be 4", ds_interval_tree_size(tree), 4);
+	vb_check_equals_int("check a value", ds_get_value(int, ds_interval_tree_get(tree, 15, 25)), 2);
+
+	vb_infoln("test storing the same interval twice");
+	v = 16;
+	vb_check_equals_int("the same interval should be stored again", ds_interval_tree_insert(tree, 10, 20, &v), SUCCESS);
+	vb_check_equals_int("size should be 5", ds_interval_tree_size(tree), 5);
+	vb_check_equals_int("both copies contain 12", ds_interval_tree_stab(tree, 12, NULL, NULL), 3);
+	vb_check_equals_int("get should return the oldest copy", ds_get_value(int, ds_interval_tree_get(tree, 10, 20)), 1);
+	ds_interval_tree_remove(tree, 10, 20);
+	vb_check_equals_int("remove should take one copy", ds_interval_tree_size(tree), 4);
+	vb_check_equals_int("the newest copy should survive", ds_get_value(int, ds_interval_tree_get(tree, 10, 20)), 16);
+	ds_interval_tree_remove(tree, 10, 20);
+	v = 1;
+	ds_interval_tree_insert(tree, 10, 20, &v);
+
+	vb_infoln("test stabbing and overlap queries");
+	struct interval_walk walk = { INT64_MIN, 0, 0 };
+	vb_check_equals_int("three intervals contain 18", ds_interval_tree_stab(tree, 18, sum_values, &walk), 3);
+	vb_check_equals_int("check the stabbed intervals", walk.sum, 1 + 2 + 8);
+	vb_check_equals_int("endpoints should be included", ds_interval_tree_stab(tree, 40, NULL, NULL), 2);
+	vb_check_equals_int("a point out of every interval", ds_interval_tree_stab(tree, 101, NULL, NULL), 0);
+	walk.sum = 0;
+	vb_check_equals_int("three intervals overlap [22, 30]", ds_interval_tree_overlaps(tree, 22, 30, sum_values, &walk), 3);
+	vb_check_equals_int("check the overlapping intervals", walk.sum, 2 + 4 + 8);
+
+	void* value = NULL;
+	const ds_interval* found = ds_interval_tree_find_overlap(tree, 26, 29, &value);
+	vb_check_equals_int("only [0, 100] overlaps [26, 29]", found != NULL && found->lo == 0 && found->hi == 100, 1);
+	vb_check_equals_int("check the value of the found interval", ds_get_value(int, value), 8);
+
+	vb_infoln("test that removals keep the subtree maximum up to date");
+	ds_interval_tree_remove(tree, 0, 100);
+	vb_check_equals_int("nothing should overlap [26, 29] anymore", ds_interval_tree_find_overlap(tree, 26, 29, NULL) == NULL, 1);
+	vb_check_equals_int("nothing should contain 50 anymore", ds_interval_tree_stab(tree, 50, NULL, NULL), 0);
+	delete_ds_interval_tree(tree);
+
+	vb_infoln("test random intervals against a linear scan");
+	tree = create_ds_interval_tree(sizeof(int));
+	int64_t lo[2000];
+	int64_t hi[2000];
+	int stored[2000];
+	srand(44);
+	for (int i = 0; i < 2000; ++i) {
+		lo[i] = rand() % 100000;
+		hi[i] = lo[i] + rand() % 1000;
+		stored[i] = ds_interval_tree_insert(tree, lo[i], hi[i], &i) == SUCCESS;
+	}
+	// one interval every three goes away, so that rotations after removals are checked as well
+	for (int i = 0; i < 2000; i += 3) {
+		if (stored[i])
+			ds_interval_tree_remove(tree, lo[i], hi[i]);
+		stored[i] = 0;
+	}
+
+	int mismatches = 0;
+	int unordered = 0;
+	for (int q = 0; q < 200; ++q) {
+		int64_t qlo = rand() % 101000;
+		int64_t qhi = qlo + rand() % 500;
+		size_t expected = 0;
+		int expected_sum = 0;
+		for (int i = 0; i < 2000; ++i) {
+			if (stored[i] && lo[i] <= qhi && hi[i] >= qlo) {
+				expected++;
+				expected_sum += i;
+			}
+		}
+
+		struct interval_walk w = { INT64_MIN, 0, 0 };
+		if (ds_interval_tree_overlaps(tree, qlo, qhi, sum_values, &w) != expected || w.sum != expected_sum)
+			mismatches++;
+		if ((ds_interval_tree_find_overlap(tree, qlo, qhi, NULL) != NULL) != (expected > 0))
+			mismatches++;
+		unordered += w.unordered;
+	}
+	vb_check_equals_int("queries should match the linear scan", mismatches, 0);
+	vb_check_equals_int("intervals should be visited by lower endpoint", unordered, 0);
+	delete_ds_interval_tree(tree);
+
+	return 0;
+}
+
+#endif
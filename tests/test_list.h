@@ -15,6 +15,7 @@
 #include <stdlib.h>
 
 #include <ds/list.h>
+#include <ds/cmp.h>
 
 void print_list_element(const ds_list_iterator* it) {
 	vb_infoln("%d", ds_list_iterator_get_value(int, it));
@@ -85,6 +86,13 @@ int test_list() {
 	ds_list* l = create_ds_list(int_cmp, sizeof(int));
 	int rc = run_test_list(l);
 	delete_ds_list(l);
+	if (rc != 0)
+		return rc;
+
+	vb_infoln("run the same tests with the library comparison function");
+	l = create_ds_list(ds_cmp_int32, sizeof(int));
+	rc = run_test_list(l);
+	delete_ds_list(l);
 	return rc;
 }
 
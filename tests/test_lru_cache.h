@@ -0,0 +1,112 @@
+/*
+ * @file test_lru_cache.h
+ * @author Valerio Bellizia
+ *
+ * This file contains cache specific tests.
+ */
+
+#ifndef test_lru_cache_h
+#define test_lru_cache_h
+
+#include "common_stuff.h"
+#include "vb_test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <ds/lru_cache.h>
+
+static void count_evictions(const void* key, void* value, void* other_args) {
+	(void) key;
+	(void) value;
+	(*(int*)other_args)++;
+}
+
+int test_lru_cache() {
+	vb_check_equals_int("capacity cannot be 0", create_ds_lru_cache(int_cmp, sizeof(int), sizeof(int), 0, DS_CACHE_LRU) == NULL, 1);
+	ds_lru_cache* cache = create_ds_lru_cache(int_cmp, sizeof(int), sizeof(int), 3, DS_CACHE_LRU);
+	int evicted = 0;
+	ds_lru_cache_set_evict_func(cache, count_evictions, &evicted);
+
+	vb_infoln("test least recently used eviction");
+	for (int i = 1; i <= 3; ++i) {
+		int v = i * 10;
+		ds_lru_cache_put(cache, &i, &v);
+	}
+	int one = 1;
+	int two = 2;
+	int four = 4;
+	int v = 40;
+	vb_check_equals_int("check a value", ds_get_value(int, ds_lru_cache_get(cache, &one)), 10);
+	vb_check_equals_int("put should succeed", ds_lru_cache_put(cache, &four, &v), SUCCESS);
+	vb_check_equals_int("size should be 3", ds_lru_cache_size(cache), 3);
+	vb_check_equals_int("the least recently used key should be evicted", ds_lru_cache_peek(cache, &two) == NULL, 1);
+	vb_check_equals_int("a used key should be kept", ds_lru_cache_peek(cache, &one) != NULL, 1);
+	vb_check_equals_int("the eviction function should be called", evicted, 1);
+
+	vb_infoln("test touch and replace");
+	int three = 3;
+	vb_check_equals_int("touch should find the key", ds_lru_cache_touch(cache, &three), 1);
+	v = 11;
+	ds_lru_cache_put(cache, &one, &v);
+	vb_check_equals_int("the value should be replaced", ds_get_value(int, ds_lru_cache_peek(cache, &one)), 11);
+	vb_check_equals_int("one evict should remove the oldest key", ds_lru_cache_evict(cache), 1);
+	vb_check_equals_int("4 should be the oldest key", ds_lru_cache_peek(cache, &four) == NULL, 1);
+	vb_check_equals_int("remove should succeed", ds_lru_cache_remove(cache, &three), SUCCESS);
+	vb_check_equals_int("size should be 1", ds_lru_cache_size(cache), 1);
+	vb_check_equals_int("the eviction function should be called on remove", evicted, 3);
+
+	vb_infoln("test the counters");
+	ds_lru_cache_get(cache, &one);
+	ds_lru_cache_get(cache, &two);
+	ds_lru_cache_stats stats = ds_lru_cache_get_stats(cache);
+	vb_check_equals_int("check hits", stats.hits, 2);
+	vb_check_equals_int("check misses", stats.misses, 1);
+	vb_check_equals_int("check evictions", stats.evictions, 2);
+	ds_lru_cache_reset_stats(cache);
+	vb_check_equals_int("counters should be reset", ds_lru_cache_get_stats(cache).hits, 0);
+	delete_ds_lru_cache(cache);
+	vb_check_equals_int("the eviction function should be called on delete", evicted, 4);
+
+	vb_infoln("test weighted entries");
+	cache = create_ds_lru_cache(int_cmp, sizeof(int), sizeof(int), 100, DS_CACHE_LRU);
+	vb_check_equals_int("an entry heavier than the cache should be rejected", ds_lru_cache_put_weighted(cache, &one, &v, 101), GENERIC_ERROR);
+	for (int i = 0; i < 10; ++i)
+		ds_lru_cache_put_weighted(cache, &i, &i, 20);
+	vb_check_equals_int("only 5 entries should fit", ds_lru_cache_size(cache), 5);
+	vb_check_equals_int("check the weight", ds_lru_cache_weight(cache), 100);
+	int nine = 9;
+	ds_lru_cache_put_weighted(cache, &nine, &nine, 70);
+	vb_check_equals_int("a heavier entry should evict 3 entries", ds_lru_cache_size(cache), 2);
+	vb_check_equals_int("the heavier entry should be kept", ds_lru_cache_peek(cache, &nine) != NULL, 1);
+	vb_check_equals_int("check the weight after the update", ds_lru_cache_weight(cache), 90);
+	delete_ds_lru_cache(cache);
+
+	vb_infoln("test that a scan does not flush hot entries with SLRU");
+	cache = create_ds_lru_cache(int_cmp, sizeof(int), sizeof(int), 10, DS_CACHE_SLRU);
+	for (int i = 0; i < 5; ++i) {
+		ds_lru_cache_put(cache, &i, &i);
+		ds_lru_cache_get(cache, &i);
+	}
+	for (int i = 100; i < 200; ++i)
+		ds_lru_cache_put(cache, &i, &i);
+	int hot = 0;
+	for (int i = 0; i < 5; ++i)
+		hot += ds_lru_cache_peek(cache, &i) != NULL;
+	vb_check_equals_int("hot entries should survive the scan", hot, 5);
+	vb_check_equals_int("size should be 10", ds_lru_cache_size(cache), 10);
+	int last = 199;
+	vb_check_equals_int("the last scanned entry should be cached", ds_lru_cache_peek(cache, &last) != NULL, 1);
+
+	for (int i = 200; i < 210; ++i) {
+		ds_lru_cache_put(cache, &i, &i);
+		ds_lru_cache_get(cache, &i);
+	}
+	vb_check_equals_int("size should still be 10", ds_lru_cache_size(cache), 10);
+	vb_check_equals_int("the protected segment should be bounded", ds_lru_cache_peek(cache, &last) == NULL, 1);
+	delete_ds_lru_cache(cache);
+
+	return 0;
+}
+
+#endif
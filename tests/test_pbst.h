@@ -0,0 +1,140 @@
+/*
+ * @file test_pbst.h
+ * @author Valerio Bellizia
+ *
+ * This file contains persistent binary tree specific tests.
+ */
+
+#ifndef test_pbst_h
+#define test_pbst_h
+
+#include "common_stuff.h"
+#include "vb_test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include <ds/pbst.h>
+
+#define PBST_TEST_SNAPSHOTS 64
+
+static int pbst_sum(ds_pbst* t) {
+	int sum = 0;
+	for (ds_pbst_iterator it = ds_pbst_first(t); ds_pbst_iterator_is_valid(&it); ds_pbst_iterator_next(&it))
+		sum += ds_pbst_iterator_get_value(int, &it);
+
+	return sum;
+}
+
+struct pbst_reader {
+	ds_pbst* snapshots[PBST_TEST_SNAPSHOTS];
+	atomic_int ready;
+	int errors;
+};
+
+// it walks the snapshots handed over by the writer, then releases them on this thread
+static void* pbst_reader_thread(void* arg) {
+	struct pbst_reader* reader = (struct pbst_reader*) arg;
+	for (int i = 0; i < PBST_TEST_SNAPSHOTS; ++i) {
+		while (atomic_load(&reader->ready) <= i)
+			;
+
+		size_t count = 0;
+		for (ds_pbst_iterator it = ds_pbst_first(reader->snapshots[i]); ds_pbst_iterator_is_valid(&it); ds_pbst_iterator_next(&it))
+			count++;
+		if (count != ds_pbst_size(reader->snapshots[i]))
+			reader->errors++;
+		delete_ds_pbst(reader->snapshots[i]);
+	}
+
+	return NULL;
+}
+
+int test_pbst_threads() {
+	ds_pbst* tree = create_ds_pbst(int_cmp, sizeof(int));
+	struct pbst_reader reader;
+	atomic_init(&reader.ready, 0);
+	reader.errors = 0;
+
+	vb_infoln("test releasing snapshots on a reader thread while the tree changes");
+	pthread_t thread;
+	pthread_create(&thread, NULL, pbst_reader_thread, &reader);
+	for (int i = 0; i < PBST_TEST_SNAPSHOTS; ++i) {
+		for (int j = 0; j < 200; ++j) {
+			int k = (i * 200 + j) * 7919 % 5000;
+			if (ds_pbst_insert(tree, &k) == ELEMENT_ALREADY_EXISTS)
+				ds_pbst_remove(tree, &k);
+		}
+		reader.snapshots[i] = ds_pbst_snapshot(tree);
+		atomic_store(&reader.ready, i + 1);
+	}
+	pthread_join(thread, NULL);
+
+	vb_check_equals_int("every snapshot should be consistent", reader.errors, 0);
+	size_t count = 0;
+	for (ds_pbst_iterator it = ds_pbst_first(tree); ds_pbst_iterator_is_valid(&it); ds_pbst_iterator_next(&it))
+		count++;
+	vb_check_equals_int("the tree should be consistent", count, ds_pbst_size(tree));
+	delete_ds_pbst(tree);
+
+	return 0;
+}
+
+int test_pbst() {
+	ds_pbst* tree = create_ds_pbst(int_cmp, sizeof(int));
+
+	vb_infoln("test inserting elements into the persistent tree");
+	for (int i = 1; i <= 100; ++i)
+		ds_pbst_insert(tree, &i);
+	vb_check_equals_int("size should be 100", ds_pbst_size(tree), 100);
+	vb_check_equals_int("check the sum of the elements", pbst_sum(tree), 5050);
+
+	vb_infoln("test taking a snapshot and changing the tree");
+	ds_pbst* snapshot = ds_pbst_snapshot(tree);
+	vb_check_equals_int("snapshot should be read-only", ds_pbst_is_snapshot(snapshot), 1);
+
+	for (int i = 2; i <= 100; i += 2)
+		ds_pbst_remove(tree, &i);
+	int thousand = 1000;
+	ds_pbst_insert(tree, &thousand);
+
+	int two = 2;
+	vb_check_equals_int("size of the tree after changes", ds_pbst_size(tree), 51);
+	vb_check_equals_int("removed element should not exist in the tree", ds_pbst_search(tree, &two), 0);
+	vb_check_equals_int("check the sum of the tree", pbst_sum(tree), 2500 + 1000);
+	vb_check_equals_int("size of the snapshot should not change", ds_pbst_size(snapshot), 100);
+	vb_check_equals_int("removed element should still exist in the snapshot", ds_pbst_search(snapshot, &two), 1);
+	vb_check_equals_int("inserted element should not exist in the snapshot", ds_pbst_search(snapshot, &thousand), 0);
+	vb_check_equals_int("check the sum of the snapshot", pbst_sum(snapshot), 5050);
+	vb_check_equals_int("snapshot cannot be changed", ds_pbst_insert(snapshot, &thousand), GENERIC_ERROR);
+	vb_check_equals_int("put should insert a new element", ds_pbst_put(tree, &two), SUCCESS);
+	vb_check_equals_int("put should replace an existing element", ds_pbst_put(tree, &thousand), SUCCESS);
+	vb_check_equals_int("size after put", ds_pbst_size(tree), 52);
+	vb_check_equals_int("snapshot cannot be changed by put", ds_pbst_put(snapshot, &two), GENERIC_ERROR);
+	vb_check_equals_int("the snapshot should not see put", pbst_sum(snapshot), 5050);
+	ds_pbst_remove(tree, &two);
+
+	vb_infoln("test cloning the tree");
+	ds_pbst* clone = ds_pbst_clone(snapshot);
+	vb_check_equals_int("clone should be writable", ds_pbst_remove(clone, &two), SUCCESS);
+	vb_check_equals_int("element should not exist in the clone", ds_pbst_search(clone, &two), 0);
+	vb_check_equals_int("element should still exist in the snapshot", ds_pbst_search(snapshot, &two), 1);
+
+	ds_pbst_iterator it = ds_pbst_last(clone);
+	vb_check_equals_int("check the biggest element of the clone", ds_pbst_iterator_get_value(int, &it), 100);
+	ds_pbst_iterator_prev(&it);
+	vb_check_equals_int("check the element before the biggest", ds_pbst_iterator_get_value(int, &it), 99);
+
+	// versions can be released in any order
+	delete_ds_pbst(tree);
+	vb_check_equals_int("check the sum of the snapshot after the tree is released", pbst_sum(snapshot), 5050);
+	delete_ds_pbst(snapshot);
+	vb_check_equals_int("check the minimum of the clone", ds_get_value(int, ds_pbst_min(clone)), 1);
+	delete_ds_pbst(clone);
+
+	return test_pbst_threads();
+}
+
+#endif
@@ -0,0 +1,188 @@
+/*
+ * @file test_rcu_treemap.h
+ * @author Valerio Bellizia
+ *
+ * This file contains RCU treemap specific tests.
+ */
+
+#ifndef test_rcu_treemap_h
+#define test_rcu_treemap_h
+
+#include "common_stuff.h"
+#include "vb_test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include <ds/rcu_treemap.h>
+
+struct rcu_reader_test {
+	ds_rcu_treemap* map;
+	atomic_int* stop;
+	int errors;
+	int reads;
+};
+
+// every version of the map holds <k, 2k> pairs, and its size matches the number of elements
+static void* rcu_reader_thread(void* arg) {
+	struct rcu_reader_test* test = (struct rcu_reader_test*) arg;
+	ds_rcu_treemap_reader* reader = ds_rcu_treemap_register_reader(test->map);
+
+	while (!atomic_load(test->stop)) {
+		ds_rcu_treemap_read_lock(reader);
+
+		size_t count = 0;
+		int previous = -1;
+		for (ds_rcu_treemap_iterator it = ds_rcu_treemap_first(reader); ds_pbst_iterator_is_valid(&it); ds_pbst_iterator_next(&it)) {
+			int k = ds_get_value(int, ds_rcu_treemap_iterator_key(&it));
+			int v = ds_get_value(int, ds_rcu_treemap_iterator_value(test->map, &it));
+			if (v != k * 2 || k <= previous)
+				test->errors++;
+			previous = k;
+			count++;
+		}
+		if (count != ds_rcu_treemap_size(reader))
+			test->errors++;
+
+		ds_rcu_treemap_read_unlock(reader);
+		test->reads++;
+	}
+
+	ds_rcu_treemap_unregister_reader(reader);
+	return NULL;
+}
+
+// the writer keeps replacing the value of a single key, which must never be missing
+static void* rcu_put_reader_thread(void* arg) {
+	struct rcu_reader_test* test = (struct rcu_reader_test*) arg;
+	ds_rcu_treemap_reader* reader = ds_rcu_treemap_register_reader(test->map);
+
+	int key = 7;
+	while (!atomic_load(test->stop)) {
+		ds_rcu_treemap_read_lock(reader);
+		const void* v = ds_rcu_treemap_get(reader, &key);
+		if (v == NULL || ds_get_value(int, v) < 0 || ds_rcu_treemap_size(reader) != 1)
+			test->errors++;
+		ds_rcu_treemap_read_unlock(reader);
+		test->reads++;
+	}
+
+	ds_rcu_treemap_unregister_reader(reader);
+	return NULL;
+}
+
+int test_rcu_treemap() {
+	ds_rcu_treemap* map = create_ds_rcu_treemap(int_cmp, sizeof(int), sizeof(int));
+	ds_rcu_treemap_reader* reader = ds_rcu_treemap_register_reader(map);
+
+	vb_infoln("test inserting and reading elements");
+	for (int i = 0; i < 100; ++i) {
+		int v = i * 2;
+		ds_rcu_treemap_insert(map, &i, &v);
+	}
+
+	int key = 21;
+	ds_rcu_treemap_read_lock(reader);
+	vb_check_equals_int("size should be 100", ds_rcu_treemap_size(reader), 100);
+	vb_check_equals_int("key should exist", ds_rcu_treemap_search(reader, &key), 1);
+	vb_check_equals_int("check the value", ds_get_value(int, ds_rcu_treemap_get(reader, &key)), 42);
+	vb_check_equals_int("duplicate keys should be rejected", ds_rcu_treemap_insert(map, &key, &key), ELEMENT_ALREADY_EXISTS);
+
+	vb_infoln("test that a pinned version does not change");
+	vb_check_equals_int("remove should succeed", ds_rcu_treemap_remove(map, &key), SUCCESS);
+	vb_check_equals_int("key should still exist in the pinned version", ds_rcu_treemap_search(reader, &key), 1);
+	vb_check_equals_int("the pinned version cannot be released", ds_rcu_treemap_reclaim(map) > 0, 1);
+	ds_rcu_treemap_read_unlock(reader);
+
+	ds_rcu_treemap_read_lock(reader);
+	vb_check_equals_int("key should not exist in the new version", ds_rcu_treemap_search(reader, &key), 0);
+	vb_check_equals_int("size should be 99", ds_rcu_treemap_size(reader), 99);
+	ds_rcu_treemap_read_unlock(reader);
+	vb_check_equals_int("replaced versions should be released", ds_rcu_treemap_reclaim(map), 0);
+
+	vb_infoln("test replacing values");
+	int v = 84;
+	vb_check_equals_int("put should insert a new key", ds_rcu_treemap_put(map, &key, &v), SUCCESS);
+	ds_rcu_treemap_read_lock(reader);
+	v = 42;
+	vb_check_equals_int("put should replace the value", ds_rcu_treemap_put(map, &key, &v), SUCCESS);
+	vb_check_equals_int("the pinned version should keep the old value", ds_get_value(int, ds_rcu_treemap_get(reader, &key)), 84);
+	ds_rcu_treemap_read_unlock(reader);
+	ds_rcu_treemap_read_lock(reader);
+	vb_check_equals_int("the new version should have the new value", ds_get_value(int, ds_rcu_treemap_get(reader, &key)), 42);
+	vb_check_equals_int("size should be 100", ds_rcu_treemap_size(reader), 100);
+	ds_rcu_treemap_read_unlock(reader);
+	ds_rcu_treemap_unregister_reader(reader);
+
+	vb_infoln("test concurrent readers while writing");
+	atomic_int stop = 0;
+	struct rcu_reader_test tests[4];
+	pthread_t threads[4];
+	for (int i = 0; i < 4; ++i) {
+		tests[i].map = map;
+		tests[i].stop = &stop;
+		tests[i].errors = 0;
+		tests[i].reads = 0;
+		pthread_create(&threads[i], NULL, rcu_reader_thread, &tests[i]);
+	}
+
+	for (int round = 0; round < 2000; ++round) {
+		int k = (round * 7) % 150;
+		int v = k * 2;
+		if (ds_rcu_treemap_insert(map, &k, &v) == ELEMENT_ALREADY_EXISTS)
+			ds_rcu_treemap_remove(map, &k);
+	}
+
+	atomic_store(&stop, 1);
+	int errors = 0;
+	int reads = 0;
+	for (int i = 0; i < 4; ++i) {
+		pthread_join(threads[i], NULL);
+		errors += tests[i].errors;
+		reads += tests[i].reads;
+	}
+
+	vb_infoln("readers completed %d read-side critical sections", reads);
+	vb_check_equals_int("readers should always see a consistent version", errors, 0);
+	vb_check_equals_int("all replaced versions should be released", ds_rcu_treemap_reclaim(map), 0);
+
+	delete_ds_rcu_treemap(map);
+
+	vb_infoln("test concurrent readers while replacing a value");
+	map = create_ds_rcu_treemap(int_cmp, sizeof(int), sizeof(int));
+	key = 7;
+	v = 0;
+	ds_rcu_treemap_insert(map, &key, &v);
+	atomic_store(&stop, 0);
+	for (int i = 0; i < 4; ++i) {
+		tests[i].map = map;
+		tests[i].errors = 0;
+		tests[i].reads = 0;
+		pthread_create(&threads[i], NULL, rcu_put_reader_thread, &tests[i]);
+	}
+
+	for (v = 1; v <= 2000; ++v)
+		ds_rcu_treemap_put(map, &key, &v);
+
+	atomic_store(&stop, 1);
+	errors = 0;
+	for (int i = 0; i < 4; ++i) {
+		pthread_join(threads[i], NULL);
+		errors += tests[i].errors;
+	}
+	vb_check_equals_int("readers should never miss the key", errors, 0);
+
+	ds_rcu_treemap_reader* last = ds_rcu_treemap_register_reader(map);
+	ds_rcu_treemap_read_lock(last);
+	vb_check_equals_int("the last value should be published", ds_get_value(int, ds_rcu_treemap_get(last, &key)), 2000);
+	ds_rcu_treemap_read_unlock(last);
+	ds_rcu_treemap_unregister_reader(last);
+	vb_check_equals_int("all replaced versions should be released", ds_rcu_treemap_reclaim(map), 0);
+	delete_ds_rcu_treemap(map);
+
+	return 0;
+}
+
+#endif
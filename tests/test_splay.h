@@ -0,0 +1,115 @@
+/*
+ * @file test_splay.h
+ * @author Valerio Bellizia
+ *
+ * This file contains splay tree specific tests. The shape of the tree is not exposed, so
+ * the tests count comparisons: looking for the root takes exactly one.
+ */
+
+#ifndef test_splay_h
+#define test_splay_h
+
+#include "common_stuff.h"
+#include "vb_test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <ds/splay.h>
+
+#define SPLAY_TEST_ELEMENTS 1024
+#define SPLAY_TEST_HOT 16
+#define SPLAY_TEST_LOOKUPS 20000
+
+static size_t splay_comparisons = 0;
+
+static int counting_splay_cmp(const void* e1, const void* e2) {
+	splay_comparisons++;
+	return int_cmp(e1, e2);
+}
+
+static void sum_splay_elements(const void* element, void* func_aux) {
+	*((int*)func_aux) += ds_get_value(int, element);
+}
+
+// it returns the number of comparisons needed to find element
+static size_t splay_lookup_cost(ds_splay* tree, int element) {
+	splay_comparisons = 0;
+	ds_splay_search(tree, &element);
+
+	return splay_comparisons;
+}
+
+int test_splay() {
+	ds_splay* tree = create_ds_splay(counting_splay_cmp, sizeof(int));
+
+	vb_infoln("test inserting elements in order");
+	// every new element becomes the root, so ordered inserts build a path hanging on the left
+	for (int i = 0; i < SPLAY_TEST_ELEMENTS; ++i)
+		ds_splay_insert(tree, &i);
+	vb_check_equals_int("check the size", ds_splay_size(tree), SPLAY_TEST_ELEMENTS);
+	vb_check_equals_int("the last insert should be the root", splay_lookup_cost(tree, SPLAY_TEST_ELEMENTS - 1), 1);
+	vb_check_equals_int("the first insert should be at the bottom of the path", splay_lookup_cost(tree, 0), SPLAY_TEST_ELEMENTS);
+
+	vb_infoln("test that accessed elements move to the root");
+	int hundred = 100;
+	vb_check_equals_int("check if element is extracted properly", ds_get_value(int, ds_splay_get(tree, &hundred)), 100);
+	vb_check_equals_int("an element found by get should be the root", splay_lookup_cost(tree, 100), 1);
+	int missing = SPLAY_TEST_ELEMENTS + 10;
+	vb_check_equals_int("element should not exist", ds_splay_search(tree, &missing), 0);
+	vb_check_equals_int("a failed search should move the last element met to the root", splay_lookup_cost(tree, SPLAY_TEST_ELEMENTS - 1), 1);
+	vb_check_equals_int("a duplicate should not be inserted", ds_splay_insert(tree, &hundred), ELEMENT_ALREADY_EXISTS);
+	vb_check_equals_int("the duplicate should be moved to the root", splay_lookup_cost(tree, 100), 1);
+	int five_hundred = 500;
+	ds_splay_iterator it = ds_splay_lower_bound(tree, &five_hundred);
+	vb_check_equals_int("check lower bound", ds_splay_iterator_get_value(int, &it), 500);
+	vb_check_equals_int("the lower bound should be the root", splay_lookup_cost(tree, 500), 1);
+
+	vb_infoln("test that iterators survive lookups");
+	int expected = 0;
+	for (it = ds_splay_first(tree); ds_splay_iterator_is_valid(&it); ds_splay_iterator_next(&it)) {
+		int current = ds_splay_iterator_get_value(int, &it);
+		if (current != expected)
+			break;
+		// the lookup reshapes the tree under the iterator
+		ds_splay_search(tree, &current);
+		expected++;
+	}
+	vb_check_equals_int("elements should be visited in order", expected, SPLAY_TEST_ELEMENTS);
+
+	vb_infoln("test the depth of hot elements under skewed lookups");
+	srand(35);
+	splay_comparisons = 0;
+	for (int i = 0; i < SPLAY_TEST_LOOKUPS; ++i) {
+		// the hot elements are spread over the whole tree
+		int hot = (rand() % SPLAY_TEST_HOT) * (SPLAY_TEST_ELEMENTS / SPLAY_TEST_HOT);
+		ds_splay_search(tree, &hot);
+	}
+	// a balanced tree of 1024 elements takes about 10 comparisons per lookup, 16 hot elements should take about 4
+	vb_check_equals_int("hot elements should stay close to the root", splay_comparisons < 7 * SPLAY_TEST_LOOKUPS, 1);
+
+	vb_infoln("test sequential access");
+	splay_comparisons = 0;
+	for (int i = 0; i < SPLAY_TEST_ELEMENTS; ++i)
+		ds_splay_search(tree, &i);
+	// accessing every element in order takes O(n) overall, rather than O(n log n)
+	vb_check_equals_int("a sequential scan should take a few comparisons per element", splay_comparisons < 6 * SPLAY_TEST_ELEMENTS, 1);
+
+	vb_infoln("test removing elements");
+	for (int i = 0; i < SPLAY_TEST_ELEMENTS; i += 2)
+		ds_splay_remove(tree, &i);
+	vb_check_equals_int("size after remove", ds_splay_size(tree), SPLAY_TEST_ELEMENTS / 2);
+	vb_check_equals_int("removed element should not exist", ds_splay_search(tree, &hundred), 0);
+	vb_check_equals_int("check minimum", ds_get_value(int, ds_splay_min(tree)), 1);
+	vb_check_equals_int("check maximum", ds_get_value(int, ds_splay_max(tree)), SPLAY_TEST_ELEMENTS - 1);
+
+	int sum = 0;
+	ds_splay_visit(tree, sum_splay_elements, &sum);
+	vb_check_equals_int("check the visit after remove", sum, (SPLAY_TEST_ELEMENTS / 2) * (SPLAY_TEST_ELEMENTS / 2));
+
+	delete_ds_splay(tree);
+
+	return 0;
+}
+
+#endif
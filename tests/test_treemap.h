@@ -0,0 +1,381 @@
+/*
+ * @file test_treemap.h
+ * @author Valerio Bellizia
+ *
+ * This file contains treemap specific tests.
+ */
+
+#ifndef test_treemap_h
+#define test_treemap_h
+
+#include "common_stuff.h"
+#include "vb_test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <ds/treemap.h>
+
+static void add_to_counter(const void* key, void* value, int existed, void* other_args) {
+	int* counter = (int*) value;
+	*counter += existed ? *((int*)other_args) : ds_get_value(int, key);
+}
+
+int test_treemap_upsert() {
+	ds_treemap* map = create_ds_treemap(int_cmp, sizeof(int), sizeof(int));
+
+	vb_infoln("test put");
+	int key = 7;
+	int value = 70;
+	vb_check_equals_int("put should insert a new key", ds_treemap_put(map, &key, &value), SUCCESS);
+	value = 700;
+	vb_check_equals_int("put should overwrite an existing key", ds_treemap_put(map, &key, &value), SUCCESS);
+	vb_check_equals_int("size should be 1", ds_treemap_size(map), 1);
+	vb_check_equals_int("check the overwritten value", ds_get_value(int, ds_treemap_get(map, &key)->value), 700);
+
+	vb_infoln("test get or insert as a counter");
+	for (int i = 0; i < 100; ++i) {
+		int k = i % 10;
+		int* counter = (int*) ds_treemap_get_or_insert(map, &k, NULL);
+		(*counter)++;
+	}
+	int inserted = -1;
+	int three = 3;
+	int* counter = (int*) ds_treemap_get_or_insert(map, &three, &inserted);
+	vb_check_equals_int("key should already exist", inserted, 0);
+	vb_check_equals_int("check the counter", *counter, 10);
+	vb_check_equals_int("check the counter of a key that was already in the map", ds_get_value(int, ds_treemap_get(map, &key)->value), 710);
+	vb_check_equals_int("size should be 10", ds_treemap_size(map), 10);
+
+	vb_infoln("test compute");
+	int hundred = 100;
+	int increment = 5;
+	ds_treemap_compute(map, &hundred, add_to_counter, &increment);
+	vb_check_equals_int("a new key should start from zero", ds_get_value(int, ds_treemap_get(map, &hundred)->value), 100);
+	ds_treemap_compute(map, &hundred, add_to_counter, &increment);
+	vb_check_equals_int("an existing key should be updated", ds_get_value(int, ds_treemap_get(map, &hundred)->value), 105);
+	vb_check_equals_int("size should be 11", ds_treemap_size(map), 11);
+
+	delete_ds_treemap(map);
+
+	return 0;
+}
+
+static int key8_cmp(const void* k1, const void* k2) {
+	return memcmp(k1, k2, 8);
+}
+
+int test_treemap_navigation() {
+	ds_treemap* map = create_ds_treemap(int_cmp, sizeof(int), sizeof(int));
+	for (int i = 10; i <= 100; i += 10)
+		ds_treemap_put(map, &i, &i);
+
+	vb_infoln("test floor, ceiling, higher and lower");
+	int key = 35;
+	int thirty = 30;
+	int five = 5;
+	int hundred = 100;
+	ds_treemap_iterator it = ds_treemap_floor(map, &key);
+	vb_check_equals_int("floor of 35", ds_get_value(int, ds_treemap_iterator_get(&it)->key), 30);
+	it = ds_treemap_floor(map, &thirty);
+	vb_check_equals_int("floor of 30", ds_get_value(int, ds_treemap_iterator_get(&it)->key), 30);
+	it = ds_treemap_floor(map, &five);
+	vb_check_equals_int("floor of 5 should not exist", ds_treemap_iterator_is_valid(&it), 0);
+	it = ds_treemap_ceiling(map, &key);
+	vb_check_equals_int("ceiling of 35", ds_get_value(int, ds_treemap_iterator_get(&it)->key), 40);
+	it = ds_treemap_higher(map, &thirty);
+	vb_check_equals_int("higher of 30", ds_get_value(int, ds_treemap_iterator_get(&it)->key), 40);
+	it = ds_treemap_higher(map, &hundred);
+	vb_check_equals_int("higher of 100 should not exist", ds_treemap_iterator_is_valid(&it), 0);
+	it = ds_treemap_lower(map, &thirty);
+	vb_check_equals_int("lower of 30", ds_get_value(int, ds_treemap_iterator_get(&it)->key), 20);
+	int thousand = 1000;
+	it = ds_treemap_lower(map, &thousand);
+	vb_check_equals_int("lower of 1000", ds_get_value(int, ds_treemap_iterator_get(&it)->key), 100);
+	it = ds_treemap_lower(map, &five);
+	vb_check_equals_int("lower of 5 should not exist", ds_treemap_iterator_is_valid(&it), 0);
+
+	vb_infoln("test ranges");
+	int sum = 0;
+	for (ds_treemap_range range = ds_treemap_range_of(map, &key, &hundred); ds_treemap_range_is_valid(&range); ds_treemap_range_next(&range))
+		sum += ds_get_value(int, ds_treemap_range_get(&range)->value);
+	vb_check_equals_int("sum of the values within [35, 100)", sum, 40 + 50 + 60 + 70 + 80 + 90);
+
+	sum = 0;
+	for (ds_treemap_range range = ds_treemap_range_of(map, &key, &thousand); ds_treemap_range_is_valid(&range); ds_treemap_range_next(&range))
+		sum += ds_get_value(int, ds_treemap_range_get(&range)->value);
+	vb_check_equals_int("sum of the values within [35, 1000)", sum, 40 + 50 + 60 + 70 + 80 + 90 + 100);
+
+	ds_treemap_range empty = ds_treemap_range_of(map, &hundred, &key);
+	vb_check_equals_int("a reversed range should be empty", ds_treemap_range_is_valid(&empty), 0);
+	delete_ds_treemap(map);
+
+	vb_infoln("test prefix scans");
+	map = create_ds_treemap(key8_cmp, 8, sizeof(int));
+	const char* words[] = { "apple", "apricot", "april", "banana", "ap", "b" };
+	for (int i = 0; i < 6; ++i) {
+		char k[8] = { 0 };
+		strncpy(k, words[i], 8);
+		ds_treemap_put(map, k, &i);
+	}
+	int count = 0;
+	for (ds_treemap_range range = ds_treemap_prefix(map, "apr", 3); ds_treemap_range_is_valid(&range); ds_treemap_range_next(&range))
+		count++;
+	vb_check_equals_int("keys starting with apr", count, 2);
+
+	count = 0;
+	for (ds_treemap_range range = ds_treemap_prefix(map, "ap", 2); ds_treemap_range_is_valid(&range); ds_treemap_range_next(&range))
+		count++;
+	vb_check_equals_int("keys starting with ap", count, 4);
+
+	count = 0;
+	for (ds_treemap_range range = ds_treemap_prefix(map, "c", 1); ds_treemap_range_is_valid(&range); ds_treemap_range_next(&range))
+		count++;
+	vb_check_equals_int("keys starting with c", count, 0);
+
+	count = 0;
+	for (ds_treemap_range range = ds_treemap_prefix(map, "", 0); ds_treemap_range_is_valid(&range); ds_treemap_range_next(&range))
+		count++;
+	vb_check_equals_int("every key starts with the empty prefix", count, 6);
+	delete_ds_treemap(map);
+
+	return 0;
+}
+
+int test_treemap_snapshot() {
+	ds_treemap* map = create_ds_treemap(int_cmp, sizeof(int), sizeof(double));
+	for (int i = 0; i < 10000; ++i) {
+		int k = (i * 7919) % 10000;
+		double v = k / 2.0;
+		ds_treemap_insert(map, &k, &v);
+	}
+
+	vb_infoln("test saving and loading a snapshot from a file");
+	FILE* file = tmpfile();
+	int fd = fileno(file);
+	vb_check_equals_int("save should succeed", ds_treemap_save(map, fd), SUCCESS);
+	lseek(fd, 0, SEEK_SET);
+
+	ds_treemap* loaded = ds_treemap_load(fd, int_cmp);
+	vb_check_equals_int("the map should be loaded", loaded != NULL, 1);
+	vb_check_equals_int("check the size", ds_treemap_size(loaded), 10000);
+	int mismatches = 0;
+	for (int k = 0; k < 10000; ++k) {
+		const ds_treemap_entry* entry = ds_treemap_get(loaded, &k);
+		if (entry == NULL || ds_get_value(double, entry->value) != k / 2.0)
+			mismatches++;
+	}
+	vb_check_equals_int("check the entries", mismatches, 0);
+
+	int k = 10000;
+	double v = 1.0;
+	vb_check_equals_int("the loaded map should accept new keys", ds_treemap_insert(loaded, &k, &v), SUCCESS);
+	delete_ds_treemap(loaded);
+	fclose(file);
+
+	vb_infoln("test loading a snapshot from a pipe");
+	ds_treemap* small = create_ds_treemap(int_cmp, sizeof(int), sizeof(int));
+	for (int i = 0; i < 100; ++i) {
+		int value = i * 10;
+		ds_treemap_insert(small, &i, &value);
+	}
+	int fds[2];
+	vb_check_equals_int("pipe should be created", pipe(fds), 0);
+	vb_check_equals_int("save should succeed", ds_treemap_save(small, fds[1]), SUCCESS);
+	close(fds[1]);
+	loaded = ds_treemap_load(fds[0], int_cmp);
+	close(fds[0]);
+	vb_check_equals_int("check the size", ds_treemap_size(loaded), 100);
+	int fifty = 50;
+	vb_check_equals_int("check a value", ds_get_value(int, ds_treemap_get(loaded, &fifty)->value), 500);
+	delete_ds_treemap(loaded);
+
+	vb_infoln("test loading an invalid snapshot");
+	file = tmpfile();
+	fd = fileno(file);
+	ds_treemap_save(small, fd);
+	lseek(fd, 0, SEEK_SET);
+	vb_check_equals_int("write a bad magic", (int) write(fd, "XXXX", 4), 4);
+	lseek(fd, 0, SEEK_SET);
+	vb_check_equals_int("a bad magic should be rejected", ds_treemap_load(fd, int_cmp) == NULL, 1);
+	fclose(file);
+	delete_ds_treemap(small);
+
+	delete_ds_treemap(map);
+
+	return 0;
+}
+
+int test_treemap_multi() {
+	ds_treemap* map = create_ds_treemap_multi(int_cmp, sizeof(int), sizeof(int));
+
+	vb_infoln("test a multimap");
+	for (int i = 0; i < 30; ++i) {
+		int k = i % 3;
+		vb_check_equals_int("entries with the same key should be accepted", ds_treemap_insert(map, &k, &i), SUCCESS);
+	}
+	int one = 1;
+	vb_check_equals_int("size should be 30", ds_treemap_size(map), 30);
+	vb_check_equals_int("check the count of a key", ds_treemap_count(map, &one), 10);
+	vb_check_equals_int("get should return the first entry", ds_get_value(int, ds_treemap_get(map, &one)->value), 1);
+	vb_check_equals_int("put needs unique keys", ds_treemap_put(map, &one, &one), GENERIC_ERROR);
+
+	int expected = 1;
+	int errors = 0;
+	for (ds_treemap_range r = ds_treemap_equal_range(map, &one); ds_treemap_range_is_valid(&r); ds_treemap_range_next(&r)) {
+		if (ds_get_value(int, ds_treemap_range_get(&r)->value) != expected)
+			errors++;
+		expected += 3;
+	}
+	vb_check_equals_int("the equal range should hold the values in insertion order", errors, 0);
+	vb_check_equals_int("the equal range should hold every entry", expected, 31);
+
+	ds_treemap_remove(map, &one);
+	vb_check_equals_int("remove should remove the first entry", ds_get_value(int, ds_treemap_get(map, &one)->value), 4);
+	ds_treemap_remove_all(map, &one);
+	vb_check_equals_int("remove all should remove every entry", ds_treemap_count(map, &one), 0);
+	vb_check_equals_int("size should be 20", ds_treemap_size(map), 20);
+
+	int two = 2;
+	ds_treemap_iterator it = ds_treemap_ceiling(map, &two);
+	ds_treemap_erase(map, &it);
+	vb_check_equals_int("erase should move to the next entry", ds_get_value(int, ds_treemap_iterator_get(&it)->value), 5);
+	vb_check_equals_int("check the count after erase", ds_treemap_count(map, &two), 9);
+
+	vb_infoln("test saving and loading a multimap");
+	FILE* file = tmpfile();
+	int fd = fileno(file);
+	vb_check_equals_int("save should succeed", ds_treemap_save(map, fd), SUCCESS);
+	lseek(fd, 0, SEEK_SET);
+	ds_treemap* loaded = ds_treemap_load(fd, int_cmp);
+	fclose(file);
+	vb_check_equals_int("the multimap should be loaded", loaded != NULL, 1);
+	vb_check_equals_int("check the size", ds_treemap_size(loaded), ds_treemap_size(map));
+	vb_check_equals_int("check the count of a key", ds_treemap_count(loaded, &two), 9);
+
+	errors = 0;
+	ds_treemap_iterator original = ds_treemap_first(map);
+	for (ds_treemap_iterator copy = ds_treemap_first(loaded); ds_treemap_iterator_is_valid(&copy); ds_treemap_iterator_next(&copy), ds_treemap_iterator_next(&original)) {
+		if (ds_get_value(int, ds_treemap_iterator_get(&copy)->value) != ds_get_value(int, ds_treemap_iterator_get(&original)->value))
+			errors++;
+	}
+	vb_check_equals_int("entries should keep their order", errors, 0);
+	vb_check_equals_int("the loaded map should accept duplicates", ds_treemap_insert(loaded, &two, &two), SUCCESS);
+	delete_ds_treemap(loaded);
+
+	delete_ds_treemap(map);
+
+	return 0;
+}
+
+int test_treemap() {
+	ds_treemap* map = create_ds_treemap(int_cmp, sizeof(int), sizeof(int));
+
+	int keys[] = { 50, 30, 90, 10, 70, 20, 80, 60, 40 };
+	int values[] = { 500, 300, 900, 100, 700, 200, 800, 600, 400 };
+	int n = sizeof(keys) / sizeof(int);
+
+	vb_infoln("test inserting elements into the treemap");
+	for (int i = 0; i < n; ++i) {
+		vb_check_equals_int("insert should succeed", ds_treemap_insert(map, &keys[i], &values[i]), SUCCESS);
+	}
+	vb_check_equals_int("size should be 9", ds_treemap_size(map), n);
+
+	// using a key stored somewhere else to be sure that keys are compared by value
+	int key = 70;
+	vb_check_equals_int("key should exist", ds_treemap_search(map, &key), 1);
+	vb_check_equals_int("check the value of the entry", ds_get_value(int, ds_treemap_get(map, &key)->value), 700);
+	vb_check_equals_int("duplicate keys should be rejected", ds_treemap_insert(map, &key, &values[0]), ELEMENT_ALREADY_EXISTS);
+
+	vb_infoln("test iterating over the treemap");
+	int expected = 10;
+	for (ds_treemap_iterator it = ds_treemap_first(map); ds_treemap_iterator_is_valid(&it); ds_treemap_iterator_next(&it)) {
+		const ds_treemap_entry* entry = ds_treemap_iterator_get(&it);
+		vb_check_equals_int("check key order", ds_get_value(int, entry->key), expected);
+		vb_check_equals_int("check value", ds_get_value(int, entry->value), expected * 10);
+		expected += 10;
+	}
+
+	vb_infoln("test rank, select and range counts");
+	int lo = 25;
+	int hi = 70;
+	vb_check_equals_int("rank of 70", ds_treemap_rank(map, &key), 6);
+	vb_check_equals_int("rank of 25", ds_treemap_rank(map, &lo), 2);
+	vb_check_equals_int("select the 4th key", ds_get_value(int, ds_treemap_select(map, 3)->key), 40);
+	vb_check_equals_int("select out of bound", ds_treemap_select(map, 9) == NULL, 1);
+	vb_check_equals_int("count keys within [25, 70)", ds_treemap_count_range(map, &lo, &hi), 4);
+
+	vb_infoln("test that keys and values are owned by the map");
+	int scratch_key = 100;
+	int scratch_value = 1000;
+	ds_treemap_insert(map, &scratch_key, &scratch_value);
+	scratch_key = 110;
+	scratch_value = 0;
+	int hundred = 100;
+	const ds_treemap_entry* owned = ds_treemap_get(map, &hundred);
+	vb_check_equals_int("key should be copied", ds_get_value(int, owned->key), 100);
+	vb_check_equals_int("value should be copied", ds_get_value(int, owned->value), 1000);
+	vb_check_equals_int("the key should be stored in the map", owned->key != (void*)&scratch_key, 1);
+	ds_treemap_remove(map, &hundred);
+
+	vb_infoln("test removing elements");
+	int thirty = 30;
+	vb_check_equals_int("remove should succeed", ds_treemap_remove(map, &thirty), SUCCESS);
+	vb_check_equals_int("key should not exist anymore", ds_treemap_search(map, &thirty), 0);
+	vb_check_equals_int("size should be 8", ds_treemap_size(map), n - 1);
+	vb_check_equals_int("rank of 70 after remove", ds_treemap_rank(map, &key), 5);
+
+	ds_vect* keys_vect = ds_treemap_keys(map);
+	vb_check_equals_int("number of keys", ds_vect_length(keys_vect), n - 1);
+	ds_vect_iterator kit = ds_vect_at(keys_vect, 2);
+	vb_check_equals_int("check the third key", ds_vect_iterator_get_value(int, &kit), 40);
+	delete_ds_vect(keys_vect);
+
+	vb_infoln("test value and entry cursors");
+	ds_vect* values_vect = ds_treemap_values_vect(map, int_cmp);
+	vb_check_equals_int("number of values", ds_vect_length(values_vect), n - 1);
+	kit = ds_vect_at(values_vect, 2);
+	vb_check_equals_int("check the third value", ds_vect_iterator_get_value(int, &kit), 400);
+	int four_hundred = 400;
+	vb_check_equals_int("values should be searchable", ds_vect_exists(values_vect, &four_hundred), 1);
+	delete_ds_vect(values_vect);
+
+	int sum = 0;
+	for (ds_treemap_cursor c = ds_treemap_values(map); ds_treemap_cursor_is_valid(&c); ds_treemap_cursor_next(&c))
+		sum += ds_get_value(int, ds_treemap_cursor_get(&c));
+	vb_check_equals_int("check the sum of the values", sum, 4500 - 300);
+
+	sum = 0;
+	for (ds_treemap_cursor c = ds_treemap_entries(map); ds_treemap_cursor_is_valid(&c); ds_treemap_cursor_next(&c)) {
+		const ds_treemap_entry* entry = (const ds_treemap_entry*) ds_treemap_cursor_get(&c);
+		sum += ds_get_value(int, entry->value) - ds_get_value(int, entry->key);
+	}
+	vb_check_equals_int("check the entries", sum, (4500 - 300) - (450 - 30));
+
+	vb_infoln("test that entries stay valid while other entries are removed");
+	const ds_treemap_entry* seventy = ds_treemap_get(map, &key);
+	for (int i = 0; i < n; ++i) {
+		if (keys[i] != 70)
+			ds_treemap_remove(map, &keys[i]);
+	}
+	vb_check_equals_int("size should be 1", ds_treemap_size(map), 1);
+	vb_check_equals_int("check the key of the remaining entry", ds_get_value(int, seventy->key), 70);
+	vb_check_equals_int("check the value of the remaining entry", ds_get_value(int, seventy->value), 700);
+
+	delete_ds_treemap(map);
+
+	if (test_treemap_upsert() != 0)
+		return 1;
+
+	if (test_treemap_navigation() != 0)
+		return 1;
+
+	if (test_treemap_snapshot() != 0)
+		return 1;
+
+	return test_treemap_multi();
+}
+
+#endif
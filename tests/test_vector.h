@@ -15,6 +15,7 @@
 #include <stdlib.h>
 
 #include <ds/vect.h>
+#include <ds/cmp.h>
 
 void print_vect_element(const ds_vect_iterator* it) {
 	vb_infoln("[%d] -> %d", it->pos, ds_vect_iterator_get_value(int, it));
@@ -88,11 +89,68 @@ int run_test_vector(ds_vect* v) {
 	return 0;
 }
 
+int test_vector_library_comparators() {
+	vb_infoln("test exists with library comparison functions");
+	ds_vect* v = create_ds_vect(ds_cmp_double, sizeof(double));
+	for (int i = 0; i < 10; ++i) {
+		double d = i * 0.5;
+		ds_vect_push_back(v, &d);
+	}
+	double present = 2.5;
+	double missing = 2.25;
+	vb_check_equals_int("double should exist", ds_vect_exists(v, &present), 1);
+	vb_check_equals_int("double should not exist", ds_vect_exists(v, &missing), 0);
+	delete_ds_vect(v);
+
+	v = create_ds_vect(ds_cmp_cstr, sizeof(const char*));
+	const char* words[] = { "alpha", "beta", "gamma" };
+	for (int i = 0; i < 3; ++i)
+		ds_vect_push_back(v, &words[i]);
+	// a different pointer to an equal string
+	char probe[] = "beta";
+	const char* p = probe;
+	const char* other = "delta";
+	vb_check_equals_int("string should exist", ds_vect_exists(v, &p), 1);
+	vb_check_equals_int("string should not exist", ds_vect_exists(v, &other), 0);
+	delete_ds_vect(v);
+
+	return 0;
+}
+
+int test_vector_reserve() {
+	vb_infoln("test reserve");
+	ds_vect* v = create_ds_vect(int_cmp, sizeof(int));
+	vb_check_equals_int("reserve should succeed", ds_vect_reserve(v, 1000), SUCCESS);
+	vb_check_equals_int("reserve should not change the length", ds_vect_length(v), 0);
+	for (int i = 0; i < 1000; ++i)
+		ds_vect_push_back(v, &i);
+	ds_vect_iterator it = ds_vect_last(v);
+	vb_check_equals_int("check the last element", ds_vect_iterator_get_value(int, &it), 999);
+	vb_check_equals_int("a smaller reserve should do nothing", ds_vect_reserve(v, 10), SUCCESS);
+	vb_check_equals_int("length should be 1000", ds_vect_length(v), 1000);
+	delete_ds_vect(v);
+
+	return 0;
+}
+
 int test_vector() {
 	ds_vect* v = create_ds_vect(int_cmp, sizeof(int));
 	int rc = run_test_vector(v);
 	delete_ds_vect(v);
-	return rc;
+	if (rc != 0)
+		return rc;
+
+	vb_infoln("run the same tests with the library comparison function");
+	v = create_ds_vect(ds_cmp_int32, sizeof(int));
+	rc = run_test_vector(v);
+	delete_ds_vect(v);
+	if (rc != 0)
+		return rc;
+
+	if (test_vector_library_comparators() != 0)
+		return 1;
+
+	return test_vector_reserve();
 }
 
 #endif